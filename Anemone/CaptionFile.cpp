@@ -0,0 +1,317 @@
+#include "CaptionFile.h"
+#include <string.h>
+#include "SkUtils.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CAPTION_SCAN_SSE2
+#endif
+
+static inline int CountTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static inline bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+struct CaptionFile::Contents
+{
+	Contents()
+		: fData(nullptr)
+		, fSize(0)
+		, fMapping(nullptr)
+		, fLineCount(0)
+		, fIndexed(false)
+		, fStop(false)
+	{
+	}
+	~Contents() { Unmap(); }
+
+	bool Map(const std::wstring &path);
+	void Unmap();
+	void BuildIndex();
+	void AddLine(size_t start, size_t end);
+	bool GetLine(int index, std::wstring *line) const;
+
+	static const size_t kChunkBits = 12;
+	static const size_t kChunkSize = 1 << kChunkBits;
+
+	const char *fData;
+	size_t fSize;
+	void *fMapping;
+
+	// Offsets live in fixed-size chunks so readers never see a reallocation
+	std::vector<std::unique_ptr<uint32_t[]>> fChunks;
+	std::atomic<size_t> fLineCount;
+	std::atomic<bool> fIndexed;
+	std::atomic<bool> fStop;
+};
+
+CaptionFile::CaptionFile()
+{
+}
+
+CaptionFile::~CaptionFile()
+{
+	Close();
+}
+
+bool CaptionFile::Open(const std::wstring &path)
+{
+	Close();
+	std::shared_ptr<Contents> contents = std::make_shared<Contents>();
+	if (!contents->Map(path))
+		return false;
+
+	// Offsets are 32-bit; caption scripts are nowhere near 4GB
+	if (contents->fSize > UINT32_MAX)
+		return false;
+
+	// A non-blank line takes at least two bytes including its newline,
+	// which bounds the chunk table up front.
+	size_t maxLines = contents->fSize / 2 + 1;
+	contents->fChunks.resize((maxLines + Contents::kChunkSize - 1) / Contents::kChunkSize);
+	fIndexer = std::thread(&Contents::BuildIndex, contents.get());
+	std::atomic_store(&fContents, std::move(contents));
+	return true;
+}
+
+void CaptionFile::Close()
+{
+	// Readers that pinned the old contents keep it mapped until they return
+	std::shared_ptr<Contents> contents = std::atomic_exchange(&fContents, std::shared_ptr<Contents>());
+	if (contents)
+		contents->fStop.store(true, std::memory_order_relaxed);
+	if (fIndexer.joinable())
+		fIndexer.join();
+}
+
+int CaptionFile::GetLineCount() const
+{
+	std::shared_ptr<Contents> contents = Pin();
+	return contents ? (int)contents->fLineCount.load(std::memory_order_acquire) : 0;
+}
+
+bool CaptionFile::IsIndexed() const
+{
+	std::shared_ptr<Contents> contents = Pin();
+	return !contents || contents->fIndexed.load(std::memory_order_acquire);
+}
+
+void CaptionFile::WaitForIndex()
+{
+	if (fIndexer.joinable())
+		fIndexer.join();
+}
+
+bool CaptionFile::GetLine(int index, std::wstring *line) const
+{
+	std::shared_ptr<Contents> contents = Pin();
+	if (!contents)
+	{
+		line->clear();
+		return false;
+	}
+	return contents->GetLine(index, line);
+}
+
+void CaptionFile::Contents::AddLine(size_t start, size_t end)
+{
+	// Skip lines that are empty after trimming
+	size_t i = start;
+	while (i < end && IsBlank(fData[i])) i++;
+	if (i == end) return;
+
+	size_t count = fLineCount.load(std::memory_order_relaxed);
+	std::unique_ptr<uint32_t[]> &chunk = fChunks[count >> kChunkBits];
+	if (!chunk)
+		chunk.reset(new uint32_t[kChunkSize]);
+	chunk[count & (kChunkSize - 1)] = (uint32_t)i;
+	fLineCount.store(count + 1, std::memory_order_release);
+}
+
+void CaptionFile::Contents::BuildIndex()
+{
+	size_t start = 0;
+	if (fSize >= 3 && !memcmp(fData, "\xEF\xBB\xBF", 3))
+		start = 3;
+
+	size_t i = start;
+#ifdef CAPTION_SCAN_SSE2
+	// 16 bytes per step; every newline in the block is handled from the mask
+	const __m128i newline = _mm_set1_epi8('\n');
+	for (; i + 16 <= fSize; i += 16)
+	{
+		if (!((i >> 4) & 0xFFF) && fStop.load(std::memory_order_relaxed))
+			return;
+
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fData + i));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+		while (mask)
+		{
+			size_t end = i + CountTrailingZeros(mask);
+			AddLine(start, end);
+			start = end + 1;
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for (; i < fSize; i++)
+	{
+		if (fData[i] == '\n')
+		{
+			AddLine(start, i);
+			start = i + 1;
+		}
+	}
+	if (start < fSize)
+		AddLine(start, fSize);
+
+	fIndexed.store(true, std::memory_order_release);
+}
+
+bool CaptionFile::Contents::GetLine(int index, std::wstring *line) const
+{
+	line->clear();
+	if (index < 0 || (size_t)index >= fLineCount.load(std::memory_order_acquire))
+		return false;
+
+	const char *p = fData + fChunks[index >> kChunkBits][index & (kChunkSize - 1)];
+	const char *end = static_cast<const char *>(memchr(p, '\n', fData + fSize - p));
+	if (!end) end = fData + fSize;
+	while (end > p && IsBlank(end[-1])) end--;
+
+	while (p < end)
+	{
+		// A malformed sequence costs one U+FFFD per byte, not the rest of the line.
+		SkUnichar c = SkUTF8_NextUnicharWithError(&p, end);
+		if (c < 0)
+		{
+			c = 0xFFFD;
+			p++;
+		}
+		if (sizeof(wchar_t) == 2)
+		{
+			uint16_t utf16[2];
+			size_t n = SkUTF16_FromUnichar(c, utf16);
+			line->append(utf16, utf16 + n);
+		}
+		else
+			line->push_back((wchar_t)c);
+	}
+	return true;
+}
+
+#ifdef _WIN32
+bool CaptionFile::Contents::Map(const std::wstring &path)
+{
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	fSize = (size_t)size.QuadPart;
+	if (!fSize)
+	{
+		CloseHandle(file);
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	fData = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!fData)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	fMapping = mapping;
+	return true;
+}
+
+void CaptionFile::Contents::Unmap()
+{
+	if (fData)
+		UnmapViewOfFile(fData);
+	if (fMapping)
+		CloseHandle(fMapping);
+	fData = nullptr;
+	fMapping = nullptr;
+	fSize = 0;
+}
+#else
+bool CaptionFile::Contents::Map(const std::wstring &path)
+{
+	std::string utf8;
+	for (wchar_t c : path)
+	{
+		char buff[kMaxBytesInUTF8Sequence];
+		utf8.append(buff, SkUTF8_FromUnichar((SkUnichar)c, buff));
+	}
+
+	int fd = open(utf8.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	fSize = (size_t)st.st_size;
+	if (!fSize)
+	{
+		close(fd);
+		return true;
+	}
+
+	void *data = mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		fSize = 0;
+		return false;
+	}
+	madvise(data, fSize, MADV_SEQUENTIAL);
+	fData = static_cast<const char *>(data);
+	return true;
+}
+
+void CaptionFile::Contents::Unmap()
+{
+	if (fData)
+		munmap(const_cast<char *>(fData), fSize);
+	fData = nullptr;
+	fSize = 0;
+}
+#endif
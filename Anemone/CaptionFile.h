@@ -0,0 +1,64 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// Memory-mapped UTF-8 caption file.
+// Open() maps the file and indexes the start offsets of its non-blank lines
+// on a background thread; lines are decoded on demand by GetLine(), so the
+// first lines are readable while the rest of the file is still indexed.
+// Each opened file is one immutable mapping plus its index, which readers
+// pin for the length of a call: Open() and Close() may run while other
+// threads read, and the old mapping goes away with its last reader.
+class CaptionFile
+{
+public:
+	CaptionFile();
+	~CaptionFile();
+
+	// Call Open(), Close() and WaitForIndex() from one thread at a time
+	bool Open(const std::wstring &path);
+	void Close();
+
+	// Number of lines indexed so far; final once IsIndexed() is true
+	int GetLineCount() const;
+	bool IsIndexed() const;
+	// Blocks until every line is indexed
+	void WaitForIndex();
+
+	bool GetLine(int index, std::wstring *line) const;
+
+private:
+	struct Contents;
+
+	std::shared_ptr<Contents> Pin() const { return std::atomic_load(&fContents); }
+
+	// Null while closed. Replaced whole; once published, only the index of
+	// a Contents still changes, growing until the indexer finishes.
+	std::shared_ptr<Contents> fContents;
+	std::thread fIndexer;
+};
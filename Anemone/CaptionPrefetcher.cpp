@@ -0,0 +1,210 @@
+#include "CaptionPrefetcher.h"
+#include <chrono>
+#include "SkOpts.h"
+
+// Lines whose glyphs are warmed between checks for navigation
+static const int kWarmLines = 64;
+// How often warming looks again for lines still being indexed
+static const std::chrono::milliseconds kIndexPoll(50);
+
+uint32_t CaptionPrefetcher::WideHash::operator()(const std::wstring &key) const
+{
+	return SkOpts::hash_fn(key.data(), key.size() * sizeof(wchar_t), 0);
+}
+
+CaptionPrefetcher::CaptionPrefetcher(int lookahead)
+	: fLookahead(lookahead < 1 ? 1 : lookahead)
+	, fRendererConfigId(0)
+	, fInfo(SkImageInfo::MakeUnknown())
+	, fConfigId(0)
+	, fCenter(-1)
+	, fWarmLine(-1)
+	, fWarmId(0)
+	, fWarmStalled(false)
+	, fHasWork(false)
+	, fQuit(false)
+	// Both sides plus the line on screen, with room for one step back
+	, fCache(fLookahead * 4 + 2)
+{
+}
+
+CaptionPrefetcher::~CaptionPrefetcher()
+{
+	Stop();
+}
+
+void CaptionPrefetcher::SetLineSource(LineSource getLine, LinesFinal linesFinal)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	fGetLine = getLine;
+	fLinesFinal = linesFinal;
+}
+
+void CaptionPrefetcher::Start()
+{
+	if (fThread.joinable()) return;
+	fQuit = false;
+	fThread = std::thread(&CaptionPrefetcher::Run, this);
+}
+
+void CaptionPrefetcher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fQuit = true;
+	}
+	fWake.notify_all();
+	if (fThread.joinable())
+		fThread.join();
+}
+
+void CaptionPrefetcher::Configure(const SubtitleStyle &style, const SkImageInfo &info)
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fStyle = style;
+		fInfo = info;
+		fConfigId++;
+		fCache.reset();
+		// Re-render the neighbourhood for the new look; new paints and
+		// sizes make new strikes, so the glyphs need warming again
+		fHasWork = true;
+		fWarmLine = 0;
+		fWarmId++;
+	}
+	fWake.notify_all();
+}
+
+void CaptionPrefetcher::Prefetch(int line)
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fCenter = line;
+		fHasWork = true;
+	}
+	fWake.notify_all();
+}
+
+void CaptionPrefetcher::WarmGlyphs()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fWarmLine = 0;
+		fWarmId++;
+	}
+	fWake.notify_all();
+}
+
+sk_sp<SkImage> CaptionPrefetcher::Find(const std::wstring &text)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	sk_sp<SkImage> *layer = fCache.find(text);
+	return layer ? *layer : nullptr;
+}
+
+void CaptionPrefetcher::Run()
+{
+	std::unique_lock<std::mutex> lock(fMutex);
+	for (;;)
+	{
+		if (fWarmStalled)
+		{
+			// Give the index time to grow, unless navigation comes first
+			fWake.wait_for(lock, kIndexPoll, [this] { return fQuit || fHasWork; });
+			fWarmStalled = false;
+		}
+		fWake.wait(lock, [this] { return fQuit || fHasWork || fWarmLine >= 0; });
+		if (fQuit) break;
+		if (!fHasWork)
+		{
+			// Idle: navigation always goes first
+			WarmNextLines(lock);
+			continue;
+		}
+		fHasWork = false;
+
+		// Nearest lines first: +1, -1, +2, -2, ...
+		// Fetching, decoding, configuring and drawing all happen unlocked, so
+		// Prefetch() from the hook thread never waits on them.
+		int center = fCenter;
+		LineSource getLine = fGetLine;
+		for (int i = 0; i < fLookahead * 2 && !fQuit && !fHasWork; i++)
+		{
+			int line = center + (i & 1 ? -(i / 2 + 1) : i / 2 + 1);
+			if (line < 0 || !getLine) continue;
+
+			lock.unlock();
+			std::wstring text;
+			bool found = getLine(line, &text);
+			lock.lock();
+			if (!found || fCache.find(text)) continue;
+
+			// A Configure() while drawing voids the result
+			uint64_t configId = ConfigureRenderer(lock);
+			lock.unlock();
+			sk_sp<SkImage> layer = fRenderer.RenderTextLayer(text);
+			lock.lock();
+			if (layer && configId == fConfigId && !fCache.find(text))
+				fCache.insert(text, std::move(layer));
+		}
+	}
+}
+
+uint64_t CaptionPrefetcher::ConfigureRenderer(std::unique_lock<std::mutex> &lock)
+{
+	// Resolving the typeface and allocating the layer surfaces take a
+	// while; do them from a copy of the configuration, unlocked
+	while (fRendererConfigId != fConfigId)
+	{
+		uint64_t configId = fConfigId;
+		SubtitleStyle style = fStyle;
+		SkImageInfo info = fInfo;
+		lock.unlock();
+		fRenderer.SetStyle(style);
+		fRenderer.AttachLayers(info);
+		lock.lock();
+		fRendererConfigId = configId;
+	}
+	return fRendererConfigId;
+}
+
+void CaptionPrefetcher::WarmNextLines(std::unique_lock<std::mutex> &lock)
+{
+	int start = fWarmLine;
+	uint64_t warmId = fWarmId;
+	LineSource getLine = fGetLine;
+	LinesFinal linesFinal = fLinesFinal;
+	lock.unlock();
+
+	// Asked first: a line indexed after a failed fetch must not end warming
+	bool final = !linesFinal || linesFinal();
+	std::wstring text, line;
+	int end = start;
+	while (end < start + kWarmLines && getLine && getLine(end, &line))
+	{
+		text += line;
+		end++;
+	}
+	bool stalled = false;
+	if (end < start + kWarmLines)
+	{
+		// Past the last line, or the last one indexed so far
+		if (final)
+			end = -1;
+		else
+			stalled = true;
+	}
+
+	lock.lock();
+	if (warmId != fWarmId)
+		return;
+	ConfigureRenderer(lock);
+	lock.unlock();
+	fRenderer.PrewarmGlyphs(text);
+	lock.lock();
+	if (warmId == fWarmId)
+	{
+		fWarmLine = end;
+		fWarmStalled = stalled;
+	}
+}
@@ -0,0 +1,100 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "SkImage.h"
+#include "SkImageInfo.h"
+#include "SkLRUCache.h"
+#include "SubtitleRenderer.h"
+
+// Renders the text layers of the caption lines around the current one on a
+// worker thread, so stepping to a neighbouring line only composites. When
+// idle, the worker also pre-rasterizes the glyphs of the whole file.
+// The worker draws with its own SubtitleRenderer, configured like the one
+// on screen; Configure() must follow every style or size change of that
+// renderer and drops everything rendered for the old configuration.
+class CaptionPrefetcher
+{
+public:
+	typedef std::function<bool(int line, std::wstring *text)> LineSource;
+	// Whether a line |LineSource| fails on is past the last one, rather
+	// than not indexed yet
+	typedef std::function<bool()> LinesFinal;
+
+	// |lookahead| lines are prefetched on each side of the current one
+	explicit CaptionPrefetcher(int lookahead = 3);
+	~CaptionPrefetcher();
+
+	void SetLineSource(LineSource getLine, LinesFinal linesFinal = nullptr);
+	void Start();
+	void Stop();
+
+	void Configure(const SubtitleStyle &style, const SkImageInfo &info);
+	// Called on every navigation, -1 before the first line
+	void Prefetch(int line);
+	// Warms the glyphs of every line from the top; call after loading a file
+	void WarmGlyphs();
+
+	// Layer of |text| for the current configuration, or null
+	sk_sp<SkImage> Find(const std::wstring &text);
+
+private:
+	struct WideHash
+	{
+		uint32_t operator()(const std::wstring &key) const;
+	};
+
+	void Run();
+	// Brings fRenderer up to the current configuration with |lock| released
+	// meanwhile; returns the configuration id it drew with
+	uint64_t ConfigureRenderer(std::unique_lock<std::mutex> &lock);
+	void WarmNextLines(std::unique_lock<std::mutex> &lock);
+
+	int fLookahead;
+	LineSource fGetLine;
+	LinesFinal fLinesFinal;
+
+	// Owned by the worker, which reads and writes them unlocked; configured
+	// from fStyle/fInfo when fConfigId moves
+	SubtitleRenderer fRenderer;
+	uint64_t fRendererConfigId;
+
+	SubtitleStyle fStyle;
+	SkImageInfo fInfo;
+	uint64_t fConfigId;
+	int fCenter;
+	int fWarmLine;            // next line to warm glyphs for, -1 when done
+	uint64_t fWarmId;         // moves whenever warming restarts
+	bool fWarmStalled;        // fWarmLine is not indexed yet
+	bool fHasWork;
+	bool fQuit;
+	SkLRUCache<std::wstring, sk_sp<SkImage>, WideHash> fCache;
+
+	std::mutex fMutex;
+	std::condition_variable fWake;
+	std::thread fThread;
+};
@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "ClipboardSource.h"
+
+#define WM_CLIPBOARD_CHANGED (WM_APP + 1)
+
+static const wchar_t kListenerClass[] = L"AnemoneClipboardListener";
+
+// Attempts to open a clipboard another process is still writing
+static const int kOpenRetries = 10;
+static const DWORD kOpenRetryMs = 5;
+
+static LRESULT CALLBACK ListenerProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+	// WM_CLIPBOARDUPDATE is sent, so GetMessage never returns it;
+	// repost it for the loop in Next()
+	if (message == WM_CLIPBOARDUPDATE)
+	{
+		PostMessage(hWnd, WM_CLIPBOARD_CHANGED, 0, 0);
+		return 0;
+	}
+	return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+ClipboardSource::ClipboardSource()
+	: fWnd(NULL)
+	, fThreadId(0)
+	, fClosed(false)
+{
+}
+
+ClipboardSource::~ClipboardSource()
+{
+	Close();
+}
+
+bool ClipboardSource::Listen()
+{
+	WNDCLASSEXW wcex = { sizeof(wcex) };
+	wcex.lpfnWndProc = ListenerProc;
+	wcex.hInstance = GetModuleHandle(NULL);
+	wcex.lpszClassName = kListenerClass;
+	RegisterClassExW(&wcex);	// fails harmlessly once registered
+
+	fWnd = CreateWindowExW(0, kListenerClass, NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, wcex.hInstance, NULL);
+	if (!fWnd) return false;
+	if (!AddClipboardFormatListener(fWnd))
+	{
+		DestroyWindow(fWnd);
+		fWnd = NULL;
+		return false;
+	}
+
+	// The window gave this thread a message queue, so Close() can post to it
+	fThreadId = GetCurrentThreadId();
+	return true;
+}
+
+void ClipboardSource::Unlisten()
+{
+	if (!fWnd) return;
+	RemoveClipboardFormatListener(fWnd);
+	DestroyWindow(fWnd);
+	fWnd = NULL;
+}
+
+bool ClipboardSource::Next(std::wstring *text)
+{
+	if (!fWnd && !Listen())
+		return false;
+
+	MSG msg;
+	while (!fClosed && GetMessage(&msg, NULL, 0, 0) > 0)
+	{
+		if (msg.message == WM_CLIPBOARD_CHANGED && msg.hwnd == fWnd)
+		{
+			if (ReadText(text))
+				return true;
+			continue;
+		}
+		DispatchMessage(&msg);
+	}
+
+	Unlisten();
+	return false;
+}
+
+void ClipboardSource::Close()
+{
+	fClosed = true;
+	DWORD threadId = fThreadId;
+	if (threadId)
+		PostThreadMessage(threadId, WM_QUIT, 0, 0);
+}
+
+bool ClipboardSource::ReadText(std::wstring *text)
+{
+	if (!IsClipboardFormatAvailable(CF_UNICODETEXT))
+		return false;
+
+	int tries = 0;
+	while (!OpenClipboard(fWnd))
+	{
+		if (++tries == kOpenRetries) return false;
+		Sleep(kOpenRetryMs);
+	}
+
+	bool read = false;
+	HANDLE hData = GetClipboardData(CF_UNICODETEXT);
+	if (hData)
+	{
+		const wchar_t *data = (const wchar_t *)GlobalLock(hData);
+		if (data)
+		{
+			text->assign(data);
+			GlobalUnlock(hData);
+			read = true;
+		}
+	}
+	CloseClipboard();
+	return read;
+}
@@ -0,0 +1,46 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <atomic>
+#include "TextSource.h"
+
+// Clipboard text as a TextSource.
+// The listener window is created by the first Next() call, on the thread
+// that pulls from the source, so the clipboard is never read on the UI thread.
+class ClipboardSource : public TextSource
+{
+public:
+	ClipboardSource();
+	~ClipboardSource() override;
+
+	bool Next(std::wstring *text) override;
+	void Close() override;
+
+private:
+	bool Listen();
+	void Unlisten();
+	bool ReadText(std::wstring *text);
+
+	HWND fWnd;
+	std::atomic<DWORD> fThreadId;
+	std::atomic<bool> fClosed;
+};
@@ -1,37 +1,219 @@
-#include "stdafx.h"
 #include "ConfigManager.h"
+#include <errno.h>
+#include <stdio.h>
 
+#ifndef _WIN32
+#include <wchar.h>
+#include "SkUtils.h"
+#endif
 
-ConfigManager::ConfigManager()
+#define ANEMONE_CONFIG_CHECK(name, type, def, lo, hi) \
+	static_assert(sizeof(type) == sizeof(uint32_t), #name " must fit a 4-byte slot");
+ANEMONE_CONFIG_KEYS(ANEMONE_CONFIG_CHECK)
+#undef ANEMONE_CONFIG_CHECK
+
+static const uint32_t kConfigMagic = 0x46434E41; // "ANCF"
+static const uint32_t kConfigVersion = 1;
+
+struct ConfigHeader
+{
+	uint32_t fMagic;
+	uint32_t fVersion;
+	uint32_t fCount;
+};
+
+struct ConfigRecord
+{
+	uint32_t fId;
+	uint32_t fValue;
+};
+
+static void GetDefaults(uint32_t (&values)[Config::kCount])
+{
+#define ANEMONE_CONFIG_DEFAULT(name, type, def, lo, hi) \
+	{ \
+		type value = Config::name::Default(); \
+		memcpy(&values[Config::k##name##_Id], &value, sizeof(value)); \
+	}
+	ANEMONE_CONFIG_KEYS(ANEMONE_CONFIG_DEFAULT)
+#undef ANEMONE_CONFIG_DEFAULT
+}
+
+// Clamps the raw bits of key |id|, as Set does for a typed value
+static uint32_t ClampBits(uint32_t id, uint32_t bits)
 {
+	switch (id)
+	{
+#define ANEMONE_CONFIG_CLAMP(name, type, def, lo, hi) \
+	case Config::k##name##_Id: \
+	{ \
+		type value; \
+		memcpy(&value, &bits, sizeof(value)); \
+		value = Config::Clamp<Config::name>(value); \
+		memcpy(&bits, &value, sizeof(value)); \
+		break; \
+	}
+	ANEMONE_CONFIG_KEYS(ANEMONE_CONFIG_CLAMP)
+#undef ANEMONE_CONFIG_CLAMP
+	}
+	return bits;
 }
 
+static FILE *OpenFile(const std::wstring &path, const wchar_t *mode)
+{
+	FILE *fp = nullptr;
+#ifdef _WIN32
+	if (errno_t err = _wfopen_s(&fp, path.c_str(), mode))
+	{
+		errno = err;
+		return nullptr;
+	}
+#else
+	std::string utf8, narrowMode(mode, mode + wcslen(mode));
+	for (wchar_t c : path)
+	{
+		char buff[kMaxBytesInUTF8Sequence];
+		utf8.append(buff, SkUTF8_FromUnichar((SkUnichar)c, buff));
+	}
+	fp = fopen(utf8.c_str(), narrowMode.c_str());
+#endif
+	return fp;
+}
+
+ConfigManager::ConfigManager()
+	: fNextHandle(0)
+{
+	GetDefaults(fValues);
+}
 
 ConfigManager::~ConfigManager()
 {
 }
 
-void ConfigManager::Load()
+void ConfigManager::Reset()
+{
+	uint32_t values[Config::kCount];
+	GetDefaults(values);
+	Assign(values);
+}
+
+bool ConfigManager::Load(const std::wstring &path)
+{
+	FILE *fp = OpenFile(path, L"rb");
+	if (!fp)
+		return false;
+
+	std::vector<uint8_t> data;
+	uint8_t chunk[4096];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+		data.insert(data.end(), chunk, chunk + read);
+	fclose(fp);
+
+	return Deserialize(data.data(), data.size());
+}
+
+bool ConfigManager::LoadOrCreate(const std::wstring &path)
+{
+	FILE *fp = OpenFile(path, L"rb");
+	if (fp)
+	{
+		fclose(fp);
+		return Load(path);
+	}
+	// Anything but a missing file, a locked one say, is not ours to replace
+	if (errno != ENOENT)
+		return false;
+	return Save(path);
+}
+
+bool ConfigManager::Save(const std::wstring &path) const
 {
+	std::vector<uint8_t> data;
+	Serialize(&data);
 
+	FILE *fp = OpenFile(path, L"wb");
+	if (!fp)
+		return false;
+	bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	return fclose(fp) == 0 && ok;
 }
 
-void ConfigManager::operator[](std::string field)
+bool ConfigManager::Deserialize(const void *data, size_t size)
 {
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	ConfigHeader header;
+	if (size < sizeof(header)) return false;
+	memcpy(&header, bytes, sizeof(header));
+	if (header.fMagic != kConfigMagic || header.fVersion != kConfigVersion)
+		return false;
+	if (header.fCount > (size - sizeof(header)) / sizeof(ConfigRecord))
+		return false;
+
+	uint32_t values[Config::kCount];
+	memcpy(values, fValues, sizeof(values));
+	const uint8_t *p = bytes + sizeof(header);
+	for (uint32_t i = 0; i < header.fCount; i++, p += sizeof(ConfigRecord))
+	{
+		ConfigRecord record;
+		memcpy(&record, p, sizeof(record));
+		if (record.fId < Config::kCount)
+			values[record.fId] = ClampBits(record.fId, record.fValue);
+	}
+	Assign(values);
+	return true;
+}
+
+void ConfigManager::Serialize(std::vector<uint8_t> *out) const
+{
+	ConfigHeader header = { kConfigMagic, kConfigVersion, Config::kCount };
+	out->resize(sizeof(header) + Config::kCount * sizeof(ConfigRecord));
+
+	uint8_t *p = out->data();
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	for (uint32_t i = 0; i < Config::kCount; i++, p += sizeof(ConfigRecord))
+	{
+		ConfigRecord record = { i, fValues[i] };
+		memcpy(p, &record, sizeof(record));
+	}
 }
 
-proxy& proxy::operator=(std::string val)
+int ConfigManager::AddListener(Listener listener)
 {
-	_t.data[_key] = val;
-	return *this;
+	fListeners.emplace_back(fNextHandle, std::move(listener));
+	return fNextHandle++;
 }
 
-proxy::operator std::string() const
+void ConfigManager::RemoveListener(int handle)
 {
-	return _t.data[_key];
+	for (auto it = fListeners.begin(); it != fListeners.end(); ++it)
+	{
+		if (it->first == handle)
+		{
+			fListeners.erase(it);
+			return;
+		}
+	}
 }
 
-std::string proxy::data()
+void ConfigManager::Assign(const uint32_t (&values)[Config::kCount])
 {
-	return _t.data[_key];
-}
\ No newline at end of file
+	Config::Mask changed = 0;
+	for (int i = 0; i < Config::kCount; i++)
+	{
+		if (fValues[i] != values[i])
+		{
+			fValues[i] = values[i];
+			changed |= Config::Mask(1) << i;
+		}
+	}
+	if (changed)
+		Notify(changed);
+}
+
+void ConfigManager::Notify(Config::Mask changed)
+{
+	for (auto &listener : fListeners)
+		listener.second(changed);
+}
@@ -1,35 +1,126 @@
 #pragma once
-#include <unordered_map>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
 #include <vector>
-struct testy; // forward declaration
 
-class proxy
+// X(Name, Type, Default, Min, Max)
+// Keys are serialized by position, so only ever append to this list.
+// Values outside [Min, Max] are clamped, NaN falls back to Default.
+#define ANEMONE_CONFIG_KEYS(X) \
+	X(TextSize,      float,    36.0f,        4.0f, 300.0f)        \
+	X(LineSpacing,   float,    5.0f,         0.0f, 200.0f)        \
+	X(LineBreak,     float,    18.0f,        0.0f, 1000.0f)       \
+	X(Padding,       float,    10.0f,        0.0f, 200.0f)        \
+	X(ShadowPadding, float,    15.0f,        0.0f, 200.0f)        \
+	X(OuterStroke,   float,    14.0f,        1.0f, 100.0f)        \
+	X(InnerStroke,   float,    8.0f,         1.0f, 100.0f)        \
+	X(ShadowRadius,  float,    6.0f,         0.0f, 100.0f)        \
+	X(ShadowColor,   uint32_t, 0x7FA0A0A0u,  0u,   0xFFFFFFFFu)   \
+	X(OuterColor,    uint32_t, 0xFFD6FFFBu,  0u,   0xFFFFFFFFu)   \
+	X(InnerColor,    uint32_t, 0xFF2EC4B6u,  0u,   0xFFFFFFFFu)   \
+	X(FillColor,     uint32_t, 0xFFFFFFFFu,  0u,   0xFFFFFFFFu)   \
+	X(ClipDebounce,  float,    150.0f,       0.0f, 5000.0f)       /* ms */ \
+	X(StrikeArchive, uint32_t, 1u,           0u,   1u)            /* bool */
+
+namespace Config
 {
-private:
-	testy & _t;
-	std::string _key;
-public:
-	proxy(testy& t, std::string key) : _t(t), _key(key) {}
-	proxy& operator=(std::string val);
-	operator std::string() const;
-	std::string data();
-};
+	enum Id
+	{
+#define ANEMONE_CONFIG_ID(name, type, def, lo, hi) k##name##_Id,
+		ANEMONE_CONFIG_KEYS(ANEMONE_CONFIG_ID)
+#undef ANEMONE_CONFIG_ID
+		kCount
+	};
 
-struct testy {
-	std::unordered_map<std::string, std::string> data;
-	std::string operator[] (std::string key) const { return data.find(key)->second; }
-	proxy operator[](std::string key) { return proxy(*this, key); }
-};
+	// One tag type per key, e.g. CfgMgr.Get<Config::TextSize>()
+#define ANEMONE_CONFIG_TAG(name, type, def, lo, hi) \
+	struct name \
+	{ \
+		typedef type Type; \
+		enum { kId = k##name##_Id }; \
+		static Type Default() { return def; } \
+		static Type Min() { return lo; } \
+		static Type Max() { return hi; } \
+	};
+	ANEMONE_CONFIG_KEYS(ANEMONE_CONFIG_TAG)
+#undef ANEMONE_CONFIG_TAG
 
+	// Bit set of changed keys passed to listeners
+	typedef uint32_t Mask;
+	static_assert(kCount <= 32, "Config::Mask holds one bit per key");
 
+	template <typename Key>
+	inline Mask MaskOf() { return Mask(1) << Key::kId; }
+
+	template <typename Key, typename Next, typename... Rest>
+	inline Mask MaskOf() { return MaskOf<Key>() | MaskOf<Next, Rest...>(); }
+
+	template <typename Key>
+	inline typename Key::Type Clamp(typename Key::Type value)
+	{
+		if (value != value) return Key::Default();
+		return std::min(std::max(value, Key::Min()), Key::Max());
+	}
+}
+
+// Typed settings store. Every value is a 4-byte slot indexed by its key,
+// so reads on the paint path are a load with no lookup or allocation.
+// Not thread-safe; use it from the UI thread.
 class ConfigManager
 {
 public:
-	std::unordered_map<std::string, std::string> data;
+	typedef std::function<void(Config::Mask changed)> Listener;
+
 	ConfigManager();
 	~ConfigManager();
-	void Load();
-	void operator[](std::string field);
-	
-};
 
+	template <typename Key>
+	typename Key::Type Get() const
+	{
+		typename Key::Type value;
+		memcpy(&value, &fValues[Key::kId], sizeof(value));
+		return value;
+	}
+
+	template <typename Key>
+	void Set(typename Key::Type value)
+	{
+		value = Config::Clamp<Key>(value);
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		if (fValues[Key::kId] == bits) return;
+		fValues[Key::kId] = bits;
+		Notify(Config::MaskOf<Key>());
+	}
+
+	void Reset();
+
+	// Binary snapshot: a header followed by (id, value) records.
+	// Unknown ids are skipped, missing ones keep their current value,
+	// out-of-range ones are clamped.
+	bool Load(const std::wstring &path);
+	bool Save(const std::wstring &path) const;
+	// Loads |path|, or writes the current values there when no file exists
+	// yet. A file that exists but does not load, from a newer build or
+	// damaged, is left as it is rather than replaced by the defaults.
+	bool LoadOrCreate(const std::wstring &path);
+	bool Deserialize(const void *data, size_t size);
+	void Serialize(std::vector<uint8_t> *out) const;
+
+	// Listeners run synchronously, once per Set/Load/Reset that changed
+	// anything, with the bits of the keys that changed.
+	int AddListener(Listener listener);
+	void RemoveListener(int handle);
+
+private:
+	void Assign(const uint32_t (&values)[Config::kCount]);
+	void Notify(Config::Mask changed);
+
+	uint32_t fValues[Config::kCount];
+	std::vector<std::pair<int, Listener>> fListeners;
+	int fNextHandle;
+};
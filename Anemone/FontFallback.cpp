@@ -0,0 +1,65 @@
+#include "FontFallback.h"
+#include <string.h>
+
+static bool Covers(const sk_sp<SkTypeface> &typeface, SkUnichar c)
+{
+	SkGlyphID glyph = 0;
+	typeface->charsToGlyphs(&c, SkTypeface::kUTF32_Encoding, &glyph, 1);
+	return glyph != 0;
+}
+
+FontFallback::FontFallback(sk_sp<SkFontMgr> mgr, sk_sp<SkTypeface> primary)
+	: fMgr(std::move(mgr))
+{
+	fTypefaces.push_back(primary ? std::move(primary) : SkTypeface::MakeDefault());
+}
+
+int FontFallback::Resolve(SkUnichar c)
+{
+	if (c < 0 || c > 0x10FFFF) return 0;
+
+	std::unique_ptr<uint8_t[]> &page = fPages[c >> kPageBits];
+	if (!page)
+	{
+		page.reset(new uint8_t[kPageSize]);
+		memset(page.get(), 0, kPageSize);
+	}
+
+	uint8_t &entry = page[c & (kPageSize - 1)];
+	if (!entry)
+		entry = (uint8_t)(Lookup(c) + 1);
+	return entry - 1;
+}
+
+int FontFallback::Lookup(SkUnichar c)
+{
+	// Controls and spaces go with their neighbours on the primary typeface
+	if (c < 0x20 || c == ' ')
+		return 0;
+
+	// Typefaces already in use cover most of a script after its first query
+	for (int i = 0; i < (int)fTypefaces.size(); i++)
+	{
+		if (Covers(fTypefaces[i], c))
+			return i;
+	}
+
+	if (!fMgr || (int)fTypefaces.size() >= kMaxTypefaces)
+		return 0;
+	sk_sp<SkTypeface> match(fMgr->matchFamilyStyleCharacter(
+		nullptr, fTypefaces[0]->fontStyle(), nullptr, 0, c));
+	if (!match || !Covers(match, c))
+		return 0;
+	return FindOrAdd(std::move(match));
+}
+
+int FontFallback::FindOrAdd(sk_sp<SkTypeface> typeface)
+{
+	for (int i = 0; i < (int)fTypefaces.size(); i++)
+	{
+		if (SkTypeface::Equal(fTypefaces[i].get(), typeface.get()))
+			return i;
+	}
+	fTypefaces.push_back(std::move(typeface));
+	return (int)fTypefaces.size() - 1;
+}
@@ -0,0 +1,61 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "SkFontMgr.h"
+#include "SkFontStyle.h"
+#include "SkTypeface.h"
+#include "SkTypes.h"
+
+// Picks a typeface for every codepoint: the primary one when it has the
+// glyph, otherwise a fallback found earlier or, as a last resort, one the
+// font manager matches for the character. Decisions are memoized in a
+// two-level table of one byte per codepoint, allocated 256 codepoints at a
+// time, so each script costs at most one SkFontMgr query per character.
+// Not thread-safe; every renderer owns its own.
+class FontFallback
+{
+public:
+	FontFallback(sk_sp<SkFontMgr> mgr, sk_sp<SkTypeface> primary);
+
+	// Index of the typeface to draw |c| with; 0 is the primary typeface.
+	// Characters nobody covers stay on the primary one.
+	int Resolve(SkUnichar c);
+	const sk_sp<SkTypeface> &Typeface(int index) const { return fTypefaces[index]; }
+	int Count() const { return (int)fTypefaces.size(); }
+
+private:
+	static const int kPageBits = 8;
+	static const int kPageSize = 1 << kPageBits;
+	static const int kPageCount = (0x10FFFF >> kPageBits) + 1;
+	// Entries hold index + 1, 0 is unresolved
+	static const int kMaxTypefaces = 255;
+
+	int Lookup(SkUnichar c);
+	int FindOrAdd(sk_sp<SkTypeface> typeface);
+
+	sk_sp<SkFontMgr> fMgr;
+	std::vector<sk_sp<SkTypeface>> fTypefaces;
+	std::unique_ptr<uint8_t[]> fPages[kPageCount];
+};
@@ -0,0 +1,137 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+
+// Full-range fade durations, same as the old busy-wait draw thread
+static const float kFadeInMs = 200.0f;
+static const float kFadeOutMs = 500.0f;
+
+FrameScheduler::FrameScheduler(int fps)
+	: fPeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / std::max(fps, 1))
+	, fClockAnchored(false)
+	, fOpacity(0.0f)
+	, fShownOpacity(-1)
+	, fHover(false)
+	, fDirty(true)
+	, fQuit(false)
+{
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	Stop();
+}
+
+void FrameScheduler::SetFrameCallback(FrameCallback onFrame)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	fOnFrame = onFrame;
+}
+
+void FrameScheduler::Start()
+{
+	if (fThread.joinable()) return;
+	fQuit = false;
+	fThread = std::thread(&FrameScheduler::Run, this);
+}
+
+void FrameScheduler::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fQuit = true;
+	}
+	fWake.notify_all();
+	if (fThread.joinable())
+		fThread.join();
+}
+
+void FrameScheduler::SetHover(bool hover)
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		if (fHover == hover) return;
+		fHover = hover;
+	}
+	fWake.notify_all();
+}
+
+void FrameScheduler::Invalidate()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		if (fDirty) return;
+		fDirty = true;
+	}
+	fWake.notify_all();
+}
+
+int FrameScheduler::Opacity() const
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	return (int)fOpacity;
+}
+
+bool FrameScheduler::HasWork() const
+{
+	return fDirty || (fHover ? fOpacity < 255.0f : fOpacity > 1.0f);
+}
+
+bool FrameScheduler::Tick(Clock::time_point now)
+{
+	FrameCallback onFrame;
+	int opacity;
+	bool animating;
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+
+		// The first tick of a fade only anchors the clock
+		float elapsed = 0.0f;
+		if (fClockAnchored)
+			elapsed = std::chrono::duration<float, std::milli>(now - fLastTick).count();
+		fLastTick = now;
+
+		if (fHover && fOpacity < 255.0f)
+			fOpacity = std::min(255.0f, fOpacity + elapsed * 256.0f / kFadeInMs);
+		else if (!fHover && fOpacity > 1.0f)
+			fOpacity = std::max(1.0f, fOpacity - elapsed * 256.0f / kFadeOutMs);
+
+		animating = fHover ? fOpacity < 255.0f : fOpacity > 1.0f;
+		fClockAnchored = animating;
+
+		opacity = (int)fOpacity;
+		if (!fDirty && opacity == fShownOpacity)
+			return animating;
+
+		fDirty = false;
+		fShownOpacity = opacity;
+		onFrame = fOnFrame;
+	}
+
+	if (onFrame)
+		onFrame(opacity);
+	return animating;
+}
+
+void FrameScheduler::Run()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(fMutex);
+			fWake.wait(lock, [this] { return fQuit || HasWork(); });
+			if (fQuit) break;
+
+			// At most one frame per period; anything arriving meanwhile is
+			// folded into this frame.
+			fWake.wait_until(lock, fNextFrame, [this] { return fQuit; });
+			if (fQuit) break;
+		}
+
+		Clock::time_point now = Clock::now();
+		Tick(now);
+
+		fNextFrame += fPeriod;
+		if (fNextFrame < now)
+			fNextFrame = now + fPeriod;
+	}
+}
@@ -0,0 +1,74 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Drives the guide fade-in/out at a fixed frame rate.
+// The worker sleeps until a deadline or a wake-up, invalidations arriving
+// within one frame are coalesced, and the frame callback only fires when
+// the visible opacity changed or a repaint was requested.
+class FrameScheduler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::function<void(int opacity)> FrameCallback;
+
+	explicit FrameScheduler(int fps = 60);
+	~FrameScheduler();
+
+	void SetFrameCallback(FrameCallback onFrame);
+	void Start();
+	void Stop();
+
+	void SetHover(bool hover);
+	void Invalidate();
+
+	// Advances the animation to |now| and emits a frame if needed.
+	// Returns true while a fade is still running. Start() calls this from
+	// the worker thread; without Start() it can be driven by a virtual clock.
+	bool Tick(Clock::time_point now);
+	int Opacity() const;
+
+private:
+	void Run();
+	bool HasWork() const;
+
+	Clock::duration fPeriod;
+	Clock::time_point fNextFrame;
+	Clock::time_point fLastTick;
+	bool fClockAnchored;
+
+	float fOpacity;
+	int fShownOpacity;
+	bool fHover;
+	bool fDirty;
+	bool fQuit;
+
+	FrameCallback fOnFrame;
+	mutable std::mutex fMutex;
+	std::condition_variable fWake;
+	std::thread fThread;
+};
@@ -11,17 +11,27 @@
 #include "SkColorFilter.h"
 #include "SkBlurMask.h"
 #include "DisplayParams.h"
+#include "PresentBuffer.h"
+#include "SubtitleRenderer.h"
+#include "CaptionPrefetcher.h"
 
 namespace Graphics
 {
 	void Init();
+	// Saves the glyph strikes for the next run; call once drawing has stopped
+	void Shutdown();
 	auto GetGraphicsFromContext();
 	void SwapBuffer(HWND hWnd, int fWidth, int fHeight);
 	void CreateContext(HWND hWnd, int fWidth, int fHeight);
 	void Resize(HWND hWnd, int fWidth, int fHeight);
 
 	void PaintLoop(HWND hWnd);
-	void DrawSysMenu(HWND hWnd, SkBitmap &bitmap);
+
+	// Caption mode: pre-renders the lines around |line| after each step and
+	// warms the glyphs of the whole file in the background
+	void StartPrefetch();
+	void StopPrefetch();
+	void Prefetch(int line);
 
 	bool IsCursorInMinimize(HWND hWnd);
 	bool IsCursorInClose(HWND hWnd);
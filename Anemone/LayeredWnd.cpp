@@ -4,6 +4,10 @@
 #include "resource.h"
 #include "Graphics.h"
 #include "SettingDlg.h"
+#include "FrameScheduler.h"
+#include "TextIngest.h"
+#include "ClipboardSource.h"
+#include "TranslationPipeline.h"
 
 namespace LayeredWnd
 {
@@ -16,20 +20,34 @@ namespace LayeredWnd
 	HHOOK m_hKeyboardHook;
 
 	HANDLE m_hMHThread;
-	HANDLE m_hDrawThread;
 	HANDLE m_hKHThread;
+	unsigned m_nKHThreadID;
+
+	FrameScheduler m_FrameScheduler;
+	std::unique_ptr<TextIngest> m_ClipIngest;
+	std::unique_ptr<TranslationPipeline> m_Translation;
 
 	int m_nMode;
 
+	// Called from the keyboard hook thread. Publishing never waits on the
+	// renderer; the frame scheduler picks the change up on its next frame.
+	void PublishCaptionLine(int line)
+	{
+		std::wstring text;
+		captionFile.GetLine(line, &text);
+		subtitleState.Publish(text, line);
+		m_FrameScheduler.Invalidate();
+		Graphics::Prefetch(line);
+	}
+
 	LRESULT CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	{
 		switch (message)
 		{
 		case WM_CREATE:
 		{
-			strBuff = L" ʹ ..";
-			vecBuff.clear();
-			n_selLine = -1;
+			captionFile.Close();
+			subtitleState.Publish(L" ʹ ..", -1);
 
 			m_nMode = reinterpret_cast<int>(((LPCREATESTRUCT)lParam)->lpCreateParams);
 			
@@ -74,64 +92,50 @@ namespace LayeredWnd
 
 			if (m_hMHThread == 0) MessageBox(0, L"MenuThread Error\n", 0, 0);
 
-			m_hDrawThread = (HANDLE)_beginthreadex(NULL, 0, [](void *args) -> unsigned int {
-				HWND hWnd = (HWND)args;
-				int wait = 0;
-				std::chrono::system_clock::time_point a = std::chrono::system_clock::now();
-				std::chrono::system_clock::time_point b = std::chrono::system_clock::now();
-				int old_opacity;
-				while (IsWindow(hWnd))
-				{
-					a = std::chrono::system_clock::now();
-					old_opacity = guide_opacity;
-					if (mouse_evt && guide_opacity == 255)
-					{
-						Sleep(10);
-					}
-					else if (mouse_evt)
-					{
-						while (guide_opacity < 255)
-						{
-							if (!mouse_evt) break;
-
-							b = std::chrono::system_clock::now();
-							std::chrono::duration<double, std::milli> elapsed_time = b - a;
-							if (!elapsed_time.count()) break;
+			m_FrameScheduler.SetFrameCallback([hWnd](int opacity) {
+				guide_opacity = opacity;
+				// Asynchronous, so the scheduler never waits on the UI thread
+				SendNotifyMessage(hWnd, WM_PAINT, 0, 0);
+			});
+			m_FrameScheduler.Start();
 
-							float pre_progressed = (float)old_opacity / 256;
-							float progress = ((float)elapsed_time.count() / 200.0f) + pre_progressed;
-
-							if (256 * progress > 256) guide_opacity = 255;
-							else if ((int)(256 * progress) == 0) continue;
-							else guide_opacity = (int)(256 * progress);
-							SendMessage(hWnd, WM_PAINT, 0, 0);
-						}
-					}
-					else if (guide_opacity != 1)
-					{
-						while (guide_opacity > 1)
-						{
-							if (mouse_evt) break;
-
-							b = std::chrono::system_clock::now();
-							std::chrono::duration<double, std::milli> elapsed_time = b - a;
-							if (!elapsed_time.count()) break;
-
-							float pre_progressed = 1 - ((float)old_opacity / 256);
-							float progress = 1 - ((float)elapsed_time.count() / 500.0f) - pre_progressed;
-
-							if (256 * progress < 1) guide_opacity = 1;
-							else if ((int)(256 * progress) == 0) continue;
-							else guide_opacity = (int)(256 * progress);
-							SendMessage(hWnd, WM_PAINT, 0, 0);
-						}
-					}
-					else Sleep(10);
-				}
-				return 0;
-			}, (void *)hWnd, 0, (unsigned*)&dwThreadID);
+			if (m_nMode == ID_TRANSMODE)
+			{
+				// Phrase table next to the executable until a real engine is plugged in
+				WCHAR szDictPath[MAX_PATH];
+				GetModuleFileName(NULL, szDictPath, MAX_PATH);
+				std::wstring dictPath = szDictPath;
+				dictPath = dictPath.substr(0, dictPath.find_last_of(L"\\/") + 1) + L"anemone.dict";
+
+				std::unique_ptr<DictionaryTranslator> translator(new DictionaryTranslator());
+				translator->Load(dictPath);
+				m_Translation.reset(new TranslationPipeline(std::move(translator)));
+				// The source shows until its translation arrives; a cached one shows at once
+				m_Translation->SetSourceCallback([](const std::wstring &source) {
+					subtitleState.Publish(source, -1);
+				});
+				m_Translation->SetResultCallback([](const std::wstring &source, const std::wstring &translation) {
+					subtitleState.Publish(translation, -1);
+					m_FrameScheduler.Invalidate();
+				});
+				m_Translation->Start();
+			}
 
-			if (m_hDrawThread == 0) MessageBox(0, L"DrawThread Error\n", 0, 0);
+			if (m_nMode == ID_CLIPMODE || m_nMode == ID_TRANSMODE)
+			{
+				// Clipboard bursts are settled off the UI thread; only the final text is published
+				std::chrono::duration<float, std::milli> debounce(CfgMgr.Get<Config::ClipDebounce>());
+				m_ClipIngest.reset(new TextIngest(std::unique_ptr<TextSource>(new ClipboardSource()),
+					std::chrono::duration_cast<TextIngest::Clock::duration>(debounce)));
+				m_ClipIngest->SetPublishCallback([](const std::wstring &text) {
+					if (m_Translation)
+						m_Translation->Submit(text);
+					else
+						subtitleState.Publish(text, -1);
+					m_FrameScheduler.Invalidate();
+				});
+				m_ClipIngest->Start();
+			}
 
 			m_hKHThread = (HANDLE)_beginthreadex(NULL, 0, [](void* pData) -> unsigned int {
 				static HWND m_hWnd;
@@ -150,18 +154,18 @@ namespace LayeredWnd
 							{
 								if (m_nMode == ID_CAPTIONMODE)
 								{
-									if (!n_selLine) break;
-									strBuff = vecBuff[--n_selLine];
-									SendMessage(m_hWnd, WM_PAINT, 0, 0);
+									int line = subtitleState.Read()->fLine - 1;
+									if (line < 0) break;
+									PublishCaptionLine(line);
 								}
 							}
 							else if (pHookKey->vkCode == VK_NUMPAD3)
 							{
 								if (m_nMode == ID_CAPTIONMODE)
 								{
-									if (n_selLine + 1 == vecBuff.size()) break;
-									strBuff = vecBuff[++n_selLine];
-									SendMessage(m_hWnd, WM_PAINT, 0, 0);
+									int line = subtitleState.Read()->fLine + 1;
+									if (line >= captionFile.GetLineCount()) break;
+									PublishCaptionLine(line);
 								}
 							}
 							break;
@@ -182,7 +186,7 @@ namespace LayeredWnd
 					}
 				}
 				return (int)msg.wParam;
-			}, (void *)hWnd, 0, (unsigned*)&dwThreadID);
+			}, (void *)hWnd, 0, &m_nKHThreadID);
 
 			if (m_hKHThread == 0) MessageBox(0, L"m_hHotkeyThread Error\n", 0, 0);
 
@@ -207,29 +211,17 @@ namespace LayeredWnd
 
 				if (GetOpenFileName(&ofn) == TRUE)
 				{
-					FILE *fp;
-					if (_wfopen_s(&fp, ofn.lpstrFile, L"rt,ccs=UTF-8") != 0)
+					// Lines are indexed in the background and decoded on demand
+					if (!captionFile.Open(ofn.lpstrFile))
 					{
 						MessageBox(0, L"   ", 0, 0);
 						return false;
 					}
 					std::wstring filename = ofn.lpstrFile;
-					WCHAR buff[2048];
-					std::wstring str;
-					while (fgetws(buff, 2048, fp))
-					{
-						str = buff;
-						str.erase(0, str.find_first_not_of(' '));
-						str.erase(str.find_last_not_of(' ') + 1);
-						if (!str.length()) continue;
-						vecBuff.push_back(str);
-					}
-					
-					if (vecBuff.size())
-					{
-						strBuff = L" оϴ >> " + filename;
-						n_selLine = -1;
-					}
+					subtitleState.Publish(L" оϴ >> " + filename, -1);
+					m_FrameScheduler.Invalidate();
+					Graphics::StartPrefetch();
+					Graphics::Prefetch(-1);
 				}
 			}
 			break;
@@ -304,6 +296,7 @@ namespace LayeredWnd
 		{
 			mouse_evt = true;
 			latest_evt = message;
+			m_FrameScheduler.SetHover(true);
 
 			POINT pt;
 			RECT rc;
@@ -349,8 +342,29 @@ namespace LayeredWnd
 			UnhookWindowsHookEx(m_hMouseHook);
 			UnhookWindowsHookEx(m_hKeyboardHook);
 			TerminateThread(m_hMHThread, 0);
-			TerminateThread(m_hDrawThread, 0);
-			TerminateThread(m_hKHThread, 0);
+			if (m_ClipIngest)
+			{
+				m_ClipIngest->Stop();
+				m_ClipIngest.reset();
+			}
+			if (m_Translation)
+			{
+				m_Translation->Stop();
+				m_Translation.reset();
+			}
+			m_FrameScheduler.Stop();
+			// The hook thread publishes caption lines under the state and prefetcher
+			// locks, so it has to leave its message loop before those are torn down
+			if (m_hKHThread)
+			{
+				while (!PostThreadMessage(m_nKHThreadID, WM_QUIT, 0, 0) &&
+					WaitForSingleObject(m_hKHThread, 10) == WAIT_TIMEOUT);
+				WaitForSingleObject(m_hKHThread, INFINITE);
+				CloseHandle(m_hKHThread);
+				m_hKHThread = NULL;
+			}
+			Graphics::StopPrefetch();
+			Graphics::Shutdown();
 			m_hMouseHook = NULL;
 			m_hKeyboardHook = NULL;
 			PostQuitMessage(0);
@@ -365,12 +379,16 @@ namespace LayeredWnd
 			mouseEvent.dwFlags = TME_LEAVE;
 			mouseEvent.hwndTrack = hWnd;
 			TrackMouseEvent(&mouseEvent);
-			return OnPaint(hWnd);
+			m_FrameScheduler.SetHover(true);
+			m_FrameScheduler.Invalidate();
+			return 0;
 		case WM_MOUSELEAVE:
 			if (latest_evt == WM_NCHITTEST && message == WM_MOUSELEAVE) return 0;
 			latest_evt = message;
 			mouse_evt = false;
-			return OnPaint(hWnd);
+			m_FrameScheduler.SetHover(false);
+			m_FrameScheduler.Invalidate();
+			return 0;
 		case WM_MOVING:
 		case WM_SIZING:
 		{
@@ -0,0 +1,71 @@
+#include "PresentBuffer.h"
+#include "SkMalloc.h"
+
+PresentBuffer::PresentBuffer()
+	: fBack(0)
+{
+}
+
+PresentBuffer::~PresentBuffer()
+{
+	// Backends release their storage in their own destructors
+	SkASSERT(!fSurfaces[0]);
+}
+
+bool PresentBuffer::Resize(const SkImageInfo &info)
+{
+	if (info == fInfo && fSurfaces[0])
+		return true;
+
+	Release();
+	if (info.isEmpty())
+		return false;
+
+	fInfo = info;
+	for (int i = 0; i < kBufferCount; i++)
+	{
+		void *pixels = AllocPixels(i, info);
+		if (pixels)
+			fSurfaces[i] = SkSurface::MakeRasterDirect(info, pixels, RowBytes());
+		if (!fSurfaces[i])
+		{
+			Release();
+			return false;
+		}
+	}
+	return true;
+}
+
+void PresentBuffer::Release()
+{
+	for (int i = 0; i < kBufferCount; i++)
+	{
+		fSurfaces[i].reset();
+		FreePixels(i);
+	}
+	fInfo = SkImageInfo();
+	fBack = 0;
+}
+
+MemoryPresentBuffer::MemoryPresentBuffer()
+{
+	for (int i = 0; i < kBufferCount; i++)
+		fPixels[i] = nullptr;
+}
+
+MemoryPresentBuffer::~MemoryPresentBuffer()
+{
+	Release();
+}
+
+void *MemoryPresentBuffer::AllocPixels(int index, const SkImageInfo &info)
+{
+	fPixels[index] = sk_malloc_canfail(info.computeMinByteSize());
+	return fPixels[index];
+}
+
+void MemoryPresentBuffer::FreePixels(int index)
+{
+	sk_free(fPixels[index]);
+	fPixels[index] = nullptr;
+}
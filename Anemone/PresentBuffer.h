@@ -0,0 +1,75 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include "SkImageInfo.h"
+#include "SkSurface.h"
+
+// Long-lived, double-buffered pixels the renderer draws into directly.
+// Storage comes from the backend and is only reallocated by Resize() when
+// the size or format actually changes; the SkSurfaces wrapping it persist
+// across frames.
+class PresentBuffer
+{
+public:
+	static const int kBufferCount = 2;
+
+	PresentBuffer();
+	virtual ~PresentBuffer();
+
+	bool Resize(const SkImageInfo &info);
+	void Release();
+
+	void Swap() { fBack = (fBack + 1) % kBufferCount; }
+	int GetBackIndex() const { return fBack; }
+	int GetFrontIndex() const { return (fBack + kBufferCount - 1) % kBufferCount; }
+	SkSurface *GetBackSurface() const { return fSurfaces[fBack].get(); }
+
+	const SkImageInfo &Info() const { return fInfo; }
+	size_t RowBytes() const { return fInfo.minRowBytes(); }
+
+protected:
+	// Returns storage for buffer |index| laid out as |info| with RowBytes()
+	virtual void *AllocPixels(int index, const SkImageInfo &info) = 0;
+	virtual void FreePixels(int index) = 0;
+
+private:
+	SkImageInfo fInfo;
+	sk_sp<SkSurface> fSurfaces[kBufferCount];
+	int fBack;
+};
+
+// Plain heap-backed buffers, usable wherever there is no window system.
+class MemoryPresentBuffer : public PresentBuffer
+{
+public:
+	MemoryPresentBuffer();
+	~MemoryPresentBuffer() override;
+
+	const void *GetPixels(int index) const { return fPixels[index]; }
+
+protected:
+	void *AllocPixels(int index, const SkImageInfo &info) override;
+	void FreePixels(int index) override;
+
+private:
+	void *fPixels[kBufferCount];
+};
@@ -0,0 +1,84 @@
+#include "SubtitleLayout.h"
+#include "FontFallback.h"
+#include "SkUtils.h"
+
+SubtitleLayout::SubtitleLayout()
+	: fValid(false)
+{
+}
+
+void SubtitleLayout::Decode(const std::wstring &text, std::vector<SkUnichar> *chars)
+{
+	// wchar_t is UTF-16 on Windows and UTF-32 elsewhere
+	if (sizeof(wchar_t) == 2)
+	{
+		const uint16_t *src = reinterpret_cast<const uint16_t *>(text.c_str());
+		const uint16_t *end = src + text.length();
+		while (src < end)
+			chars->push_back(SkUTF16_NextUnichar(&src, end));
+	}
+	else
+	{
+		for (wchar_t c : text)
+			chars->push_back((SkUnichar)c);
+	}
+}
+
+void SubtitleLayout::Build(const std::wstring &text, const SkPaint &paint, SkScalar maxWidth,
+	FontFallback *fallback)
+{
+	fChars.clear();
+	fLines.clear();
+	Decode(text, &fChars);
+
+	int count = (int)fChars.size();
+	fGlyphs.resize(count);
+	fAdvances.resize(count);
+	fFonts.assign(count, 0);
+	if (fallback)
+	{
+		for (int i = 0; i < count; i++)
+			fFonts[i] = (uint8_t)fallback->Resolve(fChars[i]);
+	}
+
+	// Shape each run of characters that share a typeface
+	SkPaint measure(paint);
+	for (int start = 0, end; start < count; start = end)
+	{
+		for (end = start + 1; end < count && fFonts[end] == fFonts[start]; end++) {}
+		if (fallback)
+			measure.setTypeface(fallback->Typeface(fFonts[start]));
+
+		int n = end - start;
+		measure.setTextEncoding(SkPaint::kUTF32_TextEncoding);
+		measure.textToGlyphs(&fChars[start], n * sizeof(SkUnichar), &fGlyphs[start]);
+		measure.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+		measure.getTextWidths(&fGlyphs[start], n * sizeof(SkGlyphID), &fAdvances[start]);
+	}
+
+	// Greedy per-character wrapping in a single pass: leading spaces are
+	// dropped, '\n' forces a break and a line holds at least one glyph.
+	Line line = { 0, 0, 0 };
+	for (int i = 0; i < count; i++)
+	{
+		SkUnichar c = fChars[i];
+		if (!line.fCount && c == ' ') continue;
+		if (c == '\n')
+		{
+			fLines.push_back(line);
+			line = { 0, 0, 0 };
+			continue;
+		}
+		if (line.fCount && line.fWidth + fAdvances[i] > maxWidth)
+		{
+			fLines.push_back(line);
+			line = { 0, 0, 0 };
+			if (c == ' ') continue;
+		}
+		if (!line.fCount) line.fStart = i;
+		line.fCount++;
+		line.fWidth += fAdvances[i];
+	}
+	fLines.push_back(line);
+	fValid = true;
+}
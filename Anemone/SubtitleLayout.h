@@ -0,0 +1,66 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <string>
+#include <vector>
+#include "SkPaint.h"
+#include "SkTypes.h"
+
+class FontFallback;
+
+// Line-broken glyph layout of a subtitle string.
+// Built once per text/width/font change, then reused by every paint pass.
+class SubtitleLayout
+{
+public:
+	struct Line
+	{
+		int fStart;       // first glyph index
+		int fCount;       // number of glyphs
+		SkScalar fWidth;
+	};
+
+	SubtitleLayout();
+
+	// With |fallback|, characters missing from the paint's typeface are
+	// shaped with the fallback typeface that covers them, see Fonts().
+	void Build(const std::wstring &text, const SkPaint &paint, SkScalar maxWidth,
+		FontFallback *fallback = nullptr);
+	void Invalidate() { fValid = false; }
+	// Appends the code points of |text|
+	static void Decode(const std::wstring &text, std::vector<SkUnichar> *chars);
+	bool IsValid() const { return fValid; }
+
+	const std::vector<Line> &Lines() const { return fLines; }
+	const SkGlyphID *Glyphs() const { return fGlyphs.data(); }
+	const SkScalar *Advances() const { return fAdvances.data(); }
+	// FontFallback index of every glyph, 0 for the paint's own typeface
+	const uint8_t *Fonts() const { return fFonts.data(); }
+
+private:
+	bool fValid;
+	std::vector<SkUnichar> fChars;
+	std::vector<SkGlyphID> fGlyphs;
+	std::vector<SkScalar> fAdvances;
+	std::vector<uint8_t> fFonts;
+	std::vector<Line> fLines;
+};
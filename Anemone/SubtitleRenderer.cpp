@@ -0,0 +1,515 @@
+#include "SubtitleRenderer.h"
+#include <algorithm>
+#include <stdio.h>
+#include "SkBlurMask.h"
+#include "SkColorSpace.h"
+#include "SkFontMgr.h"
+#include "SkMaskFilter.h"
+#include "SkPaint.h"
+#include "SkRRect.h"
+#include "SkStrikeCache.h"
+#include "SkTextBlob.h"
+
+SubtitleRenderer::SubtitleRenderer()
+	: fWidth(0)
+	, fHeight(0)
+	, fBuffer(nullptr)
+	, fFullDamage(true)
+	, fTextChanged(true)
+{
+	fDamage.setEmpty();
+	fPrevDamage.setEmpty();
+	fRedraw.setEmpty();
+	// Renderers live in globals; typefaces are resolved by the first
+	// SetStyle or Attach, after SkGraphics::Init
+}
+
+SubtitleRenderer::~SubtitleRenderer()
+{
+}
+
+void SubtitleRenderer::ResolveTypeface()
+{
+	if (fFallback) return;
+	// Resolve the typeface once (U+AC00, first Hangul syllable)
+	sk_sp<SkFontMgr> mgr(SkFontMgr::RefDefault());
+	fTypeface.reset(
+		mgr->matchFamilyStyleCharacter(
+			nullptr, SkFontStyle(), nullptr, 0, 0xAC00));
+	// Characters it lacks (kana, hanzi, symbols...) go to fallback typefaces
+	fFallback.reset(new FontFallback(mgr, fTypeface));
+	BuildPaints();
+}
+
+bool SubtitleRenderer::Attach(PresentBuffer *buffer)
+{
+	ResolveTypeface();
+	SkSurface *surface = buffer ? buffer->GetBackSurface() : nullptr;
+	int width = surface ? surface->width() : 0;
+	int height = surface ? surface->height() : 0;
+	if (buffer == fBuffer && width == fWidth && height == fHeight)
+		return surface != nullptr;
+
+	fBuffer = surface ? buffer : nullptr;
+	if (width != fWidth)
+		fLayout.Invalidate();
+	fWidth = width;
+	fHeight = height;
+
+	// Layers are re-rasterized and both buffers fully redrawn on the next Render
+	fFullDamage = true;
+	fPrevDamage = SkIRect::MakeWH(fWidth, fHeight);
+	CreateLayers(fBuffer ? fBuffer->Info() : SkImageInfo::MakeUnknown());
+	return fBuffer != nullptr;
+}
+
+void SubtitleRenderer::AttachLayers(const SkImageInfo &info)
+{
+	ResolveTypeface();
+	fBuffer = nullptr;
+	if (info.width() != fWidth)
+		fLayout.Invalidate();
+	fWidth = info.width();
+	fHeight = info.height();
+	CreateLayers(info);
+}
+
+void SubtitleRenderer::CreateLayers(const SkImageInfo &info)
+{
+	for (sk_sp<SkImage> &chrome : fChromeImages)
+		chrome.reset();
+	fTextImage.reset();
+	fChromeLayer.reset();
+	fTextLayer.reset();
+	if (info.isEmpty()) return;
+
+	SkIRect text = GetTextRect().roundOut();
+	fChromeLayer = SkSurface::MakeRaster(info.makeWH(fWidth, fHeight));
+	fTextLayer = SkSurface::MakeRaster(info.makeWH(text.width(), text.height()));
+}
+
+void SubtitleRenderer::SetText(const std::wstring &text, sk_sp<SkImage> layer)
+{
+	if (text == fText) return;
+	fText = text;
+	fLayout.Invalidate();
+	// Without a layer the text is rasterized by the next Render
+	fTextImage = std::move(layer);
+	fTextChanged = true;
+}
+
+sk_sp<SkImage> SubtitleRenderer::RenderTextLayer(const std::wstring &text)
+{
+	SetText(text);
+	if (!fTextImage)
+		RasterizeText();
+	return fTextImage;
+}
+
+void SubtitleRenderer::PrewarmGlyphs(const std::wstring &text)
+{
+	std::vector<SkUnichar> chars;
+	SubtitleLayout::Decode(text, &chars);
+	std::sort(chars.begin(), chars.end());
+	chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+
+	// Group by the typeface each character is drawn with
+	std::vector<std::vector<SkUnichar>> byFont;
+	for (SkUnichar c : chars)
+	{
+		if (c < 0x20) continue;
+		int font = fFallback->Resolve(c);
+		if (font >= (int)byFont.size())
+			byFont.resize(font + 1);
+		byFont[font].push_back(c);
+	}
+
+	// Match the strikes RasterizeText draws from: the text layer's device,
+	// translated only
+	const SkSurfaceProps *props = fTextLayer ? &fTextLayer->props() : nullptr;
+	SkColorSpace *colorSpace = fTextLayer ? fTextLayer->getCanvas()->imageInfo().colorSpace() : nullptr;
+	SkScalerContextFlags flags = colorSpace && colorSpace->gammaIsLinear()
+		? SkScalerContextFlags::kBoostContrast
+		: SkScalerContextFlags::kFakeGammaAndBoostContrast;
+
+	for (int font = 0; font < (int)byFont.size(); font++)
+	{
+		const std::vector<SkUnichar> &run = byFont[font];
+		if (run.empty()) continue;
+		for (const SkPaint &pass : fTextPaints)
+		{
+			SkPaint paint(pass);
+			paint.setTypeface(fFallback->Typeface(font));
+			paint.setTextEncoding(SkPaint::kUTF32_TextEncoding);
+			SkStrikeCache::PrewarmGlyphs(paint, run.data(), run.size() * sizeof(SkUnichar),
+				props, flags, SkMatrix::I(), nullptr);
+		}
+	}
+}
+
+void SubtitleRenderer::SetStyle(const SubtitleStyle &style)
+{
+	// Every field shows up in the text layer, but only the metrics
+	// below require wrapping or positioning the glyphs again
+	bool relayout = style.fTextSize != fStyle.fTextSize ||
+		style.fLineBreak != fStyle.fLineBreak;
+	bool reposition = relayout || style.fLineSpacing != fStyle.fLineSpacing;
+
+	fStyle = style;
+	ResolveTypeface();
+	BuildPaints();
+	if (relayout)
+		fLayout.Invalidate();
+	if (reposition)
+		fTextBlob.reset();
+	fTextImage.reset();
+}
+
+SkCanvas *SubtitleRenderer::GetCanvas()
+{
+	return fBuffer ? fBuffer->GetBackSurface()->getCanvas() : nullptr;
+}
+
+SkRect SubtitleRenderer::GetMinimizeRect(int width)
+{
+	return { width - 64.0f, 0.0f, width - 32.0f, 30.0f };
+}
+
+SkRect SubtitleRenderer::GetCloseRect(int width)
+{
+	return { width - 32.0f, 0.0f, width - 0.0f, 30.0f };
+}
+
+SkRect SubtitleRenderer::GetTextRect() const
+{
+	return { 5.0f, 30.0f, fWidth - 5.0f, fHeight - 40.0f };
+}
+
+SkIRect SubtitleRenderer::ComputeDamage(const SubtitleFrameState &state) const
+{
+	// The chrome spans the whole window, so any opacity step repaints everything
+	if (fFullDamage || state.fOpacity != fLastState.fOpacity)
+		return SkIRect::MakeWH(fWidth, fHeight);
+
+	SkRect damage = SkRect::MakeEmpty();
+	if (state.fHoverMinimize != fLastState.fHoverMinimize ||
+		state.fHoverClose != fLastState.fHoverClose)
+	{
+		damage.join(GetMinimizeRect(fWidth));
+		damage.join(GetCloseRect(fWidth));
+	}
+	if (fTextChanged || !fTextImage)
+		damage.join(GetTextRect());
+	if (state.fLine != fLastState.fLine ||
+		state.fLineCount != fLastState.fLineCount)
+	{
+		damage.join(GetCounterBounds(fLastState));
+		damage.join(GetCounterBounds(state));
+	}
+
+	SkIRect idamage = damage.roundOut();
+	if (!idamage.intersect(SkIRect::MakeWH(fWidth, fHeight)))
+		return SkIRect::MakeEmpty();
+	return idamage;
+}
+
+void SubtitleRenderer::Render(const SubtitleFrameState &state)
+{
+	fDamage.setEmpty();
+	fRedraw.setEmpty();
+	SkCanvas *canvas = GetCanvas();
+	if (!canvas) return;
+
+	SkIRect damage = ComputeDamage(state);
+
+	// Opacity is applied at composite time, so the fade animation
+	// never re-rasterizes either layer. Each hover look of the chrome is
+	// rasterized once per size and kept, so hovering does not either.
+	const sk_sp<SkImage> &chromeImage = fChromeImages[ChromeIndex(state)];
+	if (!chromeImage)
+		RasterizeChrome(state);
+
+	if (!fTextImage)
+		RasterizeText();
+
+	fLastState = state;
+	fFullDamage = false;
+	fTextChanged = false;
+	if (damage.isEmpty()) return;
+
+	// The back buffer still holds the frame before last, so it also needs
+	// whatever the previous frame changed. Only that area is recomposited.
+	SkIRect redraw = damage;
+	redraw.join(fPrevDamage);
+
+	SkPaint paint;
+	paint.setAlpha(state.fOpacity);
+	canvas->save();
+	canvas->clipRect(SkRect::Make(redraw));
+	canvas->clear(SK_ColorTRANSPARENT);
+	if (chromeImage && state.fOpacity)
+		canvas->drawImage(chromeImage, 0, 0, &paint);
+
+	SkRect text = GetTextRect();
+	canvas->clipRect(text);
+	if (fTextImage)
+		canvas->drawImage(fTextImage, text.left(), text.top());
+	DrawCounter(canvas, state);
+	canvas->restore();
+	canvas->flush();
+
+	fBuffer->Swap();
+	fDamage = damage;
+	fPrevDamage = damage;
+	fRedraw = redraw;
+}
+
+// DrawSysMenu highlights the minimize button over the close button
+int SubtitleRenderer::ChromeIndex(const SubtitleFrameState &state)
+{
+	return state.fHoverMinimize ? 1 : state.fHoverClose ? 2 : 0;
+}
+
+void SubtitleRenderer::RasterizeChrome(const SubtitleFrameState &state)
+{
+	if (!fChromeLayer) return;
+
+	// The snapshot keeps these pixels; the next look drawn into the layer
+	// gets fresh ones
+	SkCanvas *canvas = fChromeLayer->getCanvas();
+	canvas->clear(SK_ColorTRANSPARENT);
+	DrawSysMenu(canvas, state);
+	fChromeImages[ChromeIndex(state)] = fChromeLayer->makeImageSnapshot();
+}
+
+void SubtitleRenderer::RasterizeText()
+{
+	fTextImage.reset();
+	if (!fTextLayer)
+	{
+		if (!fLayout.IsValid() || !fTextBlob)
+			BuildTextBlob();
+		return;
+	}
+
+	SkRect text = GetTextRect();
+	SkCanvas *canvas = fTextLayer->getCanvas();
+	canvas->clear(SK_ColorTRANSPARENT);
+	canvas->save();
+	canvas->translate(-text.left(), -text.top());
+	DrawSubtitle(canvas);
+	canvas->restore();
+	fTextImage = fTextLayer->makeImageSnapshot();
+}
+
+void SubtitleRenderer::DrawSysMenu(SkCanvas *canvas, const SubtitleFrameState &state)
+{
+	SkScalar width = SkIntToScalar(fWidth);
+	SkScalar height = SkIntToScalar(fHeight);
+	SkRect rt = { 0.0f, 0.0f, width, height };
+
+	// Drawing outer background
+	SkPaint paint;
+	SkRRect outer, inner;
+	paint.setColor(SkColorSetRGB(250, 250, 250));
+	paint.setStyle(SkPaint::kFill_Style);
+	outer = SkRRect::MakeRect({ 0, 0, width, height });
+	inner = SkRRect::MakeRect({ 5.0f, 30.0f, width - 5.0f, height - 30.0f });
+	canvas->drawDRRect(outer, inner, paint);
+
+	// Drawing innerframe border
+	paint.reset();
+	paint.setAntiAlias(false);
+	paint.setColor(SkColorSetRGB(200, 200, 200));
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeWidth(1);
+	canvas->drawRect({ 5.0f, 30.0f, width - 5.0f, height - 30.0f }, paint);
+
+	// Draw to Title
+	paint.reset();
+	paint.setAntiAlias(true);
+	paint.setColor(SkColorSetRGB(0, 0, 0));
+	paint.setTextSize(14.0f);
+	canvas->drawText("Anemone v2.0", 12, 10.0f, 20.0f, paint);
+
+	// Draw to Sysmenu button padding
+	paint.reset();
+	paint.setAntiAlias(true);
+	paint.setStyle(SkPaint::kFill_Style);
+	paint.setColor(SkColorSetRGB(250, 250, 250));
+	canvas->drawRect({ width - 80.0f, 0.0f, width, 30.0f }, paint);
+
+	paint.reset();
+	paint.setAntiAlias(true);
+	if (state.fHoverMinimize) // Minimize button
+	{
+		paint.setStyle(SkPaint::kFill_Style);
+		paint.setColor(SkColorSetRGB(229, 230, 231));
+		canvas->drawRect(GetMinimizeRect(fWidth), paint);
+	}
+	else if (state.fHoverClose) // Close button
+	{
+		paint.setStyle(SkPaint::kFill_Style);
+		paint.setColor(SK_ColorRED);
+		canvas->drawRect(GetCloseRect(fWidth), paint);
+	}
+
+	// Draw minimize icon
+	paint.reset();
+	paint.setAntiAlias(false);
+	paint.setStrokeWidth(1.0f);
+	paint.setColor(SkColorSetRGB(0, 0, 0));
+	canvas->drawLine(width - 54.0f, 15.0f, width - 42.0f, 15.0f, paint);
+
+	// Draw close icon
+	paint.reset();
+	paint.setAntiAlias(true);
+	paint.setStrokeWidth(1.01f);
+	if (state.fHoverClose && !state.fHoverMinimize)
+		paint.setColor(SK_ColorWHITE);
+	canvas->drawLine(width - 21.0f, 10.0f, width - 11.0f, 20.0f, paint);
+	canvas->drawLine(width - 11.0f, 10.0f, width - 21.0f, 20.0f, paint);
+
+	// Drawing frame border
+	paint.reset();
+	paint.setAntiAlias(true);
+	paint.setColor(SkColorSetRGB(200, 200, 200));
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeWidth(1);
+	canvas->drawRect(rt, paint);
+}
+
+void SubtitleRenderer::BuildPaints()
+{
+	SkPaint paint;
+	paint.setTextSize(fStyle.fTextSize);
+	paint.setAntiAlias(true);
+	paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+	paint.setTypeface(fTypeface);
+	paint.setStrokeCap(SkPaint::Cap::kRound_Cap);
+	paint.setStrokeJoin(SkPaint::Join::kRound_Join);
+
+	SkPaint &paint_shad = fTextPaints[0];
+	SkPaint &paint_o2 = fTextPaints[1];
+	SkPaint &paint_o1 = fTextPaints[2];
+	SkPaint &paint_fill = fTextPaints[3];
+	paint_o2 = paint_o1 = paint_fill = paint_shad = paint;
+
+	paint_shad.setColor(fStyle.fShadowColor);
+	paint_shad.setStyle(SkPaint::kStrokeAndFill_Style);
+	paint_shad.setStrokeWidth(fStyle.fOuterStroke);
+
+	paint_shad.setMaskFilter(SkMaskFilter::MakeBlur(
+		kNormal_SkBlurStyle,
+		SkBlurMask::ConvertRadiusToSigma(fStyle.fShadowRadius)));
+
+	paint_o2.setColor(fStyle.fOuterColor);
+	paint_o2.setStyle(SkPaint::kStroke_Style);
+	paint_o2.setStrokeWidth(fStyle.fOuterStroke);
+
+	paint_o1.setColor(fStyle.fInnerColor);
+	paint_o1.setStyle(SkPaint::kStrokeAndFill_Style);
+	paint_o1.setStrokeWidth(fStyle.fInnerStroke);
+
+	paint_fill.setColor(fStyle.fFillColor);
+	paint_fill.setStyle(SkPaint::kFill_Style);
+	paint_fill.setStrokeWidth(0.0f);
+}
+
+void SubtitleRenderer::BuildTextBlob()
+{
+	const SkPaint &font = fTextPaints[3];
+	if (!fLayout.IsValid())
+		fLayout.Build(fText, font, fWidth - fStyle.fLineBreak * 2, fFallback.get());
+
+	// One run per typeface change within a line, baselines relative to the
+	// first line. The draw paints keep the primary typeface; each run carries
+	// its own.
+	SkTextBlobBuilder builder;
+	SkPaint runFont(font);
+	const SkGlyphID *glyphs = fLayout.Glyphs();
+	const SkScalar *advances = fLayout.Advances();
+	const uint8_t *fonts = fLayout.Fonts();
+	SkScalar y = 0;
+	for (const SubtitleLayout::Line &line : fLayout.Lines())
+	{
+		SkScalar x = 0;
+		int end = line.fStart + line.fCount;
+		for (int start = line.fStart, next; start < end; start = next)
+		{
+			SkScalar width = advances[start];
+			for (next = start + 1; next < end && fonts[next] == fonts[start]; next++)
+				width += advances[next];
+
+			runFont.setTypeface(fFallback->Typeface(fonts[start]));
+			const SkTextBlobBuilder::RunBuffer &run = builder.allocRun(runFont, next - start, x, y);
+			memcpy(run.glyphs, glyphs + start, (next - start) * sizeof(SkGlyphID));
+			x += width;
+		}
+		y += fStyle.fTextSize + fStyle.fLineSpacing;
+	}
+	fTextBlob = builder.make();
+}
+
+void SubtitleRenderer::DrawSubtitle(SkCanvas *canvas)
+{
+	if (!fLayout.IsValid() || !fTextBlob)
+		BuildTextBlob();
+	if (!fTextBlob) return;
+
+	// The shadow pass sits slightly lower-right than the outline passes
+	for (int i = 0; i < 4; i++)
+	{
+		SkScalar padding = i == 0 ? fStyle.fShadowPadding : fStyle.fPadding;
+		canvas->drawTextBlob(fTextBlob, padding + 10.0f, padding + fStyle.fTextSize + 35.0f, fTextPaints[i]);
+	}
+}
+
+// Formats into a stack buffer rather than an SkString, since the counter is
+// drawn on every frame that is presented. Returns the length.
+static const int kCounterSize = 32;
+static size_t MakeCounter(const SubtitleFrameState &state, SkPaint *paint, char z[kCounterSize])
+{
+	paint->setAntiAlias(true);
+	paint->setColor(SkColorSetRGB(0, 0, 0));
+	paint->setTextSize(18.0f);
+	paint->setTextAlign(SkPaint::Align::kRight_Align);
+	int length = snprintf(z, kCounterSize, "%d / %d", state.fLine + 1, state.fLineCount);
+	return (size_t)SkTPin(length, 0, kCounterSize - 1);
+}
+
+SkRect SubtitleRenderer::GetCounterBounds(const SubtitleFrameState &state) const
+{
+	if (state.fLine == -1) return SkRect::MakeEmpty();
+
+	SkPaint paint;
+	char z[kCounterSize];
+	size_t length = MakeCounter(state, &paint, z);
+
+	// measureText bounds are for left-aligned text at the origin
+	SkRect bounds;
+	SkScalar width = paint.measureText(z, length, &bounds);
+	bounds.offset(fWidth - 10.0f - width, fHeight - paint.getTextSize() - 26.0f);
+	bounds.outset(3.0f, 3.0f); // half the 3px outline plus AA
+	return bounds;
+}
+
+void SubtitleRenderer::DrawCounter(SkCanvas *canvas, const SubtitleFrameState &state)
+{
+	if (state.fLine == -1) return;
+
+	SkPaint paint;
+	char z[kCounterSize];
+	size_t length = MakeCounter(state, &paint, z);
+
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeCap(SkPaint::Cap::kRound_Cap);
+	paint.setStrokeJoin(SkPaint::Join::kRound_Join);
+	paint.setStrokeWidth(3.0f);
+	paint.setColor(SkColorSetARGB(128, 255, 255, 255));
+	canvas->drawText(z, length, fWidth - 10.0f, fHeight - paint.getTextSize() - 26.0f, paint);
+
+	paint.setStyle(SkPaint::kFill_Style);
+	paint.setColor(SkColorSetRGB(0, 0, 0));
+	canvas->drawText(z, length, fWidth - 10.0f, fHeight - paint.getTextSize() - 26.0f, paint);
+}
@@ -0,0 +1,166 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <memory>
+#include <string>
+#include "SkCanvas.h"
+#include "SkColor.h"
+#include "SkImage.h"
+#include "SkImageInfo.h"
+#include "SkPaint.h"
+#include "SkRect.h"
+#include "SkSurface.h"
+#include "SkTextBlob.h"
+#include "SkTypeface.h"
+#include "FontFallback.h"
+#include "PresentBuffer.h"
+#include "SubtitleLayout.h"
+
+// Subtitle look; defaults match the original hard-coded PaintLoop values.
+struct SubtitleStyle
+{
+	SubtitleStyle()
+		: fTextSize(36.0f)
+		, fLineSpacing(5.0f)
+		, fLineBreak(18.0f)
+		, fPadding(10.0f)
+		, fShadowPadding(15.0f)
+		, fOuterStroke(14.0f)
+		, fInnerStroke(8.0f)
+		, fShadowRadius(6.0f)
+		, fShadowColor(SkColorSetARGB(127, 160, 160, 160))
+		, fOuterColor(SkColorSetARGB(255, 214, 255, 251))
+		, fInnerColor(SkColorSetRGB(46, 196, 182))
+		, fFillColor(SkColorSetRGB(255, 255, 255))
+	{}
+
+	SkScalar fTextSize;
+	SkScalar fLineSpacing;
+	SkScalar fLineBreak;
+	SkScalar fPadding;
+	SkScalar fShadowPadding;
+	SkScalar fOuterStroke;
+	SkScalar fInnerStroke;
+	SkScalar fShadowRadius;
+	SkColor fShadowColor;
+	SkColor fOuterColor;
+	SkColor fInnerColor;
+	SkColor fFillColor;
+};
+
+// Everything besides the text that a single frame depends on.
+struct SubtitleFrameState
+{
+	SubtitleFrameState()
+		: fOpacity(0)
+		, fHoverMinimize(false)
+		, fHoverClose(false)
+		, fLine(-1)
+		, fLineCount(0)
+	{}
+
+	int fOpacity;         // title-bar (guide) opacity, 0 ~ 255
+	bool fHoverMinimize;
+	bool fHoverClose;
+	int fLine;            // selected caption line, -1 hides the counter
+	int fLineCount;
+};
+
+// Platform-neutral overlay renderer. Draws the subtitle and the window chrome
+// into the back buffer of a PresentBuffer and swaps it to the front when the
+// frame changed; presenting the front buffer is up to the caller.
+class SubtitleRenderer
+{
+public:
+	SubtitleRenderer();
+	~SubtitleRenderer();
+
+	bool Attach(PresentBuffer *buffer);
+	// Sizes the layers for a window of |info| without a present buffer;
+	// only RenderTextLayer() is usable then.
+	void AttachLayers(const SkImageInfo &info);
+	// |layer| is an optional text layer of |text| pre-rendered with the
+	// current style and size, see CaptionPrefetcher.
+	void SetText(const std::wstring &text, sk_sp<SkImage> layer = nullptr);
+	const std::wstring &GetText() const { return fText; }
+	void SetStyle(const SubtitleStyle &style);
+	void Render(const SubtitleFrameState &state);
+	sk_sp<SkImage> RenderTextLayer(const std::wstring &text);
+	// Rasterizes the glyphs of every character in |text| into the strikes
+	// the text passes draw from, so their first appearance does not stall
+	// a frame. Blocks; meant for a worker thread with its own renderer.
+	void PrewarmGlyphs(const std::wstring &text);
+
+	SkCanvas *GetCanvas();
+	// Glyph runs of the current text, one per typeface change within a
+	// line; null until the text is first laid out
+	const sk_sp<SkTextBlob> &GetTextBlob() const { return fTextBlob; }
+	// Area of the front buffer changed by the last Render, empty when
+	// nothing was drawn and no swap happened
+	const SkIRect &GetDamage() const { return fDamage; }
+	// Area of the back buffer the last Render recomposited before the
+	// swap: the damage joined with the previous frame's
+	const SkIRect &GetRedrawRect() const { return fRedraw; }
+	int Width() const { return fWidth; }
+	int Height() const { return fHeight; }
+
+	static SkRect GetMinimizeRect(int width);
+	static SkRect GetCloseRect(int width);
+
+private:
+	void ResolveTypeface();
+	void CreateLayers(const SkImageInfo &info);
+	SkRect GetTextRect() const;
+	SkRect GetCounterBounds(const SubtitleFrameState &state) const;
+	SkIRect ComputeDamage(const SubtitleFrameState &state) const;
+	static int ChromeIndex(const SubtitleFrameState &state);
+	void RasterizeChrome(const SubtitleFrameState &state);
+	void RasterizeText();
+	void BuildPaints();
+	void BuildTextBlob();
+	void DrawSysMenu(SkCanvas *canvas, const SubtitleFrameState &state);
+	void DrawSubtitle(SkCanvas *canvas);
+	void DrawCounter(SkCanvas *canvas, const SubtitleFrameState &state);
+
+	int fWidth;
+	int fHeight;
+	PresentBuffer *fBuffer;
+	std::wstring fText;
+	SubtitleStyle fStyle;
+	SubtitleLayout fLayout;
+	sk_sp<SkTypeface> fTypeface;
+	std::unique_ptr<FontFallback> fFallback;  // per renderer, not thread-safe
+	sk_sp<SkTextBlob> fTextBlob;
+	SkPaint fTextPaints[4];       // shadow, outer stroke, inner stroke, fill
+
+	// Pre-rendered layers, composited every frame
+	sk_sp<SkSurface> fChromeLayer;
+	sk_sp<SkSurface> fTextLayer;
+	sk_sp<SkImage> fChromeImages[3];  // nothing, minimize, close hovered
+	sk_sp<SkImage> fTextImage;
+	SubtitleFrameState fLastState;
+	bool fFullDamage;
+	bool fTextChanged;
+	SkIRect fDamage;
+	SkIRect fPrevDamage;
+	SkIRect fRedraw;
+};
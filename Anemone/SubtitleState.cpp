@@ -0,0 +1,63 @@
+#include "SubtitleState.h"
+
+SubtitleStateStore::Reader::Reader(const SubtitleStateStore *store)
+	: fStore(store)
+{
+	// Announce the reader before loading, so a writer that still sees
+	// fReaders == 0 after its swap knows nobody holds a retired snapshot
+	fStore->fReaders.fetch_add(1, std::memory_order_seq_cst);
+	fState = fStore->fCurrent.load(std::memory_order_seq_cst);
+}
+
+SubtitleStateStore::Reader::Reader(Reader &&other)
+	: fStore(other.fStore)
+	, fState(other.fState)
+{
+	other.fStore = nullptr;
+	other.fState = nullptr;
+}
+
+SubtitleStateStore::Reader::~Reader()
+{
+	if (fStore)
+		fStore->fReaders.fetch_sub(1, std::memory_order_release);
+}
+
+SubtitleStateStore::SubtitleStateStore()
+	: fCurrent(new SubtitleState)
+	, fReaders(0)
+{
+}
+
+SubtitleStateStore::~SubtitleStateStore()
+{
+	for (const SubtitleState *state : fRetired)
+		delete state;
+	delete fCurrent.load(std::memory_order_relaxed);
+}
+
+SubtitleStateStore::Reader SubtitleStateStore::Read() const
+{
+	return Reader(this);
+}
+
+void SubtitleStateStore::Publish(const std::wstring &text, int line)
+{
+	Publish(SubtitleState(text, line));
+}
+
+void SubtitleStateStore::Publish(const SubtitleState &state)
+{
+	const SubtitleState *next = new SubtitleState(state);
+
+	std::lock_guard<std::mutex> lock(fWriteMutex);
+	fRetired.push_back(fCurrent.exchange(next, std::memory_order_seq_cst));
+
+	// Readers arriving from now on can only see |next|
+	if (fReaders.load(std::memory_order_seq_cst) == 0)
+	{
+		for (const SubtitleState *retired : fRetired)
+			delete retired;
+		fRetired.clear();
+	}
+}
@@ -0,0 +1,83 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Immutable snapshot of what the overlay shows.
+struct SubtitleState
+{
+	SubtitleState() : fLine(-1) {}
+	SubtitleState(const std::wstring &text, int line) : fText(text), fLine(line) {}
+
+	std::wstring fText;
+	int fLine;            // selected caption line, -1 when none
+};
+
+// Hands SubtitleState from the hook threads to the renderer.
+// Writers build a new snapshot and swap it in with one atomic exchange; readers
+// pin the current one without taking a lock. Replaced snapshots are retired
+// and freed by a later Publish once no reader is active, so a reader never
+// waits on a writer and a writer never waits on a frame.
+class SubtitleStateStore
+{
+public:
+	class Reader
+	{
+	public:
+		Reader(Reader &&other);
+		~Reader();
+
+		const SubtitleState *operator->() const { return fState; }
+		const SubtitleState &operator*() const { return *fState; }
+
+	private:
+		friend class SubtitleStateStore;
+		explicit Reader(const SubtitleStateStore *store);
+		Reader(const Reader &) = delete;
+		Reader &operator=(const Reader &) = delete;
+
+		const SubtitleStateStore *fStore;
+		const SubtitleState *fState;
+	};
+
+	SubtitleStateStore();
+	~SubtitleStateStore();
+
+	// Keep readers short-lived; retired snapshots pile up while any is held.
+	Reader Read() const;
+	void Publish(const std::wstring &text, int line);
+	void Publish(const SubtitleState &state);
+
+private:
+	SubtitleStateStore(const SubtitleStateStore &) = delete;
+	SubtitleStateStore &operator=(const SubtitleStateStore &) = delete;
+
+	std::atomic<const SubtitleState *> fCurrent;
+	mutable std::atomic<int> fReaders;
+
+	// Writer side only
+	std::mutex fWriteMutex;
+	std::vector<const SubtitleState *> fRetired;
+};
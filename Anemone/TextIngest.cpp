@@ -0,0 +1,183 @@
+#include "TextIngest.h"
+#include <algorithm>
+
+static bool IsBlank(wchar_t c)
+{
+	return c == L' ' || c == L'\t' || c == 0x3000;	// ideographic space
+}
+
+TextIngest::TextIngest(std::unique_ptr<TextSource> source, Clock::duration debounce)
+	: fSource(std::move(source))
+	, fDebounce(debounce)
+	, fHasPending(false)
+	, fPendingHash(0)
+	, fHasLast(false)
+	, fLastHash(0)
+	, fQuit(false)
+{
+	fStats.fReceived = fStats.fDropped = fStats.fPublished = 0;
+}
+
+TextIngest::~TextIngest()
+{
+	Stop();
+}
+
+void TextIngest::SetPublishCallback(PublishCallback onPublish)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	fOnPublish = onPublish;
+}
+
+void TextIngest::Start()
+{
+	if (fReader.joinable()) return;
+	fQuit = false;
+	fPublisher = std::thread(&TextIngest::Run, this);
+	fReader = std::thread(&TextIngest::Read, this);
+}
+
+void TextIngest::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fQuit = true;
+	}
+	fWake.notify_all();
+	fSource->Close();
+	if (fReader.joinable())
+		fReader.join();
+	if (fPublisher.joinable())
+		fPublisher.join();
+}
+
+TextIngest::Stats TextIngest::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	return fStats;
+}
+
+void TextIngest::Normalize(const std::wstring &text, std::wstring *out)
+{
+	out->clear();
+	out->reserve(text.size());
+
+	size_t lineEnd = 0;	// out length without the current line's trailing blanks
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		wchar_t c = text[i];
+		if (c == L'\r')
+		{
+			if (i + 1 < text.size() && text[i + 1] == L'\n') i++;
+			c = L'\n';
+		}
+		if (c == L'\0') continue;
+
+		if (c == L'\n')
+		{
+			out->resize(lineEnd);
+			// No leading blank lines
+			if (out->empty()) continue;
+			out->push_back(c);
+			lineEnd = out->size();
+			continue;
+		}
+
+		// Leading blanks of the text go, indentation of later lines stays
+		if (out->empty() && IsBlank(c)) continue;
+		out->push_back(c);
+		if (!IsBlank(c))
+			lineEnd = out->size();
+	}
+	out->resize(lineEnd);
+
+	// Trailing blank lines
+	size_t end = out->find_last_not_of(L'\n');
+	out->resize(end == std::wstring::npos ? 0 : end + 1);
+}
+
+uint64_t TextIngest::Hash(const std::wstring &text)
+{
+	// FNV-1a over the code units, whole: UTF-16 on Windows, UTF-32 elsewhere
+	uint64_t hash = 14695981039346656037ull;
+	for (wchar_t c : text)
+	{
+		hash ^= (uint32_t)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void TextIngest::Read()
+{
+	std::wstring raw;
+	while (fSource->Next(&raw))
+		Accept(raw);
+}
+
+void TextIngest::Accept(const std::wstring &raw)
+{
+	std::wstring text;
+	Normalize(raw, &text);
+	uint64_t hash = Hash(text);
+	Clock::time_point now = Clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fStats.fReceived++;
+
+		// A repeat of the pending text does not restart the window
+		if (fHasPending && hash == fPendingHash && text == fPending)
+		{
+			fStats.fDropped++;
+			return;
+		}
+		// Back to what is on screen; whatever was pending is void
+		if (fHasLast && hash == fLastHash && text == fLast)
+		{
+			fStats.fDropped++;
+			fHasPending = false;
+			return;
+		}
+
+		if (!fHasPending)
+			fPendingSince = now;
+		fHasPending = true;
+		fPending.swap(text);
+		fPendingHash = hash;
+		fLastArrival = now;
+	}
+	fWake.notify_all();
+}
+
+void TextIngest::Run()
+{
+	std::unique_lock<std::mutex> lock(fMutex);
+	for (;;)
+	{
+		fWake.wait(lock, [this] { return fQuit || fHasPending; });
+		if (fQuit) break;
+
+		Clock::time_point due = std::min(fLastArrival + fDebounce,
+			fPendingSince + fDebounce * kMaxDelayWindows);
+		if (Clock::now() < due)
+		{
+			// Woken early by a newer snapshot or Stop(); re-evaluate
+			fWake.wait_until(lock, due);
+			continue;
+		}
+
+		fHasPending = false;
+		fHasLast = true;
+		fLast.swap(fPending);
+		fLastHash = fPendingHash;
+		fStats.fPublished++;
+
+		std::wstring text = fLast;
+		PublishCallback onPublish = fOnPublish;
+		lock.unlock();
+		if (onPublish)
+			onPublish(text);
+		lock.lock();
+	}
+}
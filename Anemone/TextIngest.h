@@ -0,0 +1,94 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "TextSource.h"
+
+// Front end between a noisy TextSource and the renderer.
+// A reader thread pulls snapshots, normalizes and hashes them, and drops
+// any that match the pending or the last published text. A publisher thread
+// hands the pending text to the callback once the source has been quiet for
+// the debounce window, or after kMaxDelayWindows windows of a steady stream,
+// so a burst of updates costs one relayout.
+class TextIngest
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::function<void(const std::wstring &text)> PublishCallback;
+
+	struct Stats
+	{
+		uint64_t fReceived;
+		uint64_t fDropped;    // duplicates of the pending or published text
+		uint64_t fPublished;
+	};
+
+	TextIngest(std::unique_ptr<TextSource> source, Clock::duration debounce);
+	~TextIngest();
+
+	void SetPublishCallback(PublishCallback onPublish);
+	void Start();
+	void Stop();
+
+	Stats GetStats() const;
+
+	// Unifies line endings, strips trailing blanks from every line and
+	// blank lines from both ends.
+	static void Normalize(const std::wstring &text, std::wstring *out);
+	static uint64_t Hash(const std::wstring &text);
+
+private:
+	static const int kMaxDelayWindows = 4;
+
+	void Read();
+	void Accept(const std::wstring &raw);
+	void Run();
+
+	std::unique_ptr<TextSource> fSource;
+	Clock::duration fDebounce;
+
+	bool fHasPending;
+	std::wstring fPending;
+	uint64_t fPendingHash;
+	Clock::time_point fPendingSince;
+	Clock::time_point fLastArrival;
+
+	bool fHasLast;
+	std::wstring fLast;
+	uint64_t fLastHash;
+
+	Stats fStats;
+	bool fQuit;
+
+	PublishCallback fOnPublish;
+	mutable std::mutex fMutex;
+	std::condition_variable fWake;
+	std::thread fReader;
+	std::thread fPublisher;
+};
@@ -0,0 +1,36 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <string>
+
+// Producer of whole text snapshots, e.g. the clipboard.
+// Next() is called from a single worker thread and blocks until a new
+// snapshot is available; Close() may be called from any thread and makes
+// the pending and every later Next() return false.
+class TextSource
+{
+public:
+	virtual ~TextSource() {}
+
+	virtual bool Next(std::wstring *text) = 0;
+	virtual void Close() = 0;
+};
@@ -0,0 +1,150 @@
+#include "TranslationPipeline.h"
+#include "SkOpts.h"
+
+uint32_t TranslationPipeline::WideHash::operator()(const std::wstring &key) const
+{
+	return SkOpts::hash_fn(key.data(), key.size() * sizeof(wchar_t), 0);
+}
+
+TranslationPipeline::TranslationPipeline(std::unique_ptr<Translator> translator, int workers,
+	int cacheEntries)
+	: fTranslator(std::move(translator))
+	, fWorkerCount(workers < 1 ? 1 : workers)
+	, fHasSubmitted(false)
+	, fCache(cacheEntries)
+	, fCancelSubmitted(std::make_shared<std::atomic<bool>>(false))
+	, fGeneration(0)
+	, fQuit(false)
+{
+}
+
+TranslationPipeline::~TranslationPipeline()
+{
+	Stop();
+}
+
+void TranslationPipeline::SetSourceCallback(SourceCallback onSource)
+{
+	std::lock_guard<std::mutex> lock(fDeliverMutex);
+	fOnSource = onSource;
+}
+
+void TranslationPipeline::SetResultCallback(ResultCallback onResult)
+{
+	std::lock_guard<std::mutex> lock(fDeliverMutex);
+	fOnResult = onResult;
+}
+
+void TranslationPipeline::Start()
+{
+	if (!fWorkers.empty()) return;
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fQuit = false;
+	}
+	for (int i = 0; i < fWorkerCount; i++)
+		fWorkers.emplace_back(&TranslationPipeline::Run, this);
+}
+
+void TranslationPipeline::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fQuit = true;
+		fCancelSubmitted->store(true);
+		fHasSubmitted = false;
+	}
+	fWake.notify_all();
+	for (std::thread &worker : fWorkers)
+		worker.join();
+	fWorkers.clear();
+}
+
+bool TranslationPipeline::Submit(const std::wstring &source)
+{
+	// Held until the source or its cached translation is handed out, so a
+	// worker still delivering the previous text can't show it afterwards
+	std::lock_guard<std::mutex> deliverLock(fDeliverMutex);
+	std::wstring cached;
+	bool hit = false;
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		uint64_t generation = ++fGeneration;
+
+		// Whatever was submitted before is stale now
+		fCancelSubmitted->store(true);
+		fCancelSubmitted = std::make_shared<std::atomic<bool>>(false);
+		fHasSubmitted = false;
+
+		if (std::wstring *translation = fCache.find(source))
+		{
+			cached = *translation;
+			hit = true;
+		}
+		else
+		{
+			fSubmitted.fSource = source;
+			fSubmitted.fGeneration = generation;
+			fSubmitted.fCancelled = fCancelSubmitted;
+			fHasSubmitted = true;
+		}
+	}
+
+	if (hit)
+	{
+		if (fOnResult)
+			fOnResult(source, cached);
+		return true;
+	}
+	if (fOnSource)
+		fOnSource(source);
+	fWake.notify_one();
+	return false;
+}
+
+void TranslationPipeline::Deliver(uint64_t generation, const std::wstring &source,
+	const std::wstring &translation)
+{
+	std::lock_guard<std::mutex> lock(fDeliverMutex);
+	if (generation != fGeneration.load()) return;
+	if (fOnResult)
+		fOnResult(source, translation);
+}
+
+void TranslationPipeline::Run()
+{
+	for (;;)
+	{
+		Request request;
+		std::wstring translation;
+		bool cached = false;
+		{
+			std::unique_lock<std::mutex> lock(fMutex);
+			fWake.wait(lock, [this] { return fQuit || fHasSubmitted; });
+			if (fQuit) return;
+
+			request = std::move(fSubmitted);
+			fHasSubmitted = false;
+
+			// Another worker may have finished the same text meanwhile
+			if (std::wstring *hit = fCache.find(request.fSource))
+			{
+				translation = *hit;
+				cached = true;
+			}
+		}
+
+		bool translated = cached ||
+			fTranslator->Translate(request.fSource, &translation, *request.fCancelled);
+		if (!cached && translated)
+		{
+			// Superseded or not, the result is good for the cache
+			std::lock_guard<std::mutex> lock(fMutex);
+			if (!fCache.find(request.fSource))
+				fCache.insert(request.fSource, translation);
+		}
+
+		if (translated)
+			Deliver(request.fGeneration, request.fSource, translation);
+	}
+}
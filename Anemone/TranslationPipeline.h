@@ -0,0 +1,99 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SkLRUCache.h"
+#include "Translator.h"
+
+// Runs a Translator off the UI and hook threads.
+// Submit() never waits for a translation: a cached text is answered on the
+// spot, anything else is handed to a pool of workers. Every Submit()
+// supersedes the ones before it, so a waiting request is dropped and a running
+// one is asked to cancel; only the latest text is ever delivered.
+// Finished translations land in an LRU cache keyed by the source.
+class TranslationPipeline
+{
+public:
+	typedef std::function<void(const std::wstring &source)> SourceCallback;
+	typedef std::function<void(const std::wstring &source, const std::wstring &translation)> ResultCallback;
+
+	// The translator is called from all workers at once.
+	TranslationPipeline(std::unique_ptr<Translator> translator, int workers = 2,
+		int cacheEntries = 1024);
+	~TranslationPipeline();
+
+	// |onSource| gets each submitted text that is not cached, before any
+	// result can be delivered, so it may show the source until then.
+	void SetSourceCallback(SourceCallback onSource);
+	void SetResultCallback(ResultCallback onResult);
+	void Start();
+	void Stop();
+
+	// Returns true when the translation was cached and already delivered.
+	bool Submit(const std::wstring &source);
+
+private:
+	struct Request
+	{
+		std::wstring fSource;
+		uint64_t fGeneration;
+		std::shared_ptr<std::atomic<bool>> fCancelled;
+	};
+
+	struct WideHash
+	{
+		uint32_t operator()(const std::wstring &key) const;
+	};
+
+	void Run();
+	void Deliver(uint64_t generation, const std::wstring &source, const std::wstring &translation);
+
+	std::unique_ptr<Translator> fTranslator;
+	int fWorkerCount;
+
+	// The request queue, bounded at one: only the latest text waits, since
+	// the overlay shows nothing else. Text comes from the clipboard, so
+	// there are no upcoming lines to queue ahead.
+	bool fHasSubmitted;
+	Request fSubmitted;
+	SkLRUCache<std::wstring, std::wstring, WideHash> fCache;
+	std::shared_ptr<std::atomic<bool>> fCancelSubmitted;
+	std::atomic<uint64_t> fGeneration;  // bumped with fDeliverMutex held
+	bool fQuit;
+
+	mutable std::mutex fMutex;
+	std::condition_variable fWake;
+	std::vector<std::thread> fWorkers;
+
+	// Serializes delivery so a superseded result can never land after a newer one
+	std::mutex fDeliverMutex;
+	SourceCallback fOnSource;
+	ResultCallback fOnResult;
+};
@@ -0,0 +1,54 @@
+#include "Translator.h"
+#include "CaptionFile.h"
+
+void DictionaryTranslator::Add(const std::wstring &source, const std::wstring &translation)
+{
+	fEntries[source] = translation;
+}
+
+bool DictionaryTranslator::Load(const std::wstring &path)
+{
+	CaptionFile file;
+	if (!file.Open(path))
+		return false;
+	file.WaitForIndex();
+
+	std::wstring line;
+	for (int i = 0; i < file.GetLineCount(); i++)
+	{
+		file.GetLine(i, &line);
+		size_t tab = line.find(L'\t');
+		if (tab == std::wstring::npos || tab == 0) continue;
+		Add(line.substr(0, tab), line.substr(tab + 1));
+	}
+	return true;
+}
+
+bool DictionaryTranslator::Translate(const std::wstring &source, std::wstring *translation,
+	const std::atomic<bool> &cancelled)
+{
+	auto whole = fEntries.find(source);
+	if (whole != fEntries.end())
+	{
+		*translation = whole->second;
+		return true;
+	}
+
+	translation->clear();
+	size_t start = 0;
+	for (;;)
+	{
+		if (cancelled.load(std::memory_order_relaxed))
+			return false;
+
+		size_t end = source.find(L'\n', start);
+		std::wstring line = source.substr(start, end == std::wstring::npos ? std::wstring::npos : end - start);
+		auto entry = fEntries.find(line);
+		translation->append(entry != fEntries.end() ? entry->second : line);
+
+		if (end == std::wstring::npos) break;
+		translation->push_back(L'\n');
+		start = end + 1;
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+/**
+* This file is part of Anemone.
+*
+* Anemone is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* The Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Anemone is distributed in the hope that it will be useful,
+*
+* But WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with Anemone.
+*
+*   If not, see <http://www.gnu.org/licenses/>.
+*
+**/
+
+#pragma once
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+// Translation backend. Translate() runs on a pipeline worker and may take
+// long; engines that can should poll |cancelled| and give up once it is set.
+// Returns false when nothing usable was produced.
+class Translator
+{
+public:
+	virtual ~Translator() {}
+
+	virtual bool Translate(const std::wstring &source, std::wstring *translation,
+		const std::atomic<bool> &cancelled) = 0;
+};
+
+// Local phrase table, also the stand-in backend when no engine is set up.
+// A text found as a whole is replaced as a whole, otherwise every line is
+// looked up on its own and unknown lines are kept as they are.
+class DictionaryTranslator : public Translator
+{
+public:
+	void Add(const std::wstring &source, const std::wstring &translation);
+	// UTF-8 file of "source<TAB>translation" lines
+	bool Load(const std::wstring &path);
+	size_t Size() const { return fEntries.size(); }
+
+	bool Translate(const std::wstring &source, std::wstring *translation,
+		const std::atomic<bool> &cancelled) override;
+
+private:
+	std::unordered_map<std::wstring, std::wstring> fEntries;
+};
@@ -19,6 +19,11 @@ public:
     static std::unique_ptr<SkExecutor> MakeFIFOThreadPool(int threads = 0);
     static std::unique_ptr<SkExecutor> MakeLIFOThreadPool(int threads = 0);
 
+    // Create a work-stealing thread pool SkExecutor. Each thread runs the work it adds itself
+    // newest first, taking the oldest work of the others once it runs out, so threads adding
+    // and running lots of small work rarely touch shared state.
+    static std::unique_ptr<SkExecutor> MakeWorkStealingThreadPool(int threads = 0);
+
     // There is always a default SkExecutor available by calling SkExecutor::GetDefault().
     static SkExecutor& GetDefault();
     static void SetDefault(SkExecutor*);  // Does not take ownership.  Not thread safe.
@@ -26,6 +31,9 @@ public:
     // Add work to execute.
     virtual void add(std::function<void(void)>) = 0;
 
+    // Add work that calls fn(ctx). Work-stealing pools queue this without allocating.
+    virtual void addTask(void (*fn)(void*), void* ctx);
+
     // If it makes sense for this executor, use this thread to execute work for a little while.
     virtual void borrow() {}
 };
@@ -13,6 +13,7 @@
 #include "SkFlattenable.h"
 #include "SkScalar.h"
 
+class SkExecutor;
 class SkMatrix;
 struct SkRect;
 class SkString;
@@ -31,10 +32,12 @@ public:
      *                   with some opaque object. This is just a hint which backends are free to
      *                   ignore.
      *  @param respectCTM if true the blur's sigma is modified by the CTM.
+     *  @param executor  If not null, large masks are blurred in parallel on its threads. It must
+     *                   outlive the filter, and is not serialized.
      *  @return The new blur maskfilter
      */
     static sk_sp<SkMaskFilter> MakeBlur(SkBlurStyle style, SkScalar sigma, const SkRect& occluder,
-                                        bool respectCTM = true);
+                                        bool respectCTM = true, SkExecutor* executor = nullptr);
     static sk_sp<SkMaskFilter> MakeBlur(SkBlurStyle style, SkScalar sigma,
                                         bool respectCTM = true);
 
@@ -1537,6 +1537,7 @@ private:
     friend class SkPaintPriv;
     friend class SkPDFDevice;
     friend class SkScalerContext;  // for computeLuminanceColor()
+    friend class SkStrikeCache;    // for setupForAsPaths()
     friend class SkTextBaseIter;
     friend class SkTextBlobCacheDiffCanvas;
 };
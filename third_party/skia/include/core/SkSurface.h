@@ -26,6 +26,7 @@
 
 class SkCanvas;
 class SkDeferredDisplayList;
+class SkExecutor;
 class SkPaint;
 class SkSurfaceCharacterization;
 class GrBackendRenderTarget;
@@ -167,6 +168,40 @@ public:
         return MakeRaster(SkImageInfo::MakeN32Premul(width, height), surfaceProps);
     }
 
+    /** Allocates raster SkSurface whose SkCanvas splits the surface into tiles horizontal
+        stripes and rasterizes each draw across them on several threads. Allocates and
+        zeroes pixel memory, which is deleted when SkSurface is deleted.
+
+        Draws are queued and may still be running when an SkCanvas call returns. Pixels
+        are brought up to date before they are read or written through SkCanvas or
+        SkSurface, including by makeImageSnapshot(); SkCanvas::flush() waits for queued
+        draws explicitly. Worker threads spin while draws are queued, so flush or snapshot
+        once a frame is complete.
+
+        Output is identical to MakeRaster(), including anti-aliased paths and hairlines
+        that span several stripes.
+        Layers from SkCanvas::saveLayer() are drawn on the calling thread; restoring them
+        onto the surface is tiled.
+
+        SkSurface is returned if all parameters are valid.
+        Valid parameters include:
+        info dimensions are greater than zero;
+        info contains SkColorType and SkAlphaType supported by raster surface;
+        tiles is greater than zero.
+
+        @param imageInfo     width, height, SkColorType, SkAlphaType, SkColorSpace,
+                             of raster surface; width and height must be greater than zero
+        @param tiles         number of stripes, and of tasks drawing them
+        @param executor      runs the tasks; must outlive SkSurface. If nullptr, SkSurface
+                             owns a pool of tiles threads
+        @param surfaceProps  LCD striping orientation and setting for device independent fonts;
+                             may be nullptr
+        @return              SkSurface if all parameters are valid; otherwise, nullptr
+    */
+    static sk_sp<SkSurface> MakeRasterThreaded(const SkImageInfo& imageInfo, int tiles,
+                                               SkExecutor* executor = nullptr,
+                                               const SkSurfaceProps* surfaceProps = nullptr);
+
     /** Wraps a GPU-backed texture into SkSurface. Caller must ensure the texture is
         valid for the lifetime of returned SkSurface. If sampleCnt greater than zero,
         creates an intermediate MSAA SkSurface which is used for drawing backendTexture.
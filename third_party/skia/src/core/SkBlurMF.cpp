@@ -7,6 +7,7 @@
 
 #include "SkBlurMask.h"
 #include "SkBlurPriv.h"
+#include "SkDraw.h"
 #include "SkGpuBlurUtils.h"
 #include "SkMaskFilterBase.h"
 #include "SkReadBuffer.h"
@@ -41,7 +42,8 @@
 
 class SkBlurMaskFilterImpl : public SkMaskFilterBase {
 public:
-    SkBlurMaskFilterImpl(SkScalar sigma, SkBlurStyle, const SkRect& occluder, bool respectCTM);
+    SkBlurMaskFilterImpl(SkScalar sigma, SkBlurStyle, const SkRect& occluder, bool respectCTM,
+                         SkExecutor* executor);
 
     // overrides from SkMaskFilter
     SkMask::Format getFormat() const override;
@@ -88,6 +90,10 @@ protected:
                                    const SkIRect& clipBounds,
                                    NinePatch*) const override;
 
+    SkCachedData* filterPathToCachedMask(const SkPath& devPath, const PathKey&,
+                                         const SkMatrix&, SkStrokeRec::InitStyle,
+                                         SkMask* mask) const override;
+
     bool filterRectMask(SkMask* dstM, const SkRect& r, const SkMatrix& matrix,
                         SkIPoint* margin, SkMask::CreateMode createMode) const;
     bool filterRRectMask(SkMask* dstM, const SkRRect& r, const SkMatrix& matrix,
@@ -105,6 +111,7 @@ private:
     SkBlurStyle fBlurStyle;
     SkRect      fOccluder;
     bool        fRespectCTM;
+    SkExecutor* fExecutor;      // Not serialized.
 
     SkBlurMaskFilterImpl(SkReadBuffer&);
     void flatten(SkWriteBuffer&) const override;
@@ -268,11 +275,13 @@ bool SkComputeBlurredRRectParams(const SkRRect& srcRRect, const SkRRect& devRRec
 ///////////////////////////////////////////////////////////////////////////////
 
 SkBlurMaskFilterImpl::SkBlurMaskFilterImpl(SkScalar sigma, SkBlurStyle style,
-                                           const SkRect& occluder, bool respectCTM)
+                                           const SkRect& occluder, bool respectCTM,
+                                           SkExecutor* executor)
     : fSigma(sigma)
     , fBlurStyle(style)
     , fOccluder(occluder)
-    , fRespectCTM(respectCTM) {
+    , fRespectCTM(respectCTM)
+    , fExecutor(executor) {
     SkASSERT(fSigma > 0);
     SkASSERT((unsigned)style <= kLastEnum_SkBlurStyle);
 }
@@ -297,7 +306,7 @@ bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
                                       const SkMatrix& matrix,
                                       SkIPoint* margin) const {
     SkScalar sigma = this->computeXformedSigma(matrix);
-    return SkBlurMask::BoxBlur(dst, src, sigma, fBlurStyle, margin);
+    return SkBlurMask::BoxBlur(dst, src, sigma, fBlurStyle, margin, fExecutor);
 }
 
 bool SkBlurMaskFilterImpl::filterRectMask(SkMask* dst, const SkRect& r,
@@ -416,6 +425,16 @@ static SkCachedData* add_cached_rrect(SkMask* mask, SkScalar sigma, SkBlurStyle
     return cache;
 }
 
+static SkCachedData* add_cached_path(SkMask* mask, SkScalar sigma, SkBlurStyle style,
+                                     const SkMaskFilterBase::PathKey& path,
+                                     SkStrokeRec::InitStyle initStyle) {
+    SkCachedData* cache = copy_mask_to_cacheddata(mask);
+    if (cache) {
+        SkMaskCache::Add(sigma, style, path, initStyle, *mask, cache);
+    }
+    return cache;
+}
+
 static SkCachedData* find_cached_rects(SkMask* mask, SkScalar sigma, SkBlurStyle style,
                                        const SkRect rects[], int count) {
     return SkMaskCache::FindAndRef(sigma, style, rects, count, mask);
@@ -699,6 +718,44 @@ SkBlurMaskFilterImpl::filterRectsToNine(const SkRect rects[], int count,
     return kTrue_FilterReturn;
 }
 
+// Larger paths are blurred per draw, clipped, rather than cached whole
+static const SkScalar kMAX_CACHED_PATH_AREA = SkIntToScalar(1024 * 1024);
+
+SkCachedData* SkBlurMaskFilterImpl::filterPathToCachedMask(const SkPath& devPath,
+                                                           const PathKey& path,
+                                                           const SkMatrix& matrix,
+                                                           SkStrokeRec::InitStyle initStyle,
+                                                           SkMask* mask) const {
+    const SkScalar sigma = this->computeXformedSigma(matrix);
+    SkCachedData* cache = SkMaskCache::FindAndRef(sigma, fBlurStyle, path, initStyle, mask);
+    if (cache) {
+        return cache;
+    }
+
+    const SkRect& bounds = devPath.getBounds();
+    if (bounds.width() * bounds.height() > kMAX_CACHED_PATH_AREA) {
+        return nullptr;
+    }
+
+    // Render the whole mask, so later draws with another clip can reuse it
+    SkMask srcM;
+    if (!SkDraw::DrawToMask(devPath, nullptr, this, &matrix, &srcM,
+                            SkMask::kComputeBoundsAndRenderImage_CreateMode, initStyle)) {
+        return nullptr;
+    }
+    SkAutoMaskFreeImage autoSrc(srcM.fImage);
+
+    if (!this->filterMask(mask, srcM, matrix, nullptr)) {
+        return nullptr;
+    }
+    cache = add_cached_path(mask, sigma, fBlurStyle, path, initStyle);
+    if (!cache) {
+        SkMask::FreeImage(mask->fImage);
+        mask->fImage = nullptr;
+    }
+    return cache;
+}
+
 void SkBlurMaskFilterImpl::computeFastBounds(const SkRect& src,
                                              SkRect* dst) const {
     SkScalar pad = 3.0f * fSigma;
@@ -996,9 +1053,11 @@ void sk_register_blur_maskfilter_createproc() {
 }
 
 sk_sp<SkMaskFilter> SkMaskFilter::MakeBlur(SkBlurStyle style, SkScalar sigma,
-                                           const SkRect& occluder, bool respectCTM) {
+                                           const SkRect& occluder, bool respectCTM,
+                                           SkExecutor* executor) {
     if (SkScalarIsFinite(sigma) && sigma > 0) {
-        return sk_sp<SkMaskFilter>(new SkBlurMaskFilterImpl(sigma, style, occluder, respectCTM));
+        return sk_sp<SkMaskFilter>(new SkBlurMaskFilterImpl(sigma, style, occluder, respectCTM,
+                                                            executor));
     }
     return nullptr;
 }
@@ -101,7 +101,7 @@ void SkMask_FreeImage(uint8_t* image) {
 }
 
 bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src, SkScalar sigma, SkBlurStyle style,
-                         SkIPoint* margin) {
+                         SkIPoint* margin, SkExecutor* executor) {
     if (src.fFormat != SkMask::kBW_Format &&
         src.fFormat != SkMask::kA8_Format &&
         src.fFormat != SkMask::kARGB32_Format &&
@@ -110,7 +110,7 @@ bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src, SkScalar sigma, SkBlurS
         return false;
     }
 
-    SkMaskBlurFilter blurFilter{sigma, sigma};
+    SkMaskBlurFilter blurFilter{sigma, sigma, executor};
     if (blurFilter.hasNoBlur()) {
         // If there is no effective blur most styles will just produce the original mask.
         // However, kOuter_SkBlurStyle will produce an empty mask.
@@ -58,7 +58,14 @@ public:
     int  count(int y) const { this->checkY(y); return fCounts[y]; }
     bool sorted(int y) const { this->checkY(y); return fSorted[y]; }
 
-    SK_ALWAYS_INLINE void addDelta(int x, int y, SkFixed delta) { this->push_back(y, {x, delta}); }
+    SK_ALWAYS_INLINE void addDelta(int x, int y, SkFixed delta) {
+        this->push_back(y, {x, delta}, fAlloc);
+    }
+    // Grows row y in alloc instead of the list's own arena, so threads adding to disjoint rows,
+    // each with its own alloc, can fill one list at once. alloc must outlive the list.
+    SK_ALWAYS_INLINE void addDelta(int x, int y, SkFixed delta, SkArenaAlloc* alloc) {
+        this->push_back(y, {x, delta}, alloc);
+    }
     SK_ALWAYS_INLINE const SkCoverageDelta& getDelta(int y, int i) const {
         this->checkY(y);
         SkASSERT(i < fCounts[y]);
@@ -92,11 +99,11 @@ private:
 
     void checkY(int y) const { SkASSERT(y >= fBounds.fTop && y < fBounds.fBottom); }
 
-    SK_ALWAYS_INLINE void push_back(int y, const SkCoverageDelta& delta) {
+    SK_ALWAYS_INLINE void push_back(int y, const SkCoverageDelta& delta, SkArenaAlloc* alloc) {
         this->checkY(y);
         if (fCounts[y] == fMaxCounts[y]) {
             fMaxCounts[y] *= 4;
-            SkCoverageDelta* newRow = fAlloc->makeArrayDefault<SkCoverageDelta>(fMaxCounts[y]);
+            SkCoverageDelta* newRow = alloc->makeArrayDefault<SkCoverageDelta>(fMaxCounts[y]);
             memcpy(newRow, fRows[y], sizeof(SkCoverageDelta) * fCounts[y]);
             fRows[y] = newRow;
         }
@@ -59,6 +59,25 @@ public:
         fChecksum = SkDescriptor::ComputeChecksum(this);
     }
 
+    // For descriptors read from untrusted bytes: the entries exactly fill getLength(),
+    // and the checksum matches them. The caller must have getLength() bytes readable.
+    bool isValid() const {
+        if (fLength < sizeof(SkDescriptor) || SkAlign4(fLength) != fLength) {
+            return false;
+        }
+        size_t remaining = fLength - sizeof(SkDescriptor);
+        const Entry* entry = (const Entry*)(this + 1);
+        for (uint32_t count = fCount; count > 0; count--) {
+            if (remaining < sizeof(Entry) || remaining - sizeof(Entry) < entry->fLen ||
+                SkAlign4(entry->fLen) != entry->fLen) {
+                return false;
+            }
+            remaining -= sizeof(Entry) + entry->fLen;
+            entry = (const Entry*)((const char*)(entry + 1) + entry->fLen);
+        }
+        return remaining == 0 && SkDescriptor::ComputeChecksum(this) == fChecksum;
+    }
+
 #ifdef SK_DEBUG
     void assertChecksum() const {
         SkASSERT(SkDescriptor::ComputeChecksum(this) == fChecksum);
@@ -40,6 +40,7 @@
 #include "SkUtils.h"
 
 #include <utility>
+#include <vector>
 
 static SkPaint make_paint_with_image(
     const SkPaint& origPaint, const SkBitmap& bitmap, SkMatrix* matrix = nullptr) {
@@ -956,8 +957,232 @@ SkScalar SkDraw::ComputeResScaleForStroking(const SkMatrix& matrix) {
     return 1;
 }
 
+// Drops the rows outside the tile and passes everything else through untouched. Unlike
+// SkRectClipBlitter it never rewrites a call (e.g. an opaque-edged blitAntiRect into a blitRect),
+// so a tile blits exactly what an untiled draw would, down to the rounding of each blit proc.
+class TileRowsBlitter : public SkBlitter {
+public:
+    TileRowsBlitter(SkBlitter* blitter, const SkIRect& tile)
+        : fBlitter(blitter), fTile(tile) {}
+
+    void blitH(int x, int y, int width) override {
+        if (this->hasRow(y)) {
+            fBlitter->blitH(x, y, width);
+        }
+    }
+    void blitAntiH(int x, int y, const SkAlpha aa[], const int16_t runs[]) override {
+        if (this->hasRow(y)) {
+            fBlitter->blitAntiH(x, y, aa, runs);
+        }
+    }
+    void blitAntiH2(int x, int y, U8CPU a0, U8CPU a1) override {
+        if (this->hasRow(y)) {
+            fBlitter->blitAntiH2(x, y, a0, a1);
+        }
+    }
+    void blitAntiV2(int x, int y, U8CPU a0, U8CPU a1) override {
+        if (this->hasRow(y) && this->hasRow(y + 1)) {
+            fBlitter->blitAntiV2(x, y, a0, a1);
+        } else if (this->hasRow(y)) {
+            this->blitLonePixel(x, y, a0);
+        } else if (this->hasRow(y + 1)) {
+            this->blitLonePixel(x, y + 1, a1);
+        }
+    }
+    void blitV(int x, int y, int height, SkAlpha alpha) override {
+        int bottom = y + height;
+        if (this->trim(&y, &bottom)) {
+            fBlitter->blitV(x, y, bottom - y, alpha);
+        }
+    }
+    void blitRect(int x, int y, int width, int height) override {
+        int bottom = y + height;
+        if (this->trim(&y, &bottom)) {
+            fBlitter->blitRect(x, y, width, bottom - y);
+        }
+    }
+    void blitAntiRect(int x, int y, int width, int height,
+                      SkAlpha leftAlpha, SkAlpha rightAlpha) override {
+        int bottom = y + height;
+        if (this->trim(&y, &bottom)) {
+            fBlitter->blitAntiRect(x, y, width, bottom - y, leftAlpha, rightAlpha);
+        }
+    }
+    void blitMask(const SkMask& mask, const SkIRect& clip) override {
+        SkIRect r = clip;
+        if (this->trim(&r.fTop, &r.fBottom)) {
+            fBlitter->blitMask(mask, r);
+        }
+    }
+    void blitCoverageDeltas(SkCoverageDeltaList* deltas, const SkIRect& clip,
+                            bool isEvenOdd, bool isInverse, bool isConvex) override {
+        SkIRect r = clip;
+        if (this->trim(&r.fTop, &r.fBottom)) {
+            fBlitter->blitCoverageDeltas(deltas, r, isEvenOdd, isInverse, isConvex);
+        }
+    }
+    const SkPixmap* justAnOpaqueColor(uint32_t* value) override {
+        return fBlitter->justAnOpaqueColor(value);
+    }
+    int requestRowsPreserved() const override {
+        return fBlitter->requestRowsPreserved();
+    }
+    void* allocBlitMemory(size_t sz) override {
+        return fBlitter->allocBlitMemory(sz);
+    }
+
+private:
+    bool hasRow(int y) const { return y >= fTile.fTop && y < fTile.fBottom; }
+
+    bool trim(int* top, int* bottom) const {
+        *top = SkTMax(*top, fTile.fTop);
+        *bottom = SkTMin(*bottom, fTile.fBottom);
+        return *top < *bottom;
+    }
+
+    // Half of a blitAntiV2 that straddles the tile's top or bottom. blitV would round it
+    // differently from the pair (the ARGB32 blitters blend pairs with SkBlendARGB32), so pair
+    // it instead with a neighbour in the same row at zero coverage, which blitters leave as is.
+    void blitLonePixel(int x, int y, U8CPU alpha) {
+        if (x + 1 < fTile.fRight) {
+            fBlitter->blitAntiH2(x, y, alpha, 0);
+        } else if (x > fTile.fLeft) {
+            fBlitter->blitAntiH2(x - 1, y, 0, alpha);
+        } else {
+            fBlitter->blitV(x, y, 1, alpha);
+        }
+    }
+
+    SkBlitter*  fBlitter;
+    SkIRect     fTile;
+};
+
+// Records the blits of one scan conversion, so the threaded device's init-once phase walks a
+// path's edges once and each tile replays just the calls that reach its rows. Replaying the
+// same calls, in order, into the tile's blitter keeps tiles identical to an untiled draw.
+class BlitRecord : public SkBlitter {
+public:
+    explicit BlitRecord(SkArenaAlloc* alloc) : fAlloc(alloc), fMaxRunWidth(0) {}
+
+    void blitH(int x, int y, int width) override {
+        this->push(kH, x, y, width, 1);
+    }
+    void blitAntiH(int x, int y, const SkAlpha aa[], const int16_t runs[]) override {
+        // Only the run heads are ever read; keep those
+        int heads = 0, width = 0;
+        for (; runs[width] > 0; width += runs[width]) {
+            heads++;
+        }
+        Call* call = this->push(kAntiH, x, y, width, 1);
+        int16_t* keptRuns = fAlloc->makeArrayDefault<int16_t>(heads);
+        SkAlpha* keptAlpha = fAlloc->makeArrayDefault<SkAlpha>(heads);
+        for (int i = 0, at = 0; i < heads; at += runs[at], i++) {
+            keptRuns[i] = runs[at];
+            keptAlpha[i] = aa[at];
+        }
+        call->fRuns = keptRuns;
+        call->fAlpha = keptAlpha;
+        call->fCount = heads;
+        fMaxRunWidth = SkTMax(fMaxRunWidth, width);
+    }
+    void blitAntiH2(int x, int y, U8CPU a0, U8CPU a1) override {
+        this->push(kAntiH2, x, y, 2, 1, a0, a1);
+    }
+    void blitAntiV2(int x, int y, U8CPU a0, U8CPU a1) override {
+        this->push(kAntiV2, x, y, 1, 2, a0, a1);
+    }
+    void blitV(int x, int y, int height, SkAlpha alpha) override {
+        this->push(kV, x, y, 1, height, alpha);
+    }
+    void blitRect(int x, int y, int width, int height) override {
+        this->push(kRect, x, y, width, height);
+    }
+    void blitAntiRect(int x, int y, int width, int height,
+                      SkAlpha leftAlpha, SkAlpha rightAlpha) override {
+        this->push(kAntiRect, x, y, width, height, leftAlpha, rightAlpha);
+    }
+    void blitMask(const SkMask& mask, const SkIRect& clip) override {
+        SkMask* kept = fAlloc->make<SkMask>(mask);
+        size_t size = mask.computeTotalImageSize();
+        kept->fImage = fAlloc->makeArrayDefault<uint8_t>(size);
+        memcpy(kept->fImage, mask.fImage, size);
+        this->push(kMask, clip.fLeft, clip.fTop, clip.width(), clip.height())->fMask = kept;
+    }
+
+    void replay(SkBlitter* blitter, const SkIRect& tileBounds) const {
+        TileRowsBlitter tile(blitter, tileBounds);
+        // Blitters may split runs in place, so each replay rebuilds them
+        SkAutoSTMalloc<256, int16_t> runs(fMaxRunWidth + 1);
+        SkAutoSTMalloc<256, SkAlpha> alpha(fMaxRunWidth + 1);
+        for (const Call& call : fCalls) {
+            if (call.fY >= tileBounds.fBottom || call.fY + call.fHeight <= tileBounds.fTop) {
+                continue;
+            }
+            switch (call.fType) {
+                case kH:
+                    blitter->blitH(call.fX, call.fY, call.fWidth);
+                    break;
+                case kAntiH: {
+                    int at = 0;
+                    for (int i = 0; i < call.fCount; at += call.fRuns[i], i++) {
+                        runs[at] = call.fRuns[i];
+                        alpha[at] = call.fAlpha[i];
+                    }
+                    runs[at] = 0;
+                    blitter->blitAntiH(call.fX, call.fY, alpha.get(), runs.get());
+                    break;
+                }
+                case kAntiH2:
+                    blitter->blitAntiH2(call.fX, call.fY, call.fA0, call.fA1);
+                    break;
+                case kAntiV2:
+                    tile.blitAntiV2(call.fX, call.fY, call.fA0, call.fA1);
+                    break;
+                case kV:
+                    tile.blitV(call.fX, call.fY, call.fHeight, call.fA0);
+                    break;
+                case kRect:
+                    tile.blitRect(call.fX, call.fY, call.fWidth, call.fHeight);
+                    break;
+                case kAntiRect:
+                    tile.blitAntiRect(call.fX, call.fY, call.fWidth, call.fHeight,
+                                      call.fA0, call.fA1);
+                    break;
+                case kMask:
+                    tile.blitMask(*call.fMask, SkIRect::MakeXYWH(call.fX, call.fY,
+                                                                 call.fWidth, call.fHeight));
+                    break;
+            }
+        }
+    }
+
+private:
+    enum Type { kH, kAntiH, kAntiH2, kAntiV2, kV, kRect, kAntiRect, kMask };
+
+    struct Call {
+        Type            fType;
+        int             fX, fY, fWidth, fHeight;  // rows [fY, fY + fHeight) for culling
+        SkAlpha         fA0, fA1;
+        int             fCount;
+        const int16_t*  fRuns;
+        const SkAlpha*  fAlpha;
+        const SkMask*   fMask;
+    };
+
+    Call* push(Type type, int x, int y, int width, int height, U8CPU a0 = 0, U8CPU a1 = 0) {
+        fCalls.push_back({type, x, y, width, height, SkToU8(a0), SkToU8(a1), 0,
+                          nullptr, nullptr, nullptr});
+        return &fCalls.back();
+    }
+
+    SkArenaAlloc*       fAlloc;
+    std::vector<Call>   fCalls;
+    int                 fMaxRunWidth;
+};
+
 void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawCoverage,
-                         SkBlitter* customBlitter, bool doFill, SkInitOnceData* iData) const {
+                         SkBlitter* customBlitter, bool doFill, SkInitOnceData* iData,
+                         const SkMaskFilterBase::PathKey* pathKey) const {
     if (SkPathPriv::TooBigForMath(devPath)) {
         if (iData) {
             iData->setEmptyDrawFn();
@@ -975,7 +1200,8 @@ void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawC
     if (paint.getMaskFilter()) {
         SkStrokeRec::InitStyle style = doFill ? SkStrokeRec::kFill_InitStyle
         : SkStrokeRec::kHairline_InitStyle;
-        if (as_MFB(paint.getMaskFilter())->filterPath(devPath, *fMatrix, *fRC, blitter, style)) {
+        if (as_MFB(paint.getMaskFilter())->filterPath(devPath, *fMatrix, *fRC, blitter, style,
+                                                      pathKey)) {
             if (iData) {
                 iData->setEmptyDrawFn();
             }
@@ -983,7 +1209,7 @@ void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawC
         }
     }
 
-    void (*proc)(const SkPath&, const SkRasterClip&, SkBlitter*);
+    ScanProc proc;
     if (doFill) {
         if (paint.isAntiAlias()) {
             proc = SkScan::AntiFillPath;
@@ -1025,19 +1251,22 @@ void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawC
     }
 
     if (iData == nullptr) {
-        proc(devPath, *fRC, blitter); // proceed directly if we're not in threaded init-once
-    } else if (!doFill || !paint.isAntiAlias()) {
-        // We're in threaded init-once but we can't use DAA. Hence we'll stop here and hand all the
-        // remaining work to draw phase. This is a simple example of how to add init-once to
-        // existing drawXXX commands: simply send in SkInitOnceData, do as much init work as
-        // possible, and finally wrap the remaining work into iData->fElement->fDrawFn.
+        this->scanDevPath(proc, devPath, blitter); // proceed directly if not in threaded init-once
+    } else if (!doFill || !paint.isAntiAlias() || !SkScan::ShouldUseDAA(devPath)) {
+        // We're in threaded init-once but we can't use DAA. Scan convert here once anyway,
+        // against the whole clip, into a record of blits; each tile then replays only the ones
+        // that reach its rows, so tiles neither repeat the edge walk nor clip its edges.
         SkASSERT(customBlitter == nullptr);
-        devPath.updateBoundsCache(); // make it thread safe
-        iData->fElement->setDrawFn([proc, devPath, paint, drawCoverage](SkArenaAlloc* alloc,
+        BlitRecord* record = iData->fAlloc->make<BlitRecord>(iData->fAlloc);
+        proc(devPath, *fRC, record);
+        iData->fElement->setDrawFn([record, paint, drawCoverage](SkArenaAlloc* alloc,
                 const SkThreadedBMPDevice::DrawState& ds, const SkIRect& tileBounds) {
             SkThreadedBMPDevice::TileDraw tileDraw(ds, tileBounds);
+            if (tileDraw.fRC->isEmpty()) {
+                return;
+            }
             SkAutoBlitterChoose blitterStorage(tileDraw, nullptr, paint, drawCoverage);
-            proc(devPath, *tileDraw.fRC, blitterStorage.get());
+            record->replay(blitterStorage.get(), tileDraw.fRC->getBounds());
         });
     } else {
         // We can use DAA to do scan conversion in the init-once phase.
@@ -1055,6 +1284,49 @@ void SkDraw::drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawC
     }
 }
 
+void SkDraw::scanDevPath(ScanProc proc, const SkPath& devPath, SkBlitter* blitter) const {
+    if (!fPathRC) {
+        proc(devPath, *fRC, blitter);
+        return;
+    }
+    if (fRC->isEmpty()) {
+        return;
+    }
+    // Paths the threaded device doesn't init-once (small ones, and ones with a mask filter; see
+    // SkThreadedBMPDevice::drawPath) get here from every tile: each walks the whole path against
+    // the full clip, whose columns it shares (tiles are full-width bands), and only the rows it
+    // owns reach the blitter.
+    TileRowsBlitter tileBlitter(blitter, fRC->getBounds());
+    proc(devPath, *fPathRC, &tileBlitter);
+}
+
+// Describes the device path drawPath() is about to build, so a mask filter can cache its
+// result. Only stable geometry qualifies: a non-volatile source path, no path effect (those
+// may depend on the clip) and an affine matrix whose translation fits in an int.
+static bool init_mask_filter_path_key(const SkPath& srcPath, const SkPaint& paint,
+                                      const SkMatrix& matrix, SkMaskFilterBase::PathKey* key) {
+    if (srcPath.isVolatile() || srcPath.isInverseFillType() || paint.getPathEffect() ||
+        matrix.hasPerspective()) {
+        return false;
+    }
+    SkScalar tx = SkScalarFloorToScalar(matrix.getTranslateX());
+    SkScalar ty = SkScalarFloorToScalar(matrix.getTranslateY());
+    if (!SkScalarIsFinite(tx) || !SkScalarIsFinite(ty) ||
+        SkScalarAbs(tx) > SK_MaxS32FitsInFloat || SkScalarAbs(ty) > SK_MaxS32FitsInFloat) {
+        return false;
+    }
+    key->fSrcPath = &srcPath;
+    key->fMatrix = matrix;
+    key->fMatrix.postTranslate(-tx, -ty);
+    key->fOffset = SkIPoint::Make(SkScalarTruncToInt(tx), SkScalarTruncToInt(ty));
+    key->fStrokeWidth = paint.getStrokeWidth();
+    key->fStrokeMiter = paint.getStrokeMiter();
+    key->fStyle = paint.getStyle();
+    key->fCap = paint.getStrokeCap();
+    key->fJoin = paint.getStrokeJoin();
+    return true;
+}
+
 void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
                       const SkMatrix* prePathMatrix, bool pathIsMutable,
                       bool drawCoverage, SkBlitter* customBlitter,
@@ -1081,6 +1353,7 @@ void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
     tmpPath->setIsVolatile(true);
     SkPathPriv::SetIsBadForDAA(*tmpPath, SkPathPriv::IsBadForDAA(origSrcPath));
 
+    const bool hasPrePathMatrix = prePathMatrix != nullptr;
     if (prePathMatrix) {
         if (origPaint.getPathEffect() || origPaint.getStyle() != SkPaint::kFill_Style) {
             SkPath* result = pathPtr;
@@ -1136,13 +1409,22 @@ void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
         pathPtr = tmpPath;
     }
 
+    // Threaded (iData) draws keep using the uncached path
+    SkMaskFilterBase::PathKey pathKey;
+    const SkMaskFilterBase::PathKey* pathKeyPtr = nullptr;
+    if (paint->getMaskFilter() && !hasPrePathMatrix && !iData &&
+        init_mask_filter_path_key(origSrcPath, *paint, *matrix, &pathKey)) {
+        pathKeyPtr = &pathKey;
+    }
+
     // avoid possibly allocating a new path in transform if we can
     SkPath* devPathPtr = pathIsMutable ? pathPtr : tmpPath;
 
     // transform the path into device space
     pathPtr->transform(*matrix, devPathPtr);
 
-    this->drawDevPath(*devPathPtr, *paint, drawCoverage, customBlitter, doFill, iData);
+    this->drawDevPath(*devPathPtr, *paint, drawCoverage, customBlitter, doFill, iData,
+                      pathKeyPtr);
 }
 
 void SkDraw::drawBitmapAsMask(const SkBitmap& bitmap, const SkPaint& paint) const {
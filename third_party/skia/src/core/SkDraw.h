@@ -12,6 +12,7 @@
 
 #include "SkCanvas.h"
 #include "SkMask.h"
+#include "SkMaskFilterBase.h"
 #include "SkPaint.h"
 #include "SkPixmap.h"
 #include "SkStrokeRec.h"
@@ -129,7 +130,8 @@ private:
 
     void drawLine(const SkPoint[2], const SkPaint&) const;
     void drawDevPath(const SkPath& devPath, const SkPaint& paint, bool drawCoverage,
-                     SkBlitter* customBlitter, bool doFill, SkInitOnceData* iData = nullptr) const;
+                     SkBlitter* customBlitter, bool doFill, SkInitOnceData* iData = nullptr,
+                     const SkMaskFilterBase::PathKey* pathKey = nullptr) const;
     /**
      *  Return the current clip bounds, in local coordinates, with slop to account
      *  for antialiasing or hairlines (i.e. device-bounds outset by 1, and then
@@ -144,6 +146,9 @@ private:
     /** Returns the current setting for using fake gamma and contrast. */
     SkScalerContextFlags SK_WARN_UNUSED_RESULT scalerContextFlags() const;
 
+    using ScanProc = void (*)(const SkPath&, const SkRasterClip&, SkBlitter*);
+    void scanDevPath(ScanProc, const SkPath& devPath, SkBlitter*) const;
+
 public:
     SkPixmap        fDst;
     const SkMatrix* fMatrix;        // required
@@ -152,6 +157,11 @@ public:
     // optional, will be same dimensions as fDst if present
     const SkPixmap* fCoverage = nullptr;
 
+    // optional: paths are scan converted against this clip, then clipped to fRC's bounds.
+    // Tiles set it to the whole device's clip, so an edge crossing a tile boundary isn't
+    // chopped there and steps exactly as it does untiled.
+    const SkRasterClip* fPathRC = nullptr;
+
 #ifdef SK_DEBUG
     void validate() const;
 #else
@@ -11,6 +11,7 @@
 #include "SkSemaphore.h"
 #include "SkSpinlock.h"
 #include "SkTArray.h"
+#include <atomic>
 #include <deque>
 #include <thread>
 
@@ -30,11 +31,19 @@
 
 SkExecutor::~SkExecutor() {}
 
+void SkExecutor::addTask(void (*fn)(void*), void* ctx) {
+    // Small and trivially copyable, so this std::function does not allocate either.
+    this->add([fn, ctx] { fn(ctx); });
+}
+
 // The default default SkExecutor is an SkTrivialExecutor, which just runs the work right away.
 class SkTrivialExecutor final : public SkExecutor {
     void add(std::function<void(void)> work) override {
         work();
     }
+    void addTask(void (*fn)(void*), void* ctx) override {
+        fn(ctx);
+    }
 };
 
 static SkTrivialExecutor gTrivial;
@@ -131,6 +140,226 @@ private:
     SkSemaphore           fWorkAvailable;
 };
 
+// A Chase-Lev work-stealing deque (as in "Correct and Efficient Work-Stealing for Weak Memory
+// Models", Le et al. 2013). Its owner pushes and pops at the bottom, any thread steals from the
+// top. Work is two words, each slot an atomic, so a stealer racing the owner reads stale but
+// well-defined values, which it throws away when it loses the race on fTop.
+class SkWorkStealingDeque {
+public:
+    struct Work {
+        void (*fFn)(void*);
+        void* fCtx;
+    };
+
+    enum StealResult { kEmpty, kLost, kStolen };
+
+    SkWorkStealingDeque() : fTop(0), fBottom(0), fArray(new Array(kInitialCapacity)) {}
+    ~SkWorkStealingDeque() { delete fArray.load(std::memory_order_relaxed); }
+
+    // Owner only.
+    void push(const Work& work) {
+        int64_t b = fBottom.load(std::memory_order_relaxed);
+        int64_t t = fTop.load(std::memory_order_acquire);
+        Array* array = fArray.load(std::memory_order_relaxed);
+        if (b - t > array->fMask) {
+            array = this->grow(array, t, b);
+        }
+        array->put(b, work);
+        fBottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only.
+    bool pop(Work* work) {
+        int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+        Array* array = fArray.load(std::memory_order_relaxed);
+        fBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = fTop.load(std::memory_order_relaxed);
+        if (t > b) {
+            fBottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        *work = array->get(b);
+        if (t == b) {
+            // The last one; race the stealers for it.
+            bool won = fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            fBottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    StealResult steal(Work* work) {
+        int64_t t = fTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = fBottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return kEmpty;
+        }
+        *work = fArray.load(std::memory_order_acquire)->get(t);
+        if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return kLost;
+        }
+        return kStolen;
+    }
+
+private:
+    static constexpr int kInitialCapacity = 256;
+
+    struct Array {
+        explicit Array(int64_t capacity) : fMask(capacity - 1), fSlots(new Slot[capacity]) {}
+
+        void put(int64_t i, const Work& work) {
+            Slot& slot = fSlots[i & fMask];
+            slot.fFn.store(work.fFn, std::memory_order_relaxed);
+            slot.fCtx.store(work.fCtx, std::memory_order_relaxed);
+        }
+        Work get(int64_t i) const {
+            const Slot& slot = fSlots[i & fMask];
+            return { slot.fFn.load(std::memory_order_relaxed),
+                     slot.fCtx.load(std::memory_order_relaxed) };
+        }
+
+        struct Slot {
+            std::atomic<void (*)(void*)> fFn;
+            std::atomic<void*>           fCtx;
+        };
+
+        const int64_t            fMask;
+        std::unique_ptr<Slot[]>  fSlots;
+    };
+
+    Array* grow(Array* array, int64_t t, int64_t b) {
+        Array* bigger = new Array(2 * (array->fMask + 1));
+        for (int64_t i = t; i < b; i++) {
+            bigger->put(i, array->get(i));
+        }
+        // Stealers may still be reading the old array; keep it until we're gone.
+        fRetired.emplace_back(array);
+        fArray.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    std::atomic<int64_t>               fTop;
+    std::atomic<int64_t>               fBottom;
+    std::atomic<Array*>                fArray;
+    SkTArray<std::unique_ptr<Array>>   fRetired;
+};
+
+class SkWorkStealingThreadPool;
+
+// Which pool's thread this is, and its deque there.
+static thread_local SkWorkStealingThreadPool* gWorkerPool = nullptr;
+static thread_local int gWorkerIndex = -1;
+
+// An SkWorkStealingThreadPool gives each of its threads a deque of work. Work added by other
+// threads goes to a shared deque, the only one whose pushes take a lock. As in SkThreadPool,
+// fWorkAvailable counts the work queued, so a thread that gets past it is owed work from one of
+// the deques.
+class SkWorkStealingThreadPool final : public SkExecutor {
+public:
+    explicit SkWorkStealingThreadPool(int threads)
+            : fThreadCnt(threads)
+            , fDeques(new SkWorkStealingDeque[threads]) {
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&Loop, this, i);
+        }
+    }
+
+    ~SkWorkStealingThreadPool() override {
+        // Wake each thread; any that finds no work left shuts down.
+        fShuttingDown.store(true);
+        fWorkAvailable.signal(fThreadCnt);
+        for (int i = 0; i < fThreadCnt; i++) {
+            fThreads[i].join();
+        }
+        // Run whatever the threads left behind, as the FIFO pool would have.
+        Work work;
+        while (this->find(-1, &work)) {
+            work.fFn(work.fCtx);
+        }
+    }
+
+    // The deque slots hold two words, so this copies |work| to the heap. Prefer addTask for
+    // work added often.
+    void add(std::function<void(void)> work) override {
+        this->addTask([](void* ctx) {
+            std::unique_ptr<std::function<void(void)>> work((std::function<void(void)>*)ctx);
+            (*work)();
+        }, new std::function<void(void)>(std::move(work)));
+    }
+
+    void addTask(void (*fn)(void*), void* ctx) override {
+        int self = this->workerIndex();
+        if (self >= 0) {
+            fDeques[self].push({fn, ctx});
+        } else {
+            SkAutoExclusive lock(fSharedLock);
+            fShared.push({fn, ctx});
+        }
+        fWorkAvailable.signal(1);
+    }
+
+    void borrow() override {
+        // If there is work waiting, do it.
+        if (fWorkAvailable.try_wait()) {
+            int self = this->workerIndex();
+            Work work;
+            while (!this->find(self, &work)) {}
+            work.fFn(work.fCtx);
+        }
+    }
+
+private:
+    using Work = SkWorkStealingDeque::Work;
+
+    int workerIndex() const { return gWorkerPool == this ? gWorkerIndex : -1; }
+
+    // Our own newest work first, then the oldest of the shared deque and of each other thread.
+    // May miss work while losing races for it; callers owed work just look again.
+    bool find(int self, Work* work) {
+        if (self >= 0 && fDeques[self].pop(work)) {
+            return true;
+        }
+        if (fShared.steal(work) == SkWorkStealingDeque::kStolen) {
+            return true;
+        }
+        for (int i = 1; i <= fThreadCnt; i++) {
+            int victim = (self + i) % fThreadCnt;
+            if (victim != self && fDeques[victim].steal(work) == SkWorkStealingDeque::kStolen) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void Loop(SkWorkStealingThreadPool* pool, int index) {
+        gWorkerPool = pool;
+        gWorkerIndex = index;
+        for (;;) {
+            pool->fWorkAvailable.wait();
+            Work work;
+            while (!pool->find(index, &work)) {
+                if (pool->fShuttingDown.load()) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            work.fFn(work.fCtx);
+        }
+    }
+
+    const int                               fThreadCnt;
+    SkTArray<std::thread>                   fThreads;
+    std::unique_ptr<SkWorkStealingDeque[]>  fDeques;
+    SkWorkStealingDeque                     fShared;
+    SkSpinlock                              fSharedLock;
+    SkSemaphore                             fWorkAvailable;
+    std::atomic<bool>                       fShuttingDown{false};
+};
+
 std::unique_ptr<SkExecutor> SkExecutor::MakeFIFOThreadPool(int threads) {
     using WorkList = std::deque<std::function<void(void)>>;
     return skstd::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores());
@@ -139,3 +368,6 @@ std::unique_ptr<SkExecutor> SkExecutor::MakeLIFOThreadPool(int threads) {
     using WorkList = SkTArray<std::function<void(void)>>;
     return skstd::make_unique<SkThreadPool<WorkList>>(threads > 0 ? threads : num_cores());
 }
+std::unique_ptr<SkExecutor> SkExecutor::MakeWorkStealingThreadPool(int threads) {
+    return skstd::make_unique<SkWorkStealingThreadPool>(threads > 0 ? threads : num_cores());
+}
@@ -142,6 +142,10 @@ public:
 
     SkScalerContext* getScalerContext() const { return fScalerContext.get(); }
 
+    /** Call fn(const SkGlyph&) for every glyph in the cache, in no particular order. */
+    template <typename Fn>
+    void forEachGlyph(Fn&& fn) const { fGlyphMap.foreach(std::forward<Fn>(fn)); }
+
 #ifdef SK_DEBUG
     void forceValidate() const;
     void validate() const;
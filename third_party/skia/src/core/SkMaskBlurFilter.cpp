@@ -12,6 +12,8 @@
 #include "SkGaussFilter.h"
 #include "SkMalloc.h"
 #include "SkNx.h"
+#include "SkOpts.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkTo.h"
 
@@ -89,6 +91,21 @@ public:
 
     int    border()     const { return fBorder; }
 
+    // The SkOpts kernels keep the weight in 32 bits and need every pass to have a buffer.
+    bool canBlurA8Rows() const {
+        return fWeight <= UINT32_MAX && fPass0Size > 0 && fPass1Size > 0 && fPass2Size > 0;
+    }
+
+    // Same result as running a Scan over each of the rows, but several rows at a time.
+    void blurA8Rows(const uint8_t* src, size_t srcRB, int srcW, int rows,
+                    uint8_t* dst, size_t dstRB, int dstW) const {
+        SkASSERT(this->canBlurA8Rows());
+        int noChangeCount = fSlidingWindow > srcW ? fSlidingWindow - srcW : 0;
+        SkOpts::box_blur_a8_transposed(SkTo<uint32_t>(fWeight),
+                                       fPass0Size, fPass1Size, fPass2Size, noChangeCount,
+                                       src, srcRB, srcW, rows, dst, dstRB, dstW);
+    }
+
 public:
     class Scan {
     public:
@@ -248,9 +265,10 @@ public:
 //
 //   window = floor(sigma * 3 * sqrt(2 * kPi) / 4 + 0.5)
 //   For window <= 255, the largest value for sigma is 136.
-SkMaskBlurFilter::SkMaskBlurFilter(double sigmaW, double sigmaH)
+SkMaskBlurFilter::SkMaskBlurFilter(double sigmaW, double sigmaH, SkExecutor* executor)
     : fSigmaW{SkTPin(sigmaW, 0.0, 136.0)}
     , fSigmaH{SkTPin(sigmaH, 0.0, 136.0)}
+    , fExecutor{executor}
 {
     SkASSERT(sigmaW >= 0);
     SkASSERT(sigmaH >= 0);
@@ -949,6 +967,32 @@ static SkIPoint small_blur(double sigmaX, double sigmaY, const SkMask& src, SkMa
     return {radiusX, radiusY};
 }
 
+// Masks with fewer pixels than this are blurred on the calling thread even when there is an
+// executor; for them, handing out the bands costs more than it saves.
+static constexpr int kMinParallelPixels = 256 * 256;
+
+// Rows per band when running in parallel. A multiple of the SkOpts kernel width, so only the
+// last band ends in a partial group of rows.
+static constexpr int kRowsPerBand = 32;
+
+// Call fn(yBegin, yEnd) for bands of rows covering [0, count), on the executor if there is one.
+// Every row of a pass is scanned on its own, so the bands need no overlap.
+template <typename Fn>
+static void for_each_band(SkExecutor* executor, int count, Fn&& fn) {
+    int bands = (count + kRowsPerBand - 1) / kRowsPerBand;
+    if (executor == nullptr || bands <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    SkTaskGroup tasks{*executor};
+    tasks.batch(bands, [&](int band) {
+        int yBegin = band * kRowsPerBand;
+        fn(yBegin, std::min(count, yBegin + kRowsPerBand));
+    });
+    tasks.wait();
+}
+
 // TODO: assuming sigmaW = sigmaH. Allow different sigmas. Right now the
 // API forces the sigmas to be the same.
 SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
@@ -982,8 +1026,10 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
         dstH = dst->fBounds.height();
     SkASSERT(srcW >= 0 && srcH >= 0 && dstW >= 0 && dstH >= 0);
 
-    auto bufferSize = std::max(planW.bufferSize(), planH.bufferSize());
-    auto buffer = alloc.makeArrayDefault<uint32_t>(bufferSize);
+    SkExecutor* executor = fExecutor;
+    if (static_cast<int64_t>(dstW) * dstH < kMinParallelPixels) {
+        executor = nullptr;
+    }
 
     // Blur both directions.
     int tmpW = srcH,
@@ -992,58 +1038,82 @@ SkIPoint SkMaskBlurFilter::blur(const SkMask& src, SkMask* dst) const {
     auto tmp = alloc.makeArrayDefault<uint8_t>(tmpW * tmpH);
 
     // Blur horizontally, and transpose.
-    const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer);
-    switch (src.fFormat) {
-        case SkMask::kBW_Format: {
-            const uint8_t* bwStart = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0);
-            auto end = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        case SkMask::kA8_Format: {
-            const uint8_t* a8Start = src.fImage;
-            auto start = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start);
-            auto end = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        case SkMask::kARGB32_Format: {
-            const uint32_t* argbStart = reinterpret_cast<const uint32_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart);
-            auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        case SkMask::kLCD16_Format: {
-            const uint16_t* lcdStart = reinterpret_cast<const uint16_t*>(src.fImage);
-            auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart);
-            auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW);
-            for (int y = 0; y < srcH; ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
-                auto tmpStart = &tmp[y];
-                scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
-            }
-        } break;
-        default:
-            SK_ABORT("Unhandled format.");
-    }
+    for_each_band(executor, srcH, [&](int yBegin, int yEnd) {
+        const uint8_t* srcRows = src.fImage + yBegin * src.fRowBytes;
+        if (src.fFormat == SkMask::kA8_Format && planW.canBlurA8Rows()) {
+            planW.blurA8Rows(srcRows, src.fRowBytes, srcW, yEnd - yBegin,
+                             &tmp[yBegin], tmpW, tmpH);
+            return;
+        }
+
+        // Each band has its own buffer, so the bands can scan at the same time.
+        SkAutoTMalloc<uint32_t> buffer(planW.bufferSize());
+        const PlanGauss::Scan& scanW = planW.makeBlurScan(srcW, buffer.get());
+        switch (src.fFormat) {
+            case SkMask::kBW_Format: {
+                const uint8_t* bwStart = srcRows;
+                auto start = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart, 0);
+                auto end = SkMask::AlphaIter<SkMask::kBW_Format>(bwStart + (srcW / 8), srcW % 8);
+                for (int y = yBegin; y < yEnd;
+                     ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
+                    auto tmpStart = &tmp[y];
+                    scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+                }
+            } break;
+            case SkMask::kA8_Format: {
+                const uint8_t* a8Start = srcRows;
+                auto start = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start);
+                auto end = SkMask::AlphaIter<SkMask::kA8_Format>(a8Start + srcW);
+                for (int y = yBegin; y < yEnd;
+                     ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
+                    auto tmpStart = &tmp[y];
+                    scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+                }
+            } break;
+            case SkMask::kARGB32_Format: {
+                const uint32_t* argbStart = reinterpret_cast<const uint32_t*>(srcRows);
+                auto start = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart);
+                auto end = SkMask::AlphaIter<SkMask::kARGB32_Format>(argbStart + srcW);
+                for (int y = yBegin; y < yEnd;
+                     ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
+                    auto tmpStart = &tmp[y];
+                    scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+                }
+            } break;
+            case SkMask::kLCD16_Format: {
+                const uint16_t* lcdStart = reinterpret_cast<const uint16_t*>(srcRows);
+                auto start = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart);
+                auto end = SkMask::AlphaIter<SkMask::kLCD16_Format>(lcdStart + srcW);
+                for (int y = yBegin; y < yEnd;
+                     ++y, start >>= src.fRowBytes, end >>= src.fRowBytes) {
+                    auto tmpStart = &tmp[y];
+                    scanW.blur(start, end, tmpStart, tmpW, tmpStart + tmpW * tmpH);
+                }
+            } break;
+            default:
+                SK_ABORT("Unhandled format.");
+        }
+    });
 
     // Blur vertically (scan in memory order because of the transposition),
     // and transpose back to the original orientation.
-    const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer);
-    for (int y = 0; y < tmpH; y++) {
-        auto tmpStart = &tmp[y * tmpW];
-        auto dstStart = &dst->fImage[y];
+    for_each_band(executor, tmpH, [&](int yBegin, int yEnd) {
+        if (planH.canBlurA8Rows()) {
+            planH.blurA8Rows(&tmp[yBegin * tmpW], tmpW, tmpW, yEnd - yBegin,
+                             &dst->fImage[yBegin], dst->fRowBytes, dstH);
+            return;
+        }
 
-        scanH.blur(tmpStart, tmpStart + tmpW,
-                   dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
-    }
+        SkAutoTMalloc<uint32_t> buffer(planH.bufferSize());
+        const PlanGauss::Scan& scanH = planH.makeBlurScan(tmpW, buffer.get());
+        for (int y = yBegin; y < yEnd; y++) {
+            auto tmpStart = &tmp[y * tmpW];
+            auto dstStart = &dst->fImage[y];
+
+            scanH.blur(tmpStart, tmpStart + tmpW,
+                       dstStart, dst->fRowBytes, dstStart + dst->fRowBytes * dstH);
+        }
+    });
 
     return {SkTo<int32_t>(borderW), SkTo<int32_t>(borderH)};
 }
@@ -15,13 +15,16 @@
 #include "SkMask.h"
 #include "SkTypes.h"
 
+class SkExecutor;
+
 // Implement a single channel Gaussian blur. The specifics for implementation are taken from:
 // https://drafts.fxtf.org/filters/#feGaussianBlurElement
 class SkMaskBlurFilter {
 public:
     // Create an object suitable for filtering an SkMask using a filter with width sigmaW and
-    // height sigmaH.
-    SkMaskBlurFilter(double sigmaW, double sigmaH);
+    // height sigmaH. With an executor, large masks are blurred in bands of rows on its threads;
+    // the result is the same either way.
+    SkMaskBlurFilter(double sigmaW, double sigmaH, SkExecutor* executor = nullptr);
 
     // returns true iff the sigmas will result in an identity mask (no blurring)
     bool hasNoBlur() const;
@@ -32,6 +35,7 @@ public:
 private:
     const double fSigmaW;
     const double fSigmaH;
+    SkExecutor*  fExecutor;
 };
 
 #endif  // SkBlurMaskFilter_DEFINED
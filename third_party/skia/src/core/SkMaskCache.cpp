@@ -6,6 +6,9 @@
  */
 
 #include "SkMaskCache.h"
+#include "SkMutex.h"
+#include "SkPathPriv.h"
+#include "SkTHash.h"
 
 #define CHECK_LOCAL(localCache, localName, globalName, ...) \
     ((localCache) ? localCache->localName(__VA_ARGS__) : SkResourceCache::globalName(__VA_ARGS__))
@@ -183,3 +186,141 @@ void SkMaskCache::Add(SkScalar sigma, SkBlurStyle style,
     RectsBlurKey key(sigma, style, rects, count);
     return CHECK_LOCAL(localCache, add, Add, new RectsBlurRec(key, mask, data));
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+static unsigned gPathBlurKeyNamespaceLabel;
+
+static uint64_t make_path_blur_shared_id(uint32_t pathGenID) {
+    uint64_t sharedID = SkSetFourByteTag('p', 'b', 'l', 'r');
+    return (sharedID << 32) | pathGenID;
+}
+
+struct PathBlurKey : public SkResourceCache::Key {
+public:
+    PathBlurKey(SkScalar sigma, SkBlurStyle style, const SkMaskFilterBase::PathKey& path,
+                SkStrokeRec::InitStyle initStyle)
+        : fSigma(sigma)
+        , fStyle(style)
+        , fGenID(path.fSrcPath->getGenerationID())
+        , fFillType(path.fSrcPath->getFillType())
+        , fStrokeWidth(path.fStrokeWidth)
+        , fStrokeMiter(path.fStrokeMiter)
+        , fStrokeFlags(path.fStyle | (path.fCap << 4) | (path.fJoin << 8) | (initStyle << 12))
+    {
+        path.fMatrix.get9(fMatrix);
+        this->init(&gPathBlurKeyNamespaceLabel, make_path_blur_shared_id(fGenID),
+                   sizeof(fSigma) + sizeof(fStyle) + sizeof(fGenID) + sizeof(fFillType) +
+                   sizeof(fStrokeWidth) + sizeof(fStrokeMiter) + sizeof(fStrokeFlags) +
+                   sizeof(fMatrix));
+    }
+
+    SkScalar    fSigma;
+    int32_t     fStyle;
+    uint32_t    fGenID;
+    int32_t     fFillType;
+    SkScalar    fStrokeWidth;
+    SkScalar    fStrokeMiter;
+    int32_t     fStrokeFlags;
+    SkScalar    fMatrix[9];
+};
+
+struct PathBlurRec : public SkResourceCache::Rec {
+    PathBlurRec(PathBlurKey key, const SkMask& mask, SkCachedData* data)
+        : fKey(key)
+    {
+        fValue.fMask = mask;
+        fValue.fData = data;
+        fValue.fData->attachToCacheAndRef();
+    }
+    ~PathBlurRec() override {
+        fValue.fData->detachFromCacheAndUnref();
+    }
+
+    PathBlurKey    fKey;
+    MaskValue      fValue;
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override { return sizeof(*this) + fValue.fData->size(); }
+    const char* getCategory() const override { return "path-blur"; }
+    SkDiscardableMemory* diagnostic_only_getDiscardable() const override {
+        return fValue.fData->diagnostic_only_getDiscardable();
+    }
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* contextData) {
+        const PathBlurRec& rec = static_cast<const PathBlurRec&>(baseRec);
+        MaskValue* result = static_cast<MaskValue*>(contextData);
+
+        SkCachedData* tmpData = rec.fValue.fData;
+        tmpData->ref();
+        if (nullptr == tmpData->data()) {
+            tmpData->unref();
+            return false;
+        }
+        *result = rec.fValue;
+        return true;
+    }
+};
+
+// Gen IDs of the paths with a PathBlurPurgeListener. SkPathRef's listener list is not
+// thread-safe, and a path can be drawn by several threads at once, so listeners are only
+// added under this lock, and only one per path, however many masks it has in the cache.
+SK_DECLARE_STATIC_MUTEX(gPathListenersMutex);
+static SkTHashSet<uint32_t>* gPathsWithListener;    // Guarded by gPathListenersMutex.
+
+// Drops a path's masks from the cache as soon as the path is edited or deleted,
+// rather than leaving them to age out of the budget.
+class PathBlurPurgeListener : public SkPathRef::GenIDChangeListener {
+public:
+    explicit PathBlurPurgeListener(uint32_t genID) : fGenID(genID) {}
+
+    void onChange() override {
+        {
+            SkAutoMutexAcquire lock(gPathListenersMutex);
+            gPathsWithListener->remove(fGenID);
+        }
+        SkResourceCache::PostPurgeSharedID(make_path_blur_shared_id(fGenID));
+    }
+
+private:
+    uint32_t fGenID;
+};
+
+static void add_path_blur_purge_listener(const SkPath& path, uint32_t genID) {
+    SkAutoMutexAcquire lock(gPathListenersMutex);
+    if (!gPathsWithListener) {
+        gPathsWithListener = new SkTHashSet<uint32_t>;
+    }
+    if (!gPathsWithListener->contains(genID)) {
+        gPathsWithListener->add(genID);
+        SkPathPriv::AddGenIDChangeListener(path, sk_make_sp<PathBlurPurgeListener>(genID));
+    }
+}
+} // namespace
+
+SkCachedData* SkMaskCache::FindAndRef(SkScalar sigma, SkBlurStyle style,
+                                      const SkMaskFilterBase::PathKey& path,
+                                      SkStrokeRec::InitStyle initStyle, SkMask* mask,
+                                      SkResourceCache* localCache) {
+    MaskValue result;
+    PathBlurKey key(sigma, style, path, initStyle);
+    if (!CHECK_LOCAL(localCache, find, Find, key, PathBlurRec::Visitor, &result)) {
+        return nullptr;
+    }
+
+    *mask = result.fMask;
+    mask->fBounds.offset(path.fOffset);
+    mask->fImage = (uint8_t*)(result.fData->data());
+    return result.fData;
+}
+
+void SkMaskCache::Add(SkScalar sigma, SkBlurStyle style,
+                      const SkMaskFilterBase::PathKey& path, SkStrokeRec::InitStyle initStyle,
+                      const SkMask& mask, SkCachedData* data, SkResourceCache* localCache) {
+    PathBlurKey key(sigma, style, path, initStyle);
+    SkMask keyMask = mask;
+    keyMask.fBounds.offset(-path.fOffset.fX, -path.fOffset.fY);
+    add_path_blur_purge_listener(*path.fSrcPath, key.fGenID);
+    return CHECK_LOCAL(localCache, add, Add, new PathBlurRec(key, keyMask, data));
+}
@@ -11,6 +11,7 @@
 #include "SkBlurTypes.h"
 #include "SkCachedData.h"
 #include "SkMask.h"
+#include "SkMaskFilterBase.h"
 #include "SkRect.h"
 #include "SkResourceCache.h"
 #include "SkRRect.h"
@@ -29,6 +30,14 @@ public:
     static SkCachedData* FindAndRef(SkScalar sigma, SkBlurStyle style,
                                     const SkRect rects[], int count, SkMask* mask,
                                     SkResourceCache* localCache = nullptr);
+    /**
+     * Path masks are cached relative to the integer offset of the PathKey; the returned
+     * mask bounds are already moved to this key's offset.
+     */
+    static SkCachedData* FindAndRef(SkScalar sigma, SkBlurStyle style,
+                                    const SkMaskFilterBase::PathKey& path,
+                                    SkStrokeRec::InitStyle initStyle, SkMask* mask,
+                                    SkResourceCache* localCache = nullptr);
 
     /**
      * Add a mask and its pixel-data to the cache.
@@ -39,6 +48,13 @@ public:
     static void Add(SkScalar sigma, SkBlurStyle style,
                     const SkRect rects[], int count, const SkMask& mask, SkCachedData* data,
                     SkResourceCache* localCache = nullptr);
+    /**
+     * Entries are purged once the source path's generation ID goes stale.
+     */
+    static void Add(SkScalar sigma, SkBlurStyle style,
+                    const SkMaskFilterBase::PathKey& path, SkStrokeRec::InitStyle initStyle,
+                    const SkMask& mask, SkCachedData* data,
+                    SkResourceCache* localCache = nullptr);
 };
 
 #endif
@@ -231,9 +231,25 @@ bool SkMaskFilterBase::filterRRect(const SkRRect& devRRect, const SkMatrix& matr
     return true;
 }
 
+static void blit_clipped_mask(const SkMask& mask, const SkRasterClip& clip, SkBlitter* blitter) {
+    // if we get here, we need to (possibly) resolve the clip and blitter
+    SkAAClipBlitterWrapper wrapper(clip, blitter);
+    blitter = wrapper.getBlitter();
+
+    SkRegion::Cliperator clipper(wrapper.getRgn(), mask.fBounds);
+
+    if (!clipper.done()) {
+        const SkIRect& cr = clipper.rect();
+        do {
+            blitter->blitMask(mask, cr);
+            clipper.next();
+        } while (!clipper.done());
+    }
+}
+
 bool SkMaskFilterBase::filterPath(const SkPath& devPath, const SkMatrix& matrix,
                                   const SkRasterClip& clip, SkBlitter* blitter,
-                                  SkStrokeRec::InitStyle style) const {
+                                  SkStrokeRec::InitStyle style, const PathKey* pathKey) const {
     SkRect rects[2];
     int rectCount = 0;
     if (SkStrokeRec::kFill_InitStyle == style) {
@@ -259,6 +275,16 @@ bool SkMaskFilterBase::filterPath(const SkPath& devPath, const SkMatrix& matrix,
         }
     }
 
+    if (pathKey) {
+        SkMask cachedM;
+        if (SkCachedData* data = this->filterPathToCachedMask(devPath, *pathKey, matrix, style,
+                                                              &cachedM)) {
+            blit_clipped_mask(cachedM, clip, blitter);
+            data->unref();
+            return true;
+        }
+    }
+
     SkMask  srcM, dstM;
 
     if (!SkDraw::DrawToMask(devPath, &clip.getBounds(), this, &matrix, &srcM,
@@ -273,20 +299,7 @@ bool SkMaskFilterBase::filterPath(const SkPath& devPath, const SkMatrix& matrix,
     }
     SkAutoMaskFreeImage autoDst(dstM.fImage);
 
-    // if we get here, we need to (possibly) resolve the clip and blitter
-    SkAAClipBlitterWrapper wrapper(clip, blitter);
-    blitter = wrapper.getBlitter();
-
-    SkRegion::Cliperator clipper(wrapper.getRgn(), dstM.fBounds);
-
-    if (!clipper.done()) {
-        const SkIRect& cr = clipper.rect();
-        do {
-            blitter->blitMask(dstM, cr);
-            clipper.next();
-        } while (!clipper.done());
-    }
-
+    blit_clipped_mask(dstM, clip, blitter);
     return true;
 }
 
@@ -302,6 +315,12 @@ SkMaskFilterBase::filterRectsToNine(const SkRect[], int count, const SkMatrix&,
     return kUnimplemented_FilterReturn;
 }
 
+SkCachedData* SkMaskFilterBase::filterPathToCachedMask(const SkPath&, const PathKey&,
+                                                       const SkMatrix&, SkStrokeRec::InitStyle,
+                                                       SkMask*) const {
+    return nullptr;
+}
+
 #if SK_SUPPORT_GPU
 std::unique_ptr<GrFragmentProcessor>
 SkMaskFilterBase::asFragmentProcessor(const GrFPArgs& args) const {
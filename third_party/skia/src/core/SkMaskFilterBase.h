@@ -12,7 +12,9 @@
 #include "SkFlattenable.h"
 #include "SkMask.h"
 #include "SkMaskFilter.h"
+#include "SkMatrix.h"
 #include "SkPaint.h"
+#include "SkPoint.h"
 #include "SkStrokeRec.h"
 
 class GrClip;
@@ -28,13 +30,29 @@ class GrTextureProxy;
 class SkBitmap;
 class SkBlitter;
 class SkCachedData;
-class SkMatrix;
 class SkPath;
 class SkRasterClip;
 class SkRRect;
 
 class SkMaskFilterBase : public SkMaskFilter {
 public:
+    /**
+     *  Identifies a device-space path by the non-volatile source path and the stroke and
+     *  matrix that produced it, so filters can recognize the same geometry across draws.
+     *  The integer part of the matrix translation is split off into fOffset; a mask built
+     *  for one draw can be reused for another that only differs by fOffset.
+     */
+    struct PathKey {
+        const SkPath*   fSrcPath;
+        SkMatrix        fMatrix;        // translation reduced to [0, 1)
+        SkIPoint        fOffset;
+        SkScalar        fStrokeWidth;
+        SkScalar        fStrokeMiter;
+        SkPaint::Style  fStyle;
+        SkPaint::Cap    fCap;
+        SkPaint::Join   fJoin;
+    };
+
     /** Returns the format of the resulting mask that this subclass will return
         when its filterMask() method is called.
     */
@@ -214,16 +232,27 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const;
 
+    /**
+     *  Override if your subclass can cache the filtered mask of a path described by a
+     *  PathKey. On success return a ref to the SkCachedData holding the pixels, with mask
+     *  pointing into it and its bounds in device space (the whole mask, not clipped). If
+     *  the normal filterMask() entry-point should be called (the default) return nullptr.
+     */
+    virtual SkCachedData* filterPathToCachedMask(const SkPath& devPath, const PathKey&,
+                                                 const SkMatrix&, SkStrokeRec::InitStyle,
+                                                 SkMask* mask) const;
+
 private:
     friend class SkDraw;
 
     /** Helper method that, given a path in device space, will rasterize it into a kA8_Format mask
      and then call filterMask(). If this returns true, the specified blitter will be called
      to render that mask. Returns false if filterMask() returned false.
+     If pathKey is not null, filterPathToCachedMask() is given the chance to supply the mask.
      This method is not exported to java.
      */
     bool filterPath(const SkPath& devPath, const SkMatrix& ctm, const SkRasterClip&, SkBlitter*,
-                    SkStrokeRec::InitStyle) const;
+                    SkStrokeRec::InitStyle, const PathKey* pathKey = nullptr) const;
 
     /** Helper method that, given a roundRect in device space, will rasterize it into a kA8_Format
      mask and then call filterMask(). If this returns true, the specified blitter will be called
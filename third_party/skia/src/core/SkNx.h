@@ -407,6 +407,7 @@ typedef SkNx<16, uint16_t> Sk16h;
 typedef SkNx<4,  int32_t> Sk4i;
 typedef SkNx<8,  int32_t> Sk8i;
 typedef SkNx<4, uint32_t> Sk4u;
+typedef SkNx<8, uint32_t> Sk8u;
 
 // Include platform specific specializations if available.
 #if !defined(SKNX_NO_SIMD) && SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
@@ -39,6 +39,8 @@
 #include "SkBlitMask_opts.h"
 #include "SkBlitRow_opts.h"
 #include "SkChecksum_opts.h"
+#include "SkCoverageDelta_opts.h"
+#include "SkMaskBlurFilter_opts.h"
 #include "SkMorphologyImageFilter_opts.h"
 #include "SkRasterPipeline_opts.h"
 #include "SkSwizzler_opts.h"
@@ -58,6 +60,10 @@ namespace SkOpts {
     DEFINE_DEFAULT( erode_x);
     DEFINE_DEFAULT( erode_y);
 
+    DEFINE_DEFAULT(box_blur_a8_transposed);
+
+    DEFINE_DEFAULT(coverage_deltas_to_alphas);
+
     DEFINE_DEFAULT(blit_mask_d32_a8);
 
     DEFINE_DEFAULT(blit_row_color32);
@@ -102,6 +108,7 @@ namespace SkOpts {
     void Init_sse42();
     void Init_avx();
     void Init_hsw();
+    void Init_skx();
     void Init_crc32();
 
     static void init() {
@@ -124,6 +131,10 @@ namespace SkOpts {
             if (SkCpu::Supports(SkCpu::HSW)) { Init_hsw();   }
         #endif
 
+        #if SK_CPU_SSE_LEVEL < SK_CPU_SSE_LEVEL_SKX
+            if (SkCpu::Supports(SkCpu::SKX)) { Init_skx();   }
+        #endif
+
     #elif defined(SK_CPU_ARM64)
         if (SkCpu::Supports(SkCpu::CRC32)) { Init_crc32(); }
 
@@ -28,6 +28,18 @@ namespace SkOpts {
     typedef void (*Morph)(const SkPMColor*, SkPMColor*, int, int, int, int, int);
     extern Morph dilate_x, dilate_y, erode_x, erode_y;
 
+    // Triple box blur of up to `rows` A8 rows of srcW pixels into dstW outputs each, written
+    // transposed: output x of row y lands at dst[x*dstRB + y].  See SkMaskBlurFilter.cpp.
+    typedef void (*BoxBlurA8)(uint32_t weight, int window0, int window1, int window2,
+                              int noChangeCount, const uint8_t* src, size_t srcRB, int srcW,
+                              int rows, uint8_t* dst, size_t dstRB, int dstW);
+    extern BoxBlurA8 box_blur_a8_transposed;
+
+    // Sum count SkFixed coverage deltas, a multiple of 8, into coverages and write their alphas.
+    // See SkCoverageDeltaMask::convertCoverageToAlpha.
+    extern void (*coverage_deltas_to_alphas)(const int32_t deltas[], uint8_t alphas[], int count,
+                                             bool isEvenOdd, bool isInverse, bool isConvex);
+
     extern void (*blit_mask_d32_a8)(SkPMColor*, size_t, const SkAlpha*, size_t, SkColor, int, int);
     extern void (*blit_row_color32)(SkPMColor*, const SkPMColor*, int, SkPMColor);
     extern void (*blit_row_s32a_opaque)(SkPMColor*, const SkPMColor*, int, U8CPU);
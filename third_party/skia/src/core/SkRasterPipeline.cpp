@@ -5,11 +5,16 @@
  * found in the LICENSE file.
  */
 
+#include "SkMutex.h"
 #include "SkRasterPipeline.h"
 #include "SkPM4f.h"
 #include "SkPM4fPriv.h"
+#include "SkTArray.h"
 #include "../jumper/SkJumper.h"
 #include <algorithm>
+#include <atomic>
+#include <string>
+#include <unordered_map>
 
 SkRasterPipeline::SkRasterPipeline(SkArenaAlloc* alloc) : fAlloc(alloc) {
     this->reset();
@@ -56,17 +61,20 @@ void SkRasterPipeline::extend(const SkRasterPipeline& src) {
     fSlotsNeeded += src.fSlotsNeeded - 1;  // Don't double count just_returns().
 }
 
+static const char* stage_name(uint64_t stage) {
+    switch (stage) {
+    #define M(x) case SkRasterPipeline::x: return #x;
+        SK_RASTER_PIPELINE_STAGES(M)
+    #undef M
+    }
+    return "";
+}
+
 void SkRasterPipeline::dump() const {
     SkDebugf("SkRasterPipeline, %d stages\n", fNumStages);
     std::vector<const char*> stages;
     for (auto st = fStages; st; st = st->prev) {
-        const char* name = "";
-        switch (st->stage) {
-        #define M(x) case x: name = #x; break;
-            SK_RASTER_PIPELINE_STAGES(M)
-        #undef M
-        }
-        stages.push_back(name);
+        stages.push_back(stage_name(st->stage));
     }
     std::reverse(stages.begin(), stages.end());
     for (const char* name : stages) {
@@ -167,3 +175,145 @@ void SkRasterPipeline::append_matrix(SkArenaAlloc* alloc, const SkMatrix& matrix
         }
     }
 }
+
+const SkRasterPipeline::StageList* SkRasterPipeline::fuse(int* slotsNeeded) const {
+    // The runs of stages SkRasterPipelineBlitter builds to blend a color onto 8888 through an A8
+    // mask or a coverage float, and the stage that runs them all in one.  TrackShapes() shows which
+    // other runs are common enough to be worth a fused stage.
+    struct Fusion {
+        StockStage fused;
+        int        len;
+        StockStage run[4];
+    };
+    static const Fusion kFusions[] = {
+        { srcover_u8_8888     , 4, { scale_u8     , load_8888_dst, srcover, store_8888 } },
+        { srcover_u8_bgra     , 4, { scale_u8     , load_bgra_dst, srcover, store_bgra } },
+        { srcover_1_float_8888, 4, { scale_1_float, load_8888_dst, srcover, store_8888 } },
+        { srcover_1_float_bgra, 4, { scale_1_float, load_bgra_dst, srcover, store_bgra } },
+        { src_u8_8888         , 3, { load_8888_dst, lerp_u8      , store_8888 } },
+        { src_u8_bgra         , 3, { load_bgra_dst, lerp_u8      , store_bgra } },
+        { src_1_float_8888    , 3, { load_8888_dst, lerp_1_float , store_8888 } },
+        { src_1_float_bgra    , 3, { load_bgra_dst, lerp_1_float , store_bgra } },
+    };
+
+    // Stages are stored backwards in fStages, so we reverse here, front to back.
+    SkSTArray<32, const StageList*> stages;
+    for (const StageList* st = fStages; st; st = st->prev) {
+        stages.push_back(st);
+    }
+    std::reverse(stages.begin(), stages.end());
+
+    // Finds the fusion of the run starting at stages[i], filling in its context.
+    auto match = [&](int i, SkJumper_FusedCtx* ctx) -> const Fusion* {
+        for (const auto& fusion : kFusions) {
+            if (i + fusion.len > stages.count()) {
+                continue;
+            }
+            const void* dst = nullptr;
+            bool matches = true;
+            for (int j = 0; matches && j < fusion.len; j++) {
+                const StageList* st = stages[i+j];
+                StockStage stage = fusion.run[j];
+                matches = !st->rawFunction && st->stage == (uint64_t)stage;
+                if (stage == scale_u8 || stage == scale_1_float ||
+                    stage == lerp_u8  || stage == lerp_1_float) {
+                    ctx->coverage = st->ctx;
+                } else if (stage == load_8888_dst || stage == load_bgra_dst) {
+                    dst = st->ctx;
+                } else if (stage == store_8888 || stage == store_bgra) {
+                    // The dst is loaded and stored back to the same place.
+                    matches = matches && st->ctx == dst;
+                }
+            }
+            if (matches) {
+                ctx->dst = (const SkJumper_MemoryCtx*)dst;
+                return &fusion;
+            }
+        }
+        return nullptr;
+    };
+
+    SkJumper_FusedCtx ctx;
+    int first = 0;
+    while (first < stages.count() && !match(first, &ctx)) {
+        first++;
+    }
+    if (first == stages.count()) {
+        *slotsNeeded = fSlotsNeeded;
+        return fStages;
+    }
+
+    // Rebuild the list from the first fusion on, fusing any later runs too.
+    StageList* fused = first > 0 ? const_cast<StageList*>(stages[first-1]) : nullptr;
+    int slots = fSlotsNeeded;
+    for (int i = first; i < stages.count();) {
+        if (auto fusion = match(i, &ctx)) {
+            for (int j = 0; j < fusion->len; j++) {
+                slots -= stages[i+j]->ctx ? 2 : 1;
+            }
+            slots += 2;
+            fused = fAlloc->make<StageList>(StageList{fused, (uint64_t)fusion->fused,
+                                                      fAlloc->make<SkJumper_FusedCtx>(ctx),
+                                                      false});
+            i += fusion->len;
+        } else {
+            fused = fAlloc->make<StageList>(StageList{fused, stages[i]->stage, stages[i]->ctx,
+                                                      stages[i]->rawFunction});
+            i++;
+        }
+    }
+    // compile() writes the program down from the end of exactly this many slots: the final
+    // just_return, plus each stage and its context.
+    int emitted = 1;
+    for (const StageList* st = fused; st; st = st->prev) {
+        emitted += st->ctx ? 2 : 1;
+    }
+    SkASSERT_RELEASE(emitted == slots);
+    *slotsNeeded = slots;
+    return fused;
+}
+
+static std::atomic<bool> gTrackShapes{false};
+SK_DECLARE_STATIC_MUTEX(gShapesMutex);
+static std::unordered_map<std::string, int>* gShapes;  // Guarded by gShapesMutex.
+
+void SkRasterPipeline::TrackShapes(bool track) {
+    gTrackShapes.store(track, std::memory_order_relaxed);
+}
+
+void SkRasterPipeline::RecordShape(const StageList* stages, bool lowp) {
+    if (!gTrackShapes.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::string shape;
+    for (const StageList* st = stages; st; st = st->prev) {
+        shape.insert(0, st->rawFunction ? " (raw)" : (" " + std::string(stage_name(st->stage))));
+    }
+    shape.insert(0, lowp ? "lowp: " : "highp:");
+
+    SkAutoMutexAcquire lock(gShapesMutex);
+    if (!gShapes) {
+        gShapes = new std::unordered_map<std::string, int>;
+    }
+    (*gShapes)[shape]++;
+}
+
+void SkRasterPipeline::DumpShapes() {
+    std::vector<std::pair<int, std::string>> shapes;
+    {
+        SkAutoMutexAcquire lock(gShapesMutex);
+        if (gShapes) {
+            for (const auto& shape : *gShapes) {
+                shapes.push_back({shape.second, shape.first});
+            }
+        }
+    }
+    std::sort(shapes.begin(), shapes.end(), [](const std::pair<int, std::string>& a,
+                                               const std::pair<int, std::string>& b) {
+        return a.first > b.first;
+    });
+    SkDebugf("SkRasterPipeline shapes compiled\n");
+    for (const auto& shape : shapes) {
+        SkDebugf("%8d %s\n", shape.first, shape.second.c_str());
+    }
+}
@@ -65,6 +65,10 @@
     M(exclusion) M(hardlight) M(lighten) M(overlay) M(softlight)   \
     M(hue) M(saturation) M(color) M(luminosity)                    \
     M(srcover_rgba_8888) M(srcover_bgra_8888)                      \
+    M(srcover_u8_8888) M(srcover_u8_bgra)                          \
+    M(srcover_1_float_8888) M(srcover_1_float_bgra)                \
+    M(src_u8_8888) M(src_u8_bgra)                                  \
+    M(src_1_float_8888) M(src_1_float_bgra)                        \
     M(luminance_to_alpha)                                          \
     M(matrix_translate) M(matrix_scale_translate)                  \
     M(matrix_2x3) M(matrix_3x4) M(matrix_4x5) M(matrix_4x3)        \
@@ -129,8 +133,15 @@ public:
     void run(size_t x, size_t y, size_t w, size_t h) const;
 
     // Allocates a thunk which amortizes run() setup cost in alloc.
+    // Known runs of stages are replaced by fused stages here; see SkRasterPipeline.cpp.
     std::function<void(size_t, size_t, size_t, size_t)> compile() const;
 
+    // Off by default.  While on, compile() counts each distinct pipeline it builds, as the stages
+    // left after fusion and whether they run in lowp or highp.  DumpShapes() prints the counts,
+    // most common first: the runs of stages worth fusing next.
+    static void TrackShapes(bool);
+    static void DumpShapes();
+
     void dump() const;
 
     // Appends a stage for the specified matrix.
@@ -159,7 +170,12 @@ private:
     };
 
     using StartPipelineFn = void(*)(size_t,size_t,size_t,size_t, void** program);
-    StartPipelineFn build_pipeline(void**) const;
+    StartPipelineFn build_pipeline(const StageList*, void**) const;
+
+    // Returns fStages with any known runs replaced by fused stages, allocated in fAlloc,
+    // and the slots those need.
+    const StageList* fuse(int* slotsNeeded) const;
+    static void RecordShape(const StageList*, bool lowp);
 
     void unchecked_append(StockStage, void*);
 
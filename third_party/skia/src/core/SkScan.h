@@ -14,6 +14,7 @@
 #include "SkRect.h"
 #include <atomic>
 
+class SkExecutor;
 class SkRasterClip;
 class SkRegion;
 class SkBlitter;
@@ -77,6 +78,13 @@ public:
     static void AntiFillPath(const SkPath& path, const SkRasterClip& rc, SkBlitter* blitter) {
         AntiFillPath(path, rc, blitter, nullptr);
     }
+
+    // Whether AntiFillPath, when not given an SkDAARecord, scan converts path with delta AA.
+    static bool ShouldUseDAA(const SkPath& path);
+
+    // Delta AA paths tall and complex enough are scan converted in bands of rows on the threads
+    // of executor; null, the default, keeps them on the calling thread. Doesn't take ownership.
+    static void SetDAAExecutor(SkExecutor* executor);
 private:
     friend class SkAAClip;
     friend class SkRegion;
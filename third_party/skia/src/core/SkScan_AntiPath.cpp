@@ -599,7 +599,7 @@ static SkIRect safeRoundOut(const SkRect& src) {
     return dst;
 }
 
-static bool ShouldUseDAA(const SkPath& path) {
+bool SkScan::ShouldUseDAA(const SkPath& path) {
     if (gSkForceDeltaAA) {
         return true;
     }
@@ -12,6 +12,7 @@
 #include "SkCoverageDelta.h"
 #include "SkEdge.h"
 #include "SkEdgeBuilder.h"
+#include "SkExecutor.h"
 #include "SkGeometry.h"
 #include "SkMask.h"
 #include "SkPath.h"
@@ -21,6 +22,7 @@
 #include "SkScan.h"
 #include "SkScanPriv.h"
 #include "SkTSort.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkUtils.h"
 
@@ -149,83 +151,20 @@ public:
     }
 };
 
+// Generate the deltas of the edges in list on rows [top, bottom). Edges whose rows, if given,
+// fall outside are skipped. Rows from rectTop to rectBot are left to blitAntiRect.
 template<class Deltas> static SK_ALWAYS_INLINE
-void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRect& clipBounds,
-        Deltas& result, SkBlitter* blitter, bool skipRect, bool pathContainedInClip) {
-    // 1. Build edges
-    SkEdgeBuilder builder;
-    // We have to use clipBounds instead of clippedIR to build edges because of "canCullToTheRight":
-    // if the builder finds a right edge past the right clip, it won't build that right edge.
-    int  count = builder.build_edges(path, &clipBounds, 0, pathContainedInClip,
-                                     SkEdgeBuilder::kBezier);
-
-    if (count == 0) {
-        return;
-    }
-    SkBezier** list = builder.bezierList();
-
-    // 2. Try to find the rect part because blitAntiRect is so much faster than blitCoverageDeltas
-    int rectTop = clippedIR.fBottom;   // the rect is initialized to be empty as top = bot
-    int rectBot = clippedIR.fBottom;
-    if (skipRect) {             // only find that rect is skipRect == true
-        YLessThan lessThan;     // sort edges in YX order
-        SkTQSort(list, list + count - 1, lessThan);
-        for(int i = 0; i < count - 1; ++i) {
-            SkBezier* lb = list[i];
-            SkBezier* rb = list[i + 1];
-
-            // fCount == 2 ensures that lb and rb are lines instead of quads or cubics.
-            bool lDX0 = lb->fP0.fX == lb->fP1.fX && lb->fCount == 2;
-            bool rDX0 = rb->fP0.fX == rb->fP1.fX && rb->fCount == 2;
-            if (!lDX0 || !rDX0) { // make sure that the edges are vertical
-                continue;
-            }
-
-            SkAnalyticEdge l, r;
-            if (!l.setLine(lb->fP0, lb->fP1) || !r.setLine(rb->fP0, rb->fP1)) {
-                continue;
-            }
-
-            SkFixed xorUpperY = l.fUpperY ^ r.fUpperY;
-            SkFixed xorLowerY = l.fLowerY ^ r.fLowerY;
-            if ((xorUpperY | xorLowerY) == 0) { // equal upperY and lowerY
-                rectTop = SkFixedCeilToInt(l.fUpperY);
-                rectBot = SkFixedFloorToInt(l.fLowerY);
-                if (rectBot > rectTop) { // if bot == top, the rect is too short for blitAntiRect
-                    int L = SkFixedCeilToInt(l.fUpperX);
-                    int R = SkFixedFloorToInt(r.fUpperX);
-                    if (L <= R) {
-                        SkAlpha la = (SkIntToFixed(L) - l.fUpperX) >> 8;
-                        SkAlpha ra = (r.fUpperX - SkIntToFixed(R)) >> 8;
-                        result.setAntiRect(L - 1, rectTop, R - L, rectBot - rectTop, la, ra);
-                    } else { // too thin to use blitAntiRect; reset the rect region to be emtpy
-                        rectTop = rectBot = clippedIR.fBottom;
-                    }
-                }
-                break;
-            }
-
-        }
-    }
-
-    // 3. Sort edges in x so we may need less sorting for delta based on x. This only helps
-    //    SkCoverageDeltaList. And we don't want to sort more than SORT_THRESHOLD edges where
-    //    the log(count) factor of the quick sort may become a bottleneck; when there are so
-    //    many edges, we're unlikely to make deltas sorted anyway.
-    constexpr int SORT_THRESHOLD = 256;
-    if (std::is_same<Deltas, SkCoverageDeltaList>::value && count < SORT_THRESHOLD) {
-        XLessThan lessThan;
-        SkTQSort(list, list + count - 1, lessThan);
-    }
-
-    // Future todo: parallize and SIMD the following code.
-    // 4. iterate through edges and generate deltas
+void gen_edge_deltas(SkBezier** list, int count, const SkIRect* rows, int top, int bottom,
+                     int rectTop, int rectBot, Deltas& result) {
     for(int index = 0; index < count; ++index) {
         SkAnalyticCubicEdge storage;
         SkASSERT(sizeof(SkAnalyticQuadraticEdge) >= sizeof(SkAnalyticEdge));
         SkASSERT(sizeof(SkAnalyticCubicEdge) >= sizeof(SkAnalyticQuadraticEdge));
 
         SkBezier* bezier        = list[index];
+        if (rows && (rows[index].fBottom <= top || rows[index].fTop >= bottom)) {
+            continue;
+        }
         SkAnalyticEdge* currE   = &storage;
         bool edgeSet            = false;
 
@@ -259,6 +198,9 @@ void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRec
         }
 
         do {
+            if (SkFixedFloorToInt(currE->fUpperY) >= bottom) {
+                continue;                       // Cubics may come back up; skip just this line
+            }
             currE->fX =  currE->fUpperX;
 
             SkFixed upperFloor  = SkFixedFloorToFixed(currE->fUpperY);
@@ -268,7 +210,7 @@ void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRec
             if (lowerCeil <= upperFloor + SK_Fixed1) { // only one row is affected by the currE
                 SkFixed rowHeight = currE->fLowerY - currE->fUpperY;
                 SkFixed nextX = currE->fX + SkFixedMul(currE->fDX, rowHeight);
-                if (iy >= clippedIR.fTop && iy < clippedIR.fBottom) {
+                if (iy >= top && iy < bottom) {
                     add_coverage_delta_segment<true>(iy, rowHeight, currE, nextX, &result);
                 }
                 continue;
@@ -279,7 +221,9 @@ void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRec
             SkFixed nextX;
             if (rowHeight != SK_Fixed1) {   // it's a partial row
                 nextX = currE->fX + SkFixedMul(currE->fDX, rowHeight);
-                add_coverage_delta_segment<true>(iy, rowHeight, currE, nextX, &result);
+                if (iy >= top) {
+                    add_coverage_delta_segment<true>(iy, rowHeight, currE, nextX, &result);
+                }
             } else {                        // it's a full row so we can leave it to the while loop
                 iy--;                       // compensate the iy++ in the while loop
                 nextX = currE->fX;
@@ -302,13 +246,24 @@ void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRec
                     continue;
                 }
 
+                if (iy < top) {
+                    // Rows of an earlier band: go straight to our first row, or to the edge's
+                    // last one if that comes first, where stepping would have left fX and nextX.
+                    int skipTo = SkTMin(top, SkFixedFloorToInt(currE->fLowerY));
+                    nextX += currE->fDX * (skipTo - 1 - iy);
+                    iy = skipTo - 1;
+                    continue;
+                }
+                if (iy >= bottom) {
+                    break;                      // The remaining rows belong to other bands
+                }
+
                 // Add current edge's coverage deltas on this full row
                 add_coverage_delta_segment<false>(iy, SK_Fixed1, currE, nextX, &result);
             }
 
             // last partial row
-            if (SkIntToFixed(iy) < currE->fLowerY &&
-                    iy >= clippedIR.fTop && iy < clippedIR.fBottom) {
+            if (SkIntToFixed(iy) < currE->fLowerY && iy >= top && iy < bottom) {
                 rowHeight = currE->fLowerY - SkIntToFixed(iy);
                 nextX = currE->fX + SkFixedMul(currE->fDX, rowHeight);
                 add_coverage_delta_segment<true>(iy, rowHeight, currE, nextX, &result);
@@ -318,6 +273,166 @@ void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRec
     }
 }
 
+static std::atomic<SkExecutor*> gDAAExecutor{nullptr};
+
+void SkScan::SetDAAExecutor(SkExecutor* executor) {
+    gDAAExecutor.store(executor, std::memory_order_relaxed);
+}
+
+// Paths are split into bands of at least MIN_BAND_HEIGHT rows, and only when their edges span
+// MIN_BAND_WORK rows in total; below that, handing out the bands costs more than it saves.
+static constexpr int MIN_BAND_HEIGHT    = 64;
+static constexpr int MAX_BANDS          = 16;
+static constexpr int MIN_BAND_WORK      = 16 << 10;
+
+// Only SkCoverageDeltaList can be filled in bands.
+template<class Deltas>
+static bool gen_band_deltas(SkBezier**, int, const SkIRect&, int, int, Deltas&, SkArenaAlloc*,
+                            SkExecutor*) {
+    return false;
+}
+
+// Each band of rows of result is filled on its own thread. Rows are independent, so
+// bands only need their own arena for the rows they grow. Every band walks the edges in the same
+// order as gen_edge_deltas does for the whole path, so the deltas are the same as without bands.
+static bool gen_band_deltas(SkBezier** list, int count, const SkIRect& clippedIR,
+                            int rectTop, int rectBot, SkCoverageDeltaList& result,
+                            SkArenaAlloc* alloc, SkExecutor* executor) {
+    int bandCount = SkTMin(clippedIR.height() / MIN_BAND_HEIGHT, MAX_BANDS);
+    if (!executor || bandCount < 2) {
+        return false;
+    }
+
+    // The rows each edge may touch, padded for the rounding of its points to SkFixed.
+    SkIRect* rows = alloc->makeArrayDefault<SkIRect>(count);
+    int work = 0;
+    for (int i = 0; i < count; ++i) {
+        const SkBezier* bezier = list[i];
+        SkScalar minY = SkTMin(bezier->fP0.fY, bezier->fP1.fY);
+        SkScalar maxY = SkTMax(bezier->fP0.fY, bezier->fP1.fY);
+        if (bezier->fCount == 3) {
+            SkScalar y = static_cast<const SkQuad*>(bezier)->fP2.fY;
+            minY = SkTMin(minY, y);
+            maxY = SkTMax(maxY, y);
+        } else if (bezier->fCount == 4) {
+            const SkCubic* cubic = static_cast<const SkCubic*>(bezier);
+            minY = SkTMin(minY, SkTMin(cubic->fP2.fY, cubic->fP3.fY));
+            maxY = SkTMax(maxY, SkTMax(cubic->fP2.fY, cubic->fP3.fY));
+        }
+        rows[i].fTop    = SkTMax(SkScalarFloorToInt(minY) - 1, clippedIR.fTop);
+        rows[i].fBottom = SkTMin(SkScalarCeilToInt(maxY) + 1, clippedIR.fBottom);
+        work += SkTMax(rows[i].fBottom - rows[i].fTop, 0);
+        if (work >= MIN_BAND_WORK) {
+            work = MIN_BAND_WORK;   // Enough to band; only the rows are still needed
+        }
+    }
+    if (work < MIN_BAND_WORK) {
+        return false;
+    }
+
+    SkArenaAlloc** bandAllocs = alloc->makeArrayDefault<SkArenaAlloc*>(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        bandAllocs[i] = alloc->make<SkArenaAlloc>(4 << 10);
+    }
+
+    // Grows the rows of one band in the band's own arena.
+    struct BandDeltas {
+        SkCoverageDeltaList* fList;
+        SkArenaAlloc*        fAlloc;
+
+        SK_ALWAYS_INLINE void addDelta(int x, int y, SkFixed delta) {
+            fList->addDelta(x, y, delta, fAlloc);
+        }
+    };
+
+    SkTaskGroup tasks(*executor);
+    tasks.batch(bandCount, [&](int band) {
+        int top    = clippedIR.fTop + clippedIR.height() * band / bandCount;
+        int bottom = clippedIR.fTop + clippedIR.height() * (band + 1) / bandCount;
+        BandDeltas deltas = {&result, bandAllocs[band]};
+        gen_edge_deltas(list, count, rows, top, bottom, rectTop, rectBot, deltas);
+    });
+    tasks.wait();
+    return true;
+}
+
+template<class Deltas> static SK_ALWAYS_INLINE
+void gen_alpha_deltas(const SkPath& path, const SkIRect& clippedIR, const SkIRect& clipBounds,
+        Deltas& result, SkBlitter* blitter, bool skipRect, bool pathContainedInClip,
+        SkArenaAlloc* alloc, SkExecutor* executor) {
+    // 1. Build edges
+    SkEdgeBuilder builder;
+    // We have to use clipBounds instead of clippedIR to build edges because of "canCullToTheRight":
+    // if the builder finds a right edge past the right clip, it won't build that right edge.
+    int  count = builder.build_edges(path, &clipBounds, 0, pathContainedInClip,
+                                     SkEdgeBuilder::kBezier);
+
+    if (count == 0) {
+        return;
+    }
+    SkBezier** list = builder.bezierList();
+
+    // 2. Try to find the rect part because blitAntiRect is so much faster than blitCoverageDeltas
+    int rectTop = clippedIR.fBottom;   // the rect is initialized to be empty as top = bot
+    int rectBot = clippedIR.fBottom;
+    if (skipRect) {             // only find that rect is skipRect == true
+        YLessThan lessThan;     // sort edges in YX order
+        SkTQSort(list, list + count - 1, lessThan);
+        for(int i = 0; i < count - 1; ++i) {
+            SkBezier* lb = list[i];
+            SkBezier* rb = list[i + 1];
+
+            // fCount == 2 ensures that lb and rb are lines instead of quads or cubics.
+            bool lDX0 = lb->fP0.fX == lb->fP1.fX && lb->fCount == 2;
+            bool rDX0 = rb->fP0.fX == rb->fP1.fX && rb->fCount == 2;
+            if (!lDX0 || !rDX0) { // make sure that the edges are vertical
+                continue;
+            }
+
+            SkAnalyticEdge l, r;
+            if (!l.setLine(lb->fP0, lb->fP1) || !r.setLine(rb->fP0, rb->fP1)) {
+                continue;
+            }
+
+            SkFixed xorUpperY = l.fUpperY ^ r.fUpperY;
+            SkFixed xorLowerY = l.fLowerY ^ r.fLowerY;
+            if ((xorUpperY | xorLowerY) == 0) { // equal upperY and lowerY
+                rectTop = SkFixedCeilToInt(l.fUpperY);
+                rectBot = SkFixedFloorToInt(l.fLowerY);
+                if (rectBot > rectTop) { // if bot == top, the rect is too short for blitAntiRect
+                    int L = SkFixedCeilToInt(l.fUpperX);
+                    int R = SkFixedFloorToInt(r.fUpperX);
+                    if (L <= R) {
+                        SkAlpha la = (SkIntToFixed(L) - l.fUpperX) >> 8;
+                        SkAlpha ra = (r.fUpperX - SkIntToFixed(R)) >> 8;
+                        result.setAntiRect(L - 1, rectTop, R - L, rectBot - rectTop, la, ra);
+                    } else { // too thin to use blitAntiRect; reset the rect region to be emtpy
+                        rectTop = rectBot = clippedIR.fBottom;
+                    }
+                }
+                break;
+            }
+
+        }
+    }
+
+    // 3. Sort edges in x so we may need less sorting for delta based on x. This only helps
+    //    SkCoverageDeltaList. And we don't want to sort more than SORT_THRESHOLD edges where
+    //    the log(count) factor of the quick sort may become a bottleneck; when there are so
+    //    many edges, we're unlikely to make deltas sorted anyway.
+    constexpr int SORT_THRESHOLD = 256;
+    if (std::is_same<Deltas, SkCoverageDeltaList>::value && count < SORT_THRESHOLD) {
+        XLessThan lessThan;
+        SkTQSort(list, list + count - 1, lessThan);
+    }
+
+    // 4. iterate through edges and generate deltas
+    if (!gen_band_deltas(list, count, clippedIR, rectTop, rectBot, result, alloc, executor)) {
+        gen_edge_deltas(list, count, nullptr, clippedIR.fTop, clippedIR.fBottom, rectTop, rectBot,
+                        result);
+    }
+}
+
 void SkScan::DAAFillPath(const SkPath& path, SkBlitter* blitter, const SkIRect& ir,
                          const SkIRect& clipBounds, bool forceRLE, SkDAARecord* record) {
     bool containedInClip = clipBounds.contains(ir);
@@ -362,7 +477,7 @@ void SkScan::DAAFillPath(const SkPath& path, SkBlitter* blitter, const SkIRect&
             record->fType = SkDAARecord::Type::kMask;
             SkCoverageDeltaMask deltaMask(alloc, clippedIR);
             gen_alpha_deltas(path, clippedIR, clipBounds, deltaMask, blitter, skipRect,
-                             containedInClip);
+                             containedInClip, alloc, nullptr);
             deltaMask.convertCoverageToAlpha(isEvenOdd, isInverse, isConvex);
             record->fMask = deltaMask.prepareSkMask();
         } else {
@@ -370,7 +485,8 @@ void SkScan::DAAFillPath(const SkPath& path, SkBlitter* blitter, const SkIRect&
             SkCoverageDeltaList* deltaList = alloc->make<SkCoverageDeltaList>(
                     alloc, clippedIR, forceRLE);
             gen_alpha_deltas(path, clippedIR, clipBounds, *deltaList, blitter, skipRect,
-                             containedInClip);
+                             containedInClip, alloc,
+                             gDAAExecutor.load(std::memory_order_relaxed));
             record->fList = deltaList;
         }
     }
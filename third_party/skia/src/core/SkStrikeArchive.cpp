@@ -0,0 +1,502 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkStrikeArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "SkData.h"
+#include "SkDescriptor.h"
+#include "SkGlyphCache.h"
+#include "SkMakeUnique.h"
+#include "SkMaskFilter.h"
+#include "SkMutex.h"
+#include "SkOpts.h"
+#include "SkPath.h"
+#include "SkPathEffect.h"
+#include "SkScalerContext.h"
+#include "SkStream.h"
+#include "SkStrikeCache.h"
+#include "SkString.h"
+#include "SkTHash.h"
+#include "SkTypeface.h"
+
+namespace {
+    constexpr char     kMagic[8] = {'s', 'k', 's', 't', 'r', 'i', 'k', 'e'};
+    // Bump whenever the layout below changes.
+    constexpr uint32_t kVersion = 2;
+
+    struct Header {
+        char     fMagic[8];
+        uint32_t fVersion;
+        // Sizes of the structs stored verbatim, which differ between builds.
+        uint32_t fRecSize;
+        uint32_t fStrikeSize;
+        uint32_t fGlyphSize;
+        uint64_t fLength;
+        uint32_t fStrikeCount;
+        uint32_t fPad;
+        // SkStrikeArchive::StrikeRecord[fStrikeCount] follows.
+    };
+
+    struct GlyphRecord {
+        uint32_t fPackedID;
+        float    fAdvanceX, fAdvanceY;
+        uint16_t fWidth, fHeight;
+        int16_t  fTop, fLeft;
+        int8_t   fForceBW;
+        uint8_t  fMaskFormat;
+        uint16_t fFlags;
+        // From the start of the file, 0 when not archived.
+        uint32_t fImageOffset;
+        uint32_t fPathOffset;
+        uint32_t fPathSize;
+    };
+
+    enum GlyphFlags : uint16_t {
+        // Only the advance is archived, as for glyphs that text was just measured with.
+        kJustAdvance_GlyphFlag = 1 << 0,
+    };
+
+    void record_to_glyph(const GlyphRecord& record, SkGlyph* glyph) {
+        glyph->fAdvanceX   = record.fAdvanceX;
+        glyph->fAdvanceY   = record.fAdvanceY;
+        glyph->fWidth      = record.fWidth;
+        glyph->fHeight     = record.fHeight;
+        glyph->fTop        = record.fTop;
+        glyph->fLeft       = record.fLeft;
+        glyph->fForceBW    = record.fForceBW;
+        glyph->fMaskFormat = record.fMaskFormat;
+    }
+
+    // The descriptor with a font ID of 0; font IDs are only unique within a process.
+    const SkDescriptor* normalize_descriptor(const SkDescriptor& source, SkAutoDescriptor* ad) {
+        ad->reset(source.getLength());
+        SkDescriptor* desc = ad->getDesc();
+        desc->init();
+
+        uint32_t size;
+        const void* entry = source.findEntry(kRec_SkDescriptorTag, &size);
+        SkScalerContextRec rec;
+        memcpy(&rec, entry, size);
+        rec.fFontID = 0;
+        desc->addEntry(kRec_SkDescriptorTag, sizeof(rec), &rec);
+
+        for (uint32_t tag : {kPathEffect_SkDescriptorTag, kMaskFilter_SkDescriptorTag}) {
+            if ((entry = source.findEntry(tag, &size))) {
+                desc->addEntry(tag, size, entry);
+            }
+        }
+        desc->computeChecksum();
+        return desc;
+    }
+
+    // Identifies a font across processes. Computed once per typeface, since it reads a table.
+    uint64_t typeface_key(const SkTypeface& typeface) {
+        SK_DECLARE_STATIC_MUTEX(keysMutex);
+        static SkTHashMap<SkFontID, uint64_t>* keys = new SkTHashMap<SkFontID, uint64_t>;
+        {
+            SkAutoMutexAcquire lock(keysMutex);
+            if (uint64_t* key = keys->find(typeface.uniqueID())) {
+                return *key;
+            }
+        }
+
+        SkString family;
+        typeface.getFamilyName(&family);
+        SkFontStyle style = typeface.fontStyle();
+        int32_t fields[] = {style.weight(), style.width(), style.slant(), typeface.countGlyphs()};
+
+        // The 'head' table carries the font revision and a whole-file checksum.
+        const SkFontTableTag kHead = SkSetFourByteTag('h', 'e', 'a', 'd');
+        std::vector<uint8_t> bytes(family.c_str(), family.c_str() + family.size() + 1);
+        bytes.insert(bytes.end(), (const uint8_t*)fields, (const uint8_t*)(fields + 4));
+        size_t headSize = typeface.getTableSize(kHead);
+        bytes.resize(bytes.size() + headSize);
+        typeface.getTableData(kHead, 0, headSize, bytes.data() + bytes.size() - headSize);
+
+        uint64_t key = (uint64_t)SkOpts::hash(bytes.data(), bytes.size(), 0) << 32 |
+                       SkOpts::hash(bytes.data(), bytes.size(), 0x9E3779B9);
+        SkAutoMutexAcquire lock(keysMutex);
+        keys->set(typeface.uniqueID(), key);
+        return key;
+    }
+
+    // CreateScalerContext copies the rec out of the descriptor whole.
+    bool has_rec_entry(const SkDescriptor& desc) {
+        uint32_t size;
+        return desc.findEntry(kRec_SkDescriptorTag, &size) && size == sizeof(SkScalerContextRec);
+    }
+
+    SK_DECLARE_STATIC_MUTEX(gArchiveMutex);
+    SkStrikeArchive* gArchive = nullptr;
+}  // namespace
+
+struct SkStrikeArchive::StrikeRecord {
+    uint64_t             fTypefaceKey;
+    uint32_t             fDescOffset;           // normalized descriptor
+    uint32_t             fGlyphOffset;          // GlyphRecord[fGlyphCount], by packed ID
+    uint32_t             fGlyphCount;
+    uint32_t             fTypefaceGlyphCount;
+    SkPaint::FontMetrics fFontMetrics;
+
+    const SkDescriptor* desc(const uint8_t* base) const {
+        return reinterpret_cast<const SkDescriptor*>(base + fDescOffset);
+    }
+
+    const GlyphRecord* glyphs(const uint8_t* base) const {
+        return reinterpret_cast<const GlyphRecord*>(base + fGlyphOffset);
+    }
+
+    const GlyphRecord* findGlyph(const uint8_t* base, SkPackedGlyphID id) const {
+        const GlyphRecord* begin = this->glyphs(base);
+        const GlyphRecord* end = begin + fGlyphCount;
+        const GlyphRecord* record = std::lower_bound(begin, end, id.getPackedID(),
+                [](const GlyphRecord& r, uint32_t packedID) { return r.fPackedID < packedID; });
+        return record != end && record->fPackedID == id.getPackedID() ? record : nullptr;
+    }
+};
+
+// Serves an archived strike from the mapping. The base class is given the rec without framing
+// and no effects, so it passes everything through untouched: archived images already have them
+// applied, and glyphs missing from the archive come from the real scaler context, which applies
+// them itself.
+class SkScalerContext_Archive : public SkScalerContext {
+public:
+    SkScalerContext_Archive(sk_sp<SkStrikeArchive> archive,
+                            const uint8_t* base,
+                            const SkStrikeArchive::StrikeRecord* strike,
+                            sk_sp<SkTypeface> typeface,
+                            const SkScalerContextEffects& effects,
+                            const SkDescriptor& desc,
+                            const SkDescriptor* plainDesc)
+        : INHERITED(std::move(typeface), SkScalerContextEffects(), plainDesc)
+        , fArchive(std::move(archive))
+        , fBase(base)
+        , fStrike(strike)
+        , fDesc(desc.copy())
+        , fRealPathEffect(sk_ref_sp(effects.fPathEffect))
+        , fRealMaskFilter(sk_ref_sp(effects.fMaskFilter)) {}
+
+protected:
+    unsigned generateGlyphCount() override {
+        return fStrike->fTypefaceGlyphCount;
+    }
+
+    uint16_t generateCharToGlyph(SkUnichar uni) override {
+        // The cmap lookup needs no scaler context.
+        SkGlyphID glyph;
+        this->getTypeface()->charsToGlyphs(&uni, SkTypeface::kUTF32_Encoding, &glyph, 1);
+        return glyph;
+    }
+
+    SkUnichar generateGlyphToChar(uint16_t glyphID) override {
+        return this->real()->glyphIDToChar(glyphID);
+    }
+
+    void generateAdvance(SkGlyph* glyph) override {
+        if (const GlyphRecord* record = fStrike->findGlyph(fBase, glyph->getPackedID())) {
+            glyph->fAdvanceX = record->fAdvanceX;
+            glyph->fAdvanceY = record->fAdvanceY;
+        } else {
+            this->real()->getAdvance(glyph);
+        }
+    }
+
+    void generateMetrics(SkGlyph* glyph) override {
+        const GlyphRecord* record = fStrike->findGlyph(fBase, glyph->getPackedID());
+        if (record && !(record->fFlags & kJustAdvance_GlyphFlag)) {
+            record_to_glyph(*record, glyph);
+        } else {
+            this->real()->getMetrics(glyph);
+        }
+    }
+
+    void generateImage(const SkGlyph& glyph) override {
+        const GlyphRecord* record = fStrike->findGlyph(fBase, glyph.getPackedID());
+        if (record && record->fImageOffset) {
+            memcpy(glyph.fImage, fBase + record->fImageOffset, glyph.computeImageSize());
+        } else {
+            this->real()->getImage(glyph);
+        }
+    }
+
+    bool generatePath(SkGlyphID glyphID, SkPath* path) override {
+        // Paths are archived at no subpixel offset; the base class applies the offset.
+        const GlyphRecord* record = fStrike->findGlyph(fBase, SkPackedGlyphID(glyphID));
+        if (record && record->fPathOffset &&
+            path->readFromMemory(fBase + record->fPathOffset, record->fPathSize)) {
+            return true;
+        }
+        return this->real()->getPath(SkPackedGlyphID(glyphID), path);
+    }
+
+    void generateFontMetrics(SkPaint::FontMetrics* metrics) override {
+        *metrics = fStrike->fFontMetrics;
+    }
+
+private:
+    SkScalerContext* real() {
+        if (!fReal) {
+            SkScalerContextEffects effects{fRealPathEffect.get(), fRealMaskFilter.get()};
+            fReal = this->getTypeface()->createScalerContext(effects, fDesc.get());
+        }
+        return fReal.get();
+    }
+
+    sk_sp<SkStrikeArchive>               fArchive;
+    const uint8_t*                       fBase;
+    const SkStrikeArchive::StrikeRecord* fStrike;
+    std::unique_ptr<SkDescriptor>        fDesc;
+    sk_sp<SkPathEffect>                  fRealPathEffect;
+    sk_sp<SkMaskFilter>                  fRealMaskFilter;
+    std::unique_ptr<SkScalerContext>     fReal;
+
+    typedef SkScalerContext INHERITED;
+};
+
+SkStrikeArchive::SkStrikeArchive(sk_sp<SkData> data) : fData(std::move(data)) {}
+
+SkStrikeArchive::~SkStrikeArchive() = default;
+
+bool SkStrikeArchive::Write(const char path[],
+                            std::function<bool(const SkGlyphCache&)> select,
+                            SkStrikeCache* strikeCache) {
+    if (strikeCache == nullptr) {
+        strikeCache = SkStrikeCache::GlobalStrikeCache();
+    }
+
+    // Offsets are into |body| until the layout is known. Nothing is put at 0, which means absent.
+    std::vector<StrikeRecord> strikes;
+    std::vector<uint8_t> body(8);
+    auto append = [&body](const void* data, size_t size) {
+        size_t offset = SkAlign8(body.size());
+        body.resize(offset + size);
+        memcpy(body.data() + offset, data, size);
+        return SkToU32(offset);
+    };
+
+    strikeCache->forEachStrike([&](const SkGlyphCache& cache) {
+        if (select && !select(cache)) {
+            return;
+        }
+
+        std::vector<GlyphRecord> glyphs;
+        cache.forEachGlyph([&](const SkGlyph& glyph) {
+            GlyphRecord record;
+            memset(&record, 0, sizeof(record));
+            record.fPackedID   = glyph.getPackedID().getPackedID();
+            record.fAdvanceX   = glyph.fAdvanceX;
+            record.fAdvanceY   = glyph.fAdvanceY;
+            if (!glyph.isFullMetrics()) {
+                record.fFlags = kJustAdvance_GlyphFlag;
+                glyphs.push_back(record);
+                return;
+            }
+            record.fWidth      = glyph.fWidth;
+            record.fHeight     = glyph.fHeight;
+            record.fTop        = glyph.fTop;
+            record.fLeft       = glyph.fLeft;
+            record.fForceBW    = glyph.fForceBW;
+            record.fMaskFormat = glyph.fMaskFormat;
+            if (glyph.fImage) {
+                record.fImageOffset = append(glyph.fImage, glyph.computeImageSize());
+            }
+            const SkPath* glyphPath = glyph.fPathData ? glyph.fPathData->fPath : nullptr;
+            if (glyphPath && glyph.getPackedID() == SkPackedGlyphID(glyph.getGlyphID())) {
+                std::vector<uint8_t> buffer(glyphPath->writeToMemory(nullptr));
+                glyphPath->writeToMemory(buffer.data());
+                record.fPathOffset = append(buffer.data(), buffer.size());
+                record.fPathSize = SkToU32(buffer.size());
+            }
+            glyphs.push_back(record);
+        });
+        if (glyphs.empty()) {
+            return;
+        }
+        std::sort(glyphs.begin(), glyphs.end(), [](const GlyphRecord& a, const GlyphRecord& b) {
+            return a.fPackedID < b.fPackedID;
+        });
+
+        const SkTypeface* typeface = cache.getScalerContext()->getTypeface();
+        StrikeRecord strike;
+        memset(&strike, 0, sizeof(strike));
+        strike.fTypefaceKey = typeface_key(*typeface);
+        strike.fTypefaceGlyphCount = typeface->countGlyphs();
+        strike.fFontMetrics = cache.getFontMetrics();
+        SkAutoDescriptor ad;
+        const SkDescriptor* desc = normalize_descriptor(cache.getDescriptor(), &ad);
+        strike.fDescOffset = append(desc, desc->getLength());
+        strike.fGlyphOffset = append(glyphs.data(), glyphs.size() * sizeof(GlyphRecord));
+        strike.fGlyphCount = SkToU32(glyphs.size());
+        strikes.push_back(strike);
+    });
+
+    // Rebase every offset now that the body's position is known.
+    uint32_t base = SkToU32(sizeof(Header) + strikes.size() * sizeof(StrikeRecord));
+    for (StrikeRecord& strike : strikes) {
+        auto* glyphs = reinterpret_cast<GlyphRecord*>(body.data() + strike.fGlyphOffset);
+        for (uint32_t i = 0; i < strike.fGlyphCount; i++) {
+            if (glyphs[i].fImageOffset) {
+                glyphs[i].fImageOffset += base;
+            }
+            if (glyphs[i].fPathOffset) {
+                glyphs[i].fPathOffset += base;
+            }
+        }
+        strike.fDescOffset += base;
+        strike.fGlyphOffset += base;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.fMagic, kMagic, sizeof(kMagic));
+    header.fVersion = kVersion;
+    header.fRecSize = sizeof(SkScalerContextRec);
+    header.fStrikeSize = sizeof(StrikeRecord);
+    header.fGlyphSize = sizeof(GlyphRecord);
+    header.fLength = base + body.size();
+    header.fStrikeCount = SkToU32(strikes.size());
+
+    SkFILEWStream stream(path);
+    return stream.isValid() &&
+           stream.write(&header, sizeof(header)) &&
+           stream.write(strikes.data(), strikes.size() * sizeof(StrikeRecord)) &&
+           stream.write(body.data(), body.size());
+}
+
+bool SkStrikeArchive::validate() {
+    const uint8_t* base = fData->bytes();
+    size_t length = fData->size();
+    auto inBounds = [length](uint64_t offset, uint64_t size) {
+        return offset <= length && size <= length - offset;
+    };
+
+    if (length < sizeof(Header)) {
+        return false;
+    }
+    const Header* header = reinterpret_cast<const Header*>(base);
+    if (memcmp(header->fMagic, kMagic, sizeof(kMagic)) != 0 ||
+        header->fVersion != kVersion ||
+        header->fRecSize != sizeof(SkScalerContextRec) ||
+        header->fStrikeSize != sizeof(StrikeRecord) ||
+        header->fGlyphSize != sizeof(GlyphRecord) ||
+        header->fLength != length ||
+        !inBounds(sizeof(Header), (uint64_t)header->fStrikeCount * sizeof(StrikeRecord))) {
+        return false;
+    }
+
+    const StrikeRecord* strikes = reinterpret_cast<const StrikeRecord*>(header + 1);
+    for (uint32_t i = 0; i < header->fStrikeCount; i++) {
+        const StrikeRecord* strike = &strikes[i];
+        if (SkAlign8(strike->fDescOffset) != strike->fDescOffset ||
+            SkAlign8(strike->fGlyphOffset) != strike->fGlyphOffset ||
+            !inBounds(strike->fDescOffset, sizeof(SkDescriptor)) ||
+            !inBounds(strike->fDescOffset, strike->desc(base)->getLength()) ||
+            !strike->desc(base)->isValid() ||
+            !has_rec_entry(*strike->desc(base)) ||
+            !inBounds(strike->fGlyphOffset, (uint64_t)strike->fGlyphCount * sizeof(GlyphRecord))) {
+            return false;
+        }
+
+        const GlyphRecord* glyphs = strike->glyphs(base);
+        for (uint32_t j = 0; j < strike->fGlyphCount; j++) {
+            // computeImageSize() trusts the format to be one it knows.
+            if (glyphs[j].fMaskFormat >= SkMask::kCountMaskFormats ||
+                (glyphs[j].fFlags & ~kJustAdvance_GlyphFlag)) {
+                return false;
+            }
+            // Its metrics come from the real scaler context, so nothing sized by them may be
+            // archived.
+            if ((glyphs[j].fFlags & kJustAdvance_GlyphFlag) &&
+                (glyphs[j].fImageOffset || glyphs[j].fPathOffset)) {
+                return false;
+            }
+            SkGlyph glyph;
+            glyph.initWithGlyphID(SkPackedGlyphID(0));
+            record_to_glyph(glyphs[j], &glyph);
+            if ((j > 0 && glyphs[j - 1].fPackedID >= glyphs[j].fPackedID) ||
+                (glyphs[j].fImageOffset &&
+                 !inBounds(glyphs[j].fImageOffset, glyph.computeImageSize())) ||
+                (glyphs[j].fPathOffset &&
+                 !inBounds(glyphs[j].fPathOffset, glyphs[j].fPathSize))) {
+                return false;
+            }
+        }
+        fStrikes.emplace(strike->desc(base)->getChecksum(), strike);
+    }
+    return true;
+}
+
+const SkStrikeArchive::StrikeRecord* SkStrikeArchive::find(const SkDescriptor& desc,
+                                                           uint64_t typefaceKey) const {
+    auto range = fStrikes.equal_range(desc.getChecksum());
+    for (auto it = range.first; it != range.second; ++it) {
+        const StrikeRecord* strike = it->second;
+        if (strike->fTypefaceKey == typefaceKey && *strike->desc(fData->bytes()) == desc) {
+            return strike;
+        }
+    }
+    return nullptr;
+}
+
+bool SkStrikeArchive::Load(const char path[]) {
+    sk_sp<SkStrikeArchive> archive;
+    if (sk_sp<SkData> data = SkData::MakeFromFileName(path)) {
+        archive.reset(new SkStrikeArchive(std::move(data)));
+        if (!archive->validate()) {
+            archive.reset();
+        }
+    }
+
+    SkAutoMutexAcquire lock(gArchiveMutex);
+    SkSafeUnref(gArchive);
+    gArchive = archive.release();
+    return gArchive != nullptr;
+}
+
+void SkStrikeArchive::Unload() {
+    SkAutoMutexAcquire lock(gArchiveMutex);
+    SkSafeUnref(gArchive);
+    gArchive = nullptr;
+}
+
+std::unique_ptr<SkScalerContext> SkStrikeArchive::CreateScalerContext(
+        const SkDescriptor& desc, const SkScalerContextEffects& effects,
+        const SkTypeface& typeface) {
+    sk_sp<SkStrikeArchive> archive;
+    {
+        SkAutoMutexAcquire lock(gArchiveMutex);
+        archive = sk_ref_sp(gArchive);
+    }
+    if (!archive) {
+        return nullptr;
+    }
+
+    SkAutoDescriptor ad;
+    const StrikeRecord* strike = archive->find(*normalize_descriptor(desc, &ad),
+                                               typeface_key(typeface));
+    if (!strike) {
+        return nullptr;
+    }
+
+    // The rec the archived glyphs were made with, minus what the real scaler context applies.
+    SkScalerContextRec rec = *static_cast<const SkScalerContextRec*>(
+            desc.findEntry(kRec_SkDescriptorTag, nullptr));
+    rec.fFrameWidth = 0;
+    SkAutoDescriptor plainAd;
+    SkScalerContextEffects noEffects;
+    const SkDescriptor* plainDesc =
+            SkScalerContext::AutoDescriptorGivenRecAndEffects(rec, noEffects, &plainAd);
+
+    const uint8_t* base = archive->fData->bytes();
+    return skstd::make_unique<SkScalerContext_Archive>(
+            std::move(archive), base, strike, sk_ref_sp(const_cast<SkTypeface*>(&typeface)),
+            effects, desc, plainDesc);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkStrikeArchive_DEFINED
+#define SkStrikeArchive_DEFINED
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "SkRefCnt.h"
+
+class SkData;
+class SkDescriptor;
+class SkGlyphCache;
+class SkScalerContext;
+struct SkScalerContextEffects;
+class SkStrikeCache;
+class SkTypeface;
+
+// A file of strikes - descriptor, font metrics, and the metrics, images and paths of their
+// glyphs, or just the advances of glyphs text was only measured with - written before a process
+// exits and mapped back by the next one, so text it drew before is not rasterized again. A strike
+// created for a descriptor found in the loaded archive serves glyphs straight from the mapping;
+// the typeface's own scaler context is only created once a glyph the archive lacks is asked for.
+//
+// Strikes are matched by typeface contents (family, style, glyph count and 'head' table) instead
+// of the per-process font ID, and an archive is only accepted by the build that wrote it. Only
+// local typefaces are supported; do not select strikes of remote (SkStrikeClient) typefaces.
+class SkStrikeArchive : public SkRefCnt {
+public:
+    ~SkStrikeArchive() override;
+
+    // Writes the strikes of |strikeCache|, or the global one, for which |select| returns true, or
+    // all of them. Strikes checked out by other threads meanwhile are skipped.
+    static bool Write(const char path[],
+                      std::function<bool(const SkGlyphCache&)> select = nullptr,
+                      SkStrikeCache* strikeCache = nullptr);
+
+    // Maps |path| and serves strikes from it from then on. Returns false, leaving no archive
+    // loaded, when the file is missing, damaged or written by another build.
+    static bool Load(const char path[]);
+    static void Unload();
+
+    // Used by SkStrikeCache on a miss: a scaler context serving the archived strike for |desc|,
+    // or null when the loaded archive has none.
+    static std::unique_ptr<SkScalerContext> CreateScalerContext(
+            const SkDescriptor& desc, const SkScalerContextEffects& effects,
+            const SkTypeface& typeface);
+
+    struct StrikeRecord;
+
+private:
+    explicit SkStrikeArchive(sk_sp<SkData> data);
+    bool validate();
+    const StrikeRecord* find(const SkDescriptor& desc, uint64_t typefaceKey) const;
+
+    sk_sp<SkData> fData;
+    // Normalized descriptor checksum to strike
+    std::unordered_multimap<uint32_t, const StrikeRecord*> fStrikes;
+};
+
+#endif  // SkStrikeArchive_DEFINED
@@ -7,11 +7,19 @@
 
 #include "SkStrikeCache.h"
 
+#include <algorithm>
 #include <cctype>
+#include <memory>
+#include <vector>
 
+#include "SkDraw.h"
+#include "SkExecutor.h"
 #include "SkGlyphCache.h"
 #include "SkGraphics.h"
 #include "SkMutex.h"
+#include "SkPathEffect.h"
+#include "SkStrikeArchive.h"
+#include "SkTLazy.h"
 #include "SkTraceMemoryDump.h"
 #include "SkTypeface.h"
 #include "SkPaintPriv.h"
@@ -139,7 +147,10 @@ SkExclusiveStrikePtr SkStrikeCache::findOrCreateStrikeExclusive(
 {
     auto cache = this->findStrikeExclusive(desc);
     if (cache == nullptr) {
-        auto scaler = CreateScalerContext(desc, effects, typeface);
+        auto scaler = SkStrikeArchive::CreateScalerContext(desc, effects, typeface);
+        if (scaler == nullptr) {
+            scaler = CreateScalerContext(desc, effects, typeface);
+        }
         cache = this->createStrikeExclusive(desc, std::move(scaler));
     }
     return cache;
@@ -167,6 +178,136 @@ SkExclusiveStrikePtr SkStrikeCache::FindOrCreateStrikeExclusive(const SkPaint& p
             paint, nullptr, kFakeGammaAndBoostContrast, nullptr);
 }
 
+namespace {
+    // Glyphs rasterized per check-out of the strike. A drawing thread that wants the strike
+    // while the warmer holds it builds a duplicate, so keep the check-outs short.
+    constexpr int kPrewarmBatchSize = 32;
+
+    struct PrewarmRequest {
+        SkPaint                       fPaint;
+        SkPaint                       fLayoutPaint;
+        std::vector<SkGlyphID>        fGlyphs;
+        SkTLazy<SkSurfaceProps>       fSurfaceProps;
+        SkScalerContextFlags          fScalerContextFlags;
+        SkMatrix                      fDeviceMatrix;
+        bool                          fAsPaths;
+        std::function<void(int)>      fDone;
+    };
+
+    int prewarm_glyphs(const PrewarmRequest& request) {
+        const SkPaint& paint = request.fPaint;
+        bool asPaths = request.fAsPaths;
+        SkAutoDescriptor ad;
+        SkScalerContextEffects effects;
+        auto desc = SkScalerContext::CreateDescriptorAndEffectsUsingPaint(
+                paint, request.fSurfaceProps.getMaybeNull(), request.fScalerContextFlags,
+                asPaths ? nullptr : &request.fDeviceMatrix, &ad, &effects);
+        auto tf = SkPaintPriv::GetTypefaceOrDefault(paint);
+
+        const std::vector<SkGlyphID>& glyphs = request.fGlyphs;
+        for (size_t i = 0; i < glyphs.size(); i += kPrewarmBatchSize) {
+            auto cache = SkStrikeCache::FindOrCreateStrikeExclusive(*desc, effects, *tf);
+            size_t end = SkTMin(glyphs.size(), i + kPrewarmBatchSize);
+            for (size_t j = i; j < end; j++) {
+                const SkGlyph& glyph = cache->getGlyphIDMetrics(glyphs[j]);
+                if (glyph.fWidth) {
+                    if (asPaths) {
+                        cache->findPath(glyph);
+                    } else {
+                        cache->findImage(glyph);
+                    }
+                }
+            }
+        }
+
+        // drawText lays the text out with advances from the paint's own strike; for outlines
+        // or a scaling device that is another one. See SkGlyphRunBuilder::prepareDrawText.
+        SkAutoDescriptor layoutAd;
+        SkScalerContextEffects layoutEffects;
+        auto layoutDesc = SkScalerContext::CreateDescriptorAndEffectsUsingPaint(
+                request.fLayoutPaint, nullptr, kFakeGammaAndBoostContrast, nullptr,
+                &layoutAd, &layoutEffects);
+        if (*layoutDesc != *desc) {
+            for (size_t i = 0; i < glyphs.size(); i += kPrewarmBatchSize) {
+                auto cache = SkStrikeCache::FindOrCreateStrikeExclusive(*layoutDesc,
+                                                                        layoutEffects, *tf);
+                size_t end = SkTMin(glyphs.size(), i + kPrewarmBatchSize);
+                for (size_t j = i; j < end; j++) {
+                    cache->getGlyphIDMetrics(glyphs[j]);
+                }
+            }
+        }
+
+        // The strike may have been purged, or duplicated by a draw, since the last batch.
+        auto cache = SkStrikeCache::FindStrikeExclusive(*desc);
+        if (cache == nullptr) {
+            return 0;
+        }
+        int resident = 0;
+        for (SkGlyphID glyphID : glyphs) {
+            if (cache->isGlyphCached(glyphID, 0, 0)) {
+                const SkGlyph& glyph = cache->getGlyphIDMetrics(glyphID);
+                if (!glyph.fWidth || (asPaths ? glyph.fPathData != nullptr
+                                              : glyph.fImage != nullptr)) {
+                    resident++;
+                }
+            }
+        }
+        return resident;
+    }
+
+    void run_prewarm(const PrewarmRequest& request) {
+        int resident = prewarm_glyphs(request);
+        if (request.fDone) {
+            request.fDone(resident);
+        }
+    }
+}  // namespace
+
+void SkStrikeCache::PrewarmGlyphs(const SkPaint& paint, const void* text, size_t byteLength,
+                                  const SkSurfaceProps* surfaceProps,
+                                  SkScalerContextFlags scalerContextFlags,
+                                  const SkMatrix& deviceMatrix,
+                                  SkExecutor* executor,
+                                  std::function<void(int resident)> done) {
+    std::unique_ptr<PrewarmRequest> request(new PrewarmRequest);
+    request->fPaint = paint;
+    request->fPaint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    if (surfaceProps) {
+        request->fSurfaceProps.init(*surfaceProps);
+    }
+    request->fScalerContextFlags = scalerContextFlags;
+    request->fDeviceMatrix = deviceMatrix;
+    request->fDone = std::move(done);
+    request->fLayoutPaint = request->fPaint;
+
+    // Warm the strike the draw will use; text too big for the cache is drawn from outlines,
+    // see SkDraw::drawPosText_asPaths.
+    request->fAsPaths = SkDraw::ShouldDrawTextAsPaths(paint, deviceMatrix);
+    if (request->fAsPaths) {
+        request->fPaint.setupForAsPaths();
+        request->fPaint.setStyle(SkPaint::kFill_Style);
+        request->fPaint.setPathEffect(nullptr);
+    }
+
+    // Only cmap lookups; the rasterizing is left for the executor.
+    std::vector<SkGlyphID>& glyphs = request->fGlyphs;
+    glyphs.resize(paint.textToGlyphs(text, byteLength, nullptr));
+    paint.textToGlyphs(text, byteLength, glyphs.data());
+    std::sort(glyphs.begin(), glyphs.end());
+    glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
+
+    // Through addTask, so the request is the only allocation whatever the executor.
+    if (executor) {
+        executor->addTask([](void* ctx) {
+            std::unique_ptr<PrewarmRequest> request((PrewarmRequest*)ctx);
+            run_prewarm(*request);
+        }, request.release());
+    } else {
+        run_prewarm(*request);
+    }
+}
+
 void SkStrikeCache::PurgeAll() {
     GlobalStrikeCache()->purgeAll();
 }
@@ -8,6 +8,7 @@
 #ifndef SkStrikeCache_DEFINED
 #define SkStrikeCache_DEFINED
 
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -15,6 +16,7 @@
 #include "SkSpinlock.h"
 #include "SkTemplates.h"
 
+class SkExecutor;
 class SkGlyphCache;
 class SkTraceMemoryDump;
 
@@ -110,6 +112,20 @@ public:
 
     static ExclusiveStrikePtr FindOrCreateStrikeExclusive(const SkPaint& paint);
 
+    // Fills the strike that draws |text| (in the paint's text encoding, so glyph IDs or
+    // characters) on a device with the given props, flags and matrix: glyph images, or outlines
+    // when the text is too big for images, and the advances drawText lays it out with. The
+    // strike is checked out a few glyphs at a time, so drawing threads are never kept from it
+    // for long. Runs on |executor|, or on the calling thread when it is null, then calls |done|
+    // with how many of the distinct glyphs are resident; fewer than asked if the cache budget
+    // cannot hold them all.
+    static void PrewarmGlyphs(const SkPaint& paint, const void* text, size_t byteLength,
+                              const SkSurfaceProps* surfaceProps,
+                              SkScalerContextFlags scalerContextFlags,
+                              const SkMatrix& deviceMatrix,
+                              SkExecutor* executor,
+                              std::function<void(int resident)> done = nullptr);
+
     static std::unique_ptr<SkScalerContext> CreateScalerContext(
             const SkDescriptor&, const SkScalerContextEffects&, const SkTypeface&);
 
@@ -148,6 +164,7 @@ public:
 #endif
 
 private:
+    friend class SkStrikeArchive;  // for forEachStrike()
 
     // The following methods can only be called when mutex is already held.
     Node* internalGetHead() const { return fHead; }
@@ -7,25 +7,52 @@
 
 #include "SkExecutor.h"
 #include "SkTaskGroup.h"
+#include <memory>
 
 SkTaskGroup::SkTaskGroup(SkExecutor& executor) : fPending(0), fExecutor(executor) {}
 
 void SkTaskGroup::add(std::function<void(void)> fn) {
+    struct Task {
+        std::function<void(void)> fFn;
+        SkTaskGroup*              fGroup;
+    };
     fPending.fetch_add(+1, std::memory_order_relaxed);
-    fExecutor.add([=] {
-        fn();
-        fPending.fetch_add(-1, std::memory_order_release);
-    });
+    fExecutor.addTask([](void* ctx) {
+        std::unique_ptr<Task> task((Task*)ctx);
+        task->fFn();
+        SkTaskGroup* group = task->fGroup;
+        task.reset();
+        group->fPending.fetch_add(-1, std::memory_order_release);
+    }, new Task{std::move(fn), this});
 }
 
 void SkTaskGroup::batch(int N, std::function<void(int)> fn) {
-    // TODO: I really thought we had some sort of more clever chunking logic.
+    // One Batch is shared by all N tasks, each running the next index not yet taken,
+    // so adding them allocates once rather than once per task.
+    struct Batch {
+        Batch(std::function<void(int)>&& fn, SkTaskGroup* group, int N)
+                : fFn(std::move(fn)), fGroup(group), fNext(0), fLeft(N) {}
+
+        std::function<void(int)> fFn;
+        SkTaskGroup*             fGroup;
+        std::atomic<int>         fNext;
+        std::atomic<int>         fLeft;
+    };
+    if (N <= 0) {
+        return;
+    }
     fPending.fetch_add(+N, std::memory_order_relaxed);
+    Batch* batch = new Batch(std::move(fn), this, N);
     for (int i = 0; i < N; i++) {
-        fExecutor.add([=] {
-            fn(i);
-            fPending.fetch_add(-1, std::memory_order_release);
-        });
+        fExecutor.addTask([](void* ctx) {
+            Batch* batch = (Batch*)ctx;
+            batch->fFn(batch->fNext.fetch_add(1, std::memory_order_relaxed));
+            SkTaskGroup* group = batch->fGroup;
+            if (batch->fLeft.fetch_add(-1, std::memory_order_acq_rel) == 1) {
+                delete batch;
+            }
+            group->fPending.fetch_add(-1, std::memory_order_release);
+        }, batch);
     }
 }
 
@@ -23,6 +23,7 @@ public:
     void add(std::function<void(void)> fn);
 
     // Add a batch of N tasks, all calling fn with different arguments.
+    // The tasks share fn, so it may be called on several threads at once.
     void batch(int N, std::function<void(int)> fn);
 
     // Returns true if all Tasks previously add()ed to this SkTaskGroup have run.
@@ -67,8 +67,9 @@ void SkFlexibleTaskGroup2D::work(int threadId) {
             }
             // isFinishing can never go from true to false. Once it's true, we count how many rows
             // are completed (out of work). If that count reaches fHeight, then we're out of work
-            // for the whole group and we can stop.
-            if (rowData.fNextColumn == fWidth && this->isFinishing()) {
+            // for the whole group and we can stop. Check isFinishing first: only then is fWidth
+            // final, otherwise a column added between the two reads would be skipped.
+            if (this->isFinishing() && rowData.fNextColumn == fWidth) {
                 numRowsCompleted += (completedRows[row] == false);
                 completedRows[row] = true; // so we won't count this row twice
             }
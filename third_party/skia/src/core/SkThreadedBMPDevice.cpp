@@ -25,12 +25,20 @@ bool SkThreadedBMPDevice::DrawQueue::work2D(int row, int column, int thread) {
 }
 
 void SkThreadedBMPDevice::DrawQueue::reset() {
-    if (fTasks) {
-        fTasks->finish();
+    this->finish();
+    fTasks.reset();
+
+    // Release what the draws hold on to, like snapped bitmaps, instead of waiting for the slots
+    // to be reused.
+    for (int i = 0; i < fSize; ++i) {
+        fElements[i].~DrawElement();
+        new (&fElements[i]) DrawElement();
     }
+    fSize = 0;
+}
 
+void SkThreadedBMPDevice::DrawQueue::start() {
     fThreadAllocs.reset(fDevice->fThreadCnt);
-    fSize = 0;
 
     // using TaskGroup2D = SkSpinningTaskGroup2D;
     using TaskGroup2D = SkFlexibleTaskGroup2D;
@@ -43,8 +51,9 @@ void SkThreadedBMPDevice::DrawQueue::reset() {
 SkThreadedBMPDevice::SkThreadedBMPDevice(const SkBitmap& bitmap,
                                          int tiles,
                                          int threads,
-                                         SkExecutor* executor)
-        : INHERITED(bitmap)
+                                         SkExecutor* executor,
+                                         const SkSurfaceProps& props)
+        : INHERITED(bitmap, props, nullptr, nullptr)
         , fTileCnt(tiles)
         , fThreadCnt(threads <= 0 ? tiles : threads)
         , fQueue(this)
@@ -62,7 +71,6 @@ SkThreadedBMPDevice::SkThreadedBMPDevice(const SkBitmap& bitmap,
     for(int tid = 0; tid < fTileCnt; ++tid, top += h) {
         fTileBounds.push_back(SkIRect::MakeLTRB(0, top, w, top + h));
     }
-    fQueue.reset();
 }
 
 void SkThreadedBMPDevice::flush() {
@@ -70,9 +78,38 @@ void SkThreadedBMPDevice::flush() {
     fAlloc.reset();
 }
 
+bool SkThreadedBMPDevice::onReadPixels(const SkPixmap& pm, int x, int y) {
+    this->flush();
+    return this->INHERITED::onReadPixels(pm, x, y);
+}
+
+bool SkThreadedBMPDevice::onWritePixels(const SkPixmap& pm, int x, int y) {
+    this->flush();
+    return this->INHERITED::onWritePixels(pm, x, y);
+}
+
+bool SkThreadedBMPDevice::onPeekPixels(SkPixmap* pmap) {
+    this->flush();
+    return this->INHERITED::onPeekPixels(pmap);
+}
+
+bool SkThreadedBMPDevice::onAccessPixels(SkPixmap* pmap) {
+    this->flush();
+    return this->INHERITED::onAccessPixels(pmap);
+}
+
+void SkThreadedBMPDevice::replaceBitmapBackendForRasterSurface(const SkBitmap& bm) {
+    // Queued draws hold on to the old pixels.
+    this->flush();
+    this->INHERITED::replaceBitmapBackendForRasterSurface(bm);
+}
+
 SkThreadedBMPDevice::DrawState::DrawState(SkThreadedBMPDevice* dev) {
-    // we need fDst to be set, and if we're actually drawing, to dirty the genID
-    if (!dev->accessPixels(&fDst)) {
+    // we need fDst to be set, and if we're actually drawing, to dirty the genID; go to the bitmap
+    // directly, since accessPixels() would wait for the queue we're pushing to
+    if (dev->fBitmap.peekPixels(&fDst)) {
+        dev->fBitmap.notifyPixelsChanged();
+    } else {
         // NoDrawDevice uses us (why?) so we have to catch this case w/ no pixels
         fDst.reset(dev->imageInfo(), nullptr, 0);
     }
@@ -95,6 +132,7 @@ SkThreadedBMPDevice::TileDraw::TileDraw(const DrawState& ds, const SkIRect& tile
     fMatrix = &ds.fMatrix;
     fTileRC.op(tileBounds, SkRegion::kIntersect_Op);
     fRC = &fTileRC;
+    fPathRC = &ds.fRC;
 }
 
 static inline SkRect get_fast_bounds(const SkRect& r, const SkPaint& p) {
@@ -107,6 +145,42 @@ static inline SkRect get_fast_bounds(const SkRect& r, const SkPaint& p) {
     return result;
 }
 
+// Conservative bounds of positioned glyphs: the union of their origins outset by the font's
+// bounding box, then by whatever the paint adds. Glyphs aligned off their origin or emboldened,
+// and fonts without a bounding box, fall back to drawing on every tile.
+static SkRect get_text_bounds(const SkScalar pos[], int count, int scalarsPerPos,
+                              const SkPoint& offset, const SkPaint& paint) {
+    SkRect fontBounds = paint.getFontBounds();
+    if (count == 0 || fontBounds.isEmpty() || scalarsPerPos < 1 || scalarsPerPos > 2 ||
+        paint.getTextAlign() != SkPaint::kLeft_Align || paint.isVerticalText() ||
+        paint.isFakeBoldText()) {
+        return SkRectPriv::MakeLargest();
+    }
+
+    SkScalar minX = pos[0], maxX = pos[0];
+    SkScalar minY = 0, maxY = 0;
+    if (scalarsPerPos == 2) {
+        minY = maxY = pos[1];
+    }
+    for (int i = 1; i < count; ++i) {
+        const SkScalar* p = pos + i * scalarsPerPos;
+        minX = SkTMin(minX, p[0]);
+        maxX = SkTMax(maxX, p[0]);
+        if (scalarsPerPos == 2) {
+            minY = SkTMin(minY, p[1]);
+            maxY = SkTMax(maxY, p[1]);
+        }
+    }
+
+    SkRect bounds = SkRect::MakeLTRB(minX + fontBounds.fLeft, minY + fontBounds.fTop,
+                                     maxX + fontBounds.fRight, maxY + fontBounds.fBottom);
+    bounds.offset(offset);
+    if (!bounds.isFinite()) {
+        return SkRectPriv::MakeLargest();
+    }
+    return get_fast_bounds(bounds, paint);
+}
+
 void SkThreadedBMPDevice::drawPaint(const SkPaint& paint) {
     SkRect drawBounds = SkRectPriv::MakeLargest();
     fQueue.push(drawBounds, [=](SkArenaAlloc*, const DrawState& ds, const SkIRect& tileBounds){
@@ -163,6 +237,15 @@ void SkThreadedBMPDevice::drawPath(const SkPath& path, const SkPaint& paint,
     }
 }
 
+void SkThreadedBMPDevice::drawDevice(SkBaseDevice* device, int x, int y, const SkPaint& paint) {
+    // Layers tracking coverage are drawn straight into our pixels; everything else goes through
+    // drawSprite.
+    if (static_cast<SkBitmapDevice*>(device)->fCoverage) {
+        this->flush();
+    }
+    this->INHERITED::drawDevice(device, x, y, paint);
+}
+
 SkBitmap SkThreadedBMPDevice::snapBitmap(const SkBitmap& bitmap) {
     // We can't use bitmap.isImmutable() because it could be temporarily immutable
     // TODO(liyuqian): use genID to reduce the copy frequency
@@ -212,9 +295,10 @@ void SkThreadedBMPDevice::drawSprite(const SkBitmap& bitmap, int x, int y, const
 
 void SkThreadedBMPDevice::drawPosText(const void* text, size_t len, const SkScalar xpos[],
         int scalarsPerPos, const SkPoint& offset, const SkPaint& paint) {
+    int count = paint.countText(text, len);
     char* clonedText = this->cloneArray((const char*)text, len);
-    SkScalar* clonedXpos = this->cloneArray(xpos, paint.countText(text, len) * scalarsPerPos);
-    SkRect drawBounds = SkRectPriv::MakeLargest(); // TODO tighter drawBounds
+    SkScalar* clonedXpos = this->cloneArray(xpos, count * scalarsPerPos);
+    SkRect drawBounds = get_text_bounds(xpos, count, scalarsPerPos, offset, paint);
     SkSurfaceProps prop(SkBitmapDeviceFilteredSurfaceProps(fBitmap, paint, this->surfaceProps())());
     fQueue.push(drawBounds, [=](SkArenaAlloc*, const DrawState& ds, const SkIRect& tileBounds){
         TileDraw(ds, tileBounds).drawPosText(clonedText, len, clonedXpos, scalarsPerPos, offset,
@@ -19,7 +19,9 @@ public:
     // When threads = 0, we make fThreadCnt = tiles. Otherwise fThreadCnt = threads.
     // When executor = nullptr, we manages the thread pool. Otherwise, the caller manages it.
     SkThreadedBMPDevice(const SkBitmap& bitmap, int tiles, int threads = 0,
-                        SkExecutor* executor = nullptr);
+                        SkExecutor* executor = nullptr,
+                        const SkSurfaceProps& props =
+                                SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType));
 
     ~SkThreadedBMPDevice() override { fQueue.finish(); }
 
@@ -42,12 +44,25 @@ protected:
                     const SkPaint&) override;
     void drawBitmapRect(const SkBitmap& bitmap, const SkRect* src, const SkRect& dst,
                         const SkPaint& paint, SkCanvas::SrcRectConstraint constraint) override;
+    void drawDevice(SkBaseDevice*, int x, int y, const SkPaint&) override;
 
     sk_sp<SkSpecialImage> snapSpecial() override;
 
+    // Direct pixel access waits for the queued draws.
+    bool onReadPixels(const SkPixmap&, int x, int y) override;
+    bool onWritePixels(const SkPixmap&, int x, int y) override;
+    bool onPeekPixels(SkPixmap*) override;
+    bool onAccessPixels(SkPixmap*) override;
+
     void flush() override;
 
 private:
+    // Inherited entry points not listed above end up in one of the overrides, except
+    // onCreateDevice: layers are plain SkBitmapDevices drawn on the calling thread, and
+    // drawDevice() tiles compositing them back. drawSpecial() runs the image filter on the
+    // calling thread and tiles the drawSprite() of its result.
+    void replaceBitmapBackendForRasterSurface(const SkBitmap&) override;
+
     // We store DrawState inside DrawElement because inifFn and drawFn both want to use it
     struct DrawState {
         SkPixmap fDst;
@@ -129,11 +144,17 @@ private:
         static constexpr int MAX_QUEUE_SIZE = 100000;
 
         DrawQueue(SkThreadedBMPDevice* device) : fDevice(device) {}
+
+        // Waits for the queued draws and empties the queue. Tasks are only started by the next
+        // push, so the threads don't spin while nothing is queued.
         void reset();
 
-        // For ~SkThreadedBMPDevice() to shutdown tasks, we use this instead of reset because reset
-        // will start new tasks.
-        void finish() { fTasks->finish(); }
+        // For ~SkThreadedBMPDevice() to shutdown tasks.
+        void finish() {
+            if (fTasks) {
+                fTasks->finish();
+            }
+        }
 
         // Push a draw command into the queue. If Fn is DrawFn, we're pushing an element without
         // the need of initialization. If Fn is InitFn, we're pushing an element with init-once
@@ -143,6 +164,9 @@ private:
             if (fSize == MAX_QUEUE_SIZE) {
                 this->reset();
             }
+            if (!fTasks) {
+                this->start();
+            }
             SkASSERT(fSize < MAX_QUEUE_SIZE);
             SkIRect drawBounds = fDevice->transformDrawBounds<useCTM>(rawDrawBounds);
             fElements[fSize].~DrawElement(); // release previous resources to prevent memory leak
@@ -155,11 +179,13 @@ private:
         bool work2D(int row, int column, int thread) override;
 
     private:
+        void start();
+
         SkThreadedBMPDevice*                fDevice;
         std::unique_ptr<SkTaskGroup2D>      fTasks;
         SkTArray<SkSTArenaAlloc<8 << 10>>   fThreadAllocs; // 8k stack size
         DrawElement                         fElements[MAX_QUEUE_SIZE];
-        int                                 fSize;
+        int                                 fSize = 0;
     };
 
     template<bool useCTM = true>
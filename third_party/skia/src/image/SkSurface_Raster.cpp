@@ -11,6 +11,7 @@
 #include "SkCanvas.h"
 #include "SkDevice.h"
 #include "SkMallocPixelRef.h"
+#include "SkThreadedBMPDevice.h"
 
 class SkSurface_Raster : public SkSurface_Base {
 public:
@@ -27,7 +28,7 @@ public:
     void onCopyOnWrite(ContentChangeMode) override;
     void onRestoreBackingMutability() override;
 
-private:
+protected:
     SkBitmap    fBitmap;
     size_t      fRowBytes;
     bool        fWeOwnThePixels;
@@ -35,6 +36,32 @@ private:
     typedef SkSurface_Base INHERITED;
 };
 
+// Draws through an SkThreadedBMPDevice. Everything that touches fBitmap outside of the canvas
+// waits for the draws queued on the device first.
+class SkSurface_RasterThreaded : public SkSurface_Raster {
+public:
+    SkSurface_RasterThreaded(const SkImageInfo& info, sk_sp<SkPixelRef> pr, int tiles,
+                             SkExecutor* executor, const SkSurfaceProps* props)
+        : INHERITED(info, std::move(pr), props)
+        , fTiles(tiles)
+        , fExecutor(executor) {}
+
+    SkCanvas* onNewCanvas() override;
+    sk_sp<SkSurface> onNewSurface(const SkImageInfo&) override;
+    sk_sp<SkImage> onNewImageSnapshot() override;
+    void onWritePixels(const SkPixmap&, int x, int y) override;
+    void onDraw(SkCanvas*, SkScalar x, SkScalar y, const SkPaint*) override;
+    void onCopyOnWrite(ContentChangeMode) override;
+
+private:
+    void flushCanvas();
+
+    int         fTiles;
+    SkExecutor* fExecutor;
+
+    typedef SkSurface_Raster INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool SkSurfaceValidateRasterInfo(const SkImageInfo& info, size_t rowBytes) {
@@ -178,6 +205,44 @@ void SkSurface_Raster::onCopyOnWrite(ContentChangeMode mode) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void SkSurface_RasterThreaded::flushCanvas() {
+    if (SkCanvas* canvas = this->getCachedCanvas()) {
+        canvas->flush();
+    }
+}
+
+SkCanvas* SkSurface_RasterThreaded::onNewCanvas() {
+    return new SkCanvas(sk_make_sp<SkThreadedBMPDevice>(fBitmap, fTiles, 0, fExecutor,
+                                                        this->props()));
+}
+
+sk_sp<SkSurface> SkSurface_RasterThreaded::onNewSurface(const SkImageInfo& info) {
+    return SkSurface::MakeRasterThreaded(info, fTiles, fExecutor, &this->props());
+}
+
+sk_sp<SkImage> SkSurface_RasterThreaded::onNewImageSnapshot() {
+    this->flushCanvas();
+    return this->INHERITED::onNewImageSnapshot();
+}
+
+void SkSurface_RasterThreaded::onWritePixels(const SkPixmap& src, int x, int y) {
+    this->flushCanvas();
+    this->INHERITED::onWritePixels(src, x, y);
+}
+
+void SkSurface_RasterThreaded::onDraw(SkCanvas* canvas, SkScalar x, SkScalar y,
+                                      const SkPaint* paint) {
+    this->flushCanvas();
+    this->INHERITED::onDraw(canvas, x, y, paint);
+}
+
+void SkSurface_RasterThreaded::onCopyOnWrite(ContentChangeMode mode) {
+    this->flushCanvas();
+    this->INHERITED::onCopyOnWrite(mode);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 sk_sp<SkSurface> SkSurface::MakeRasterDirectReleaseProc(const SkImageInfo& info, void* pixels,
         size_t rb, void (*releaseProc)(void* pixels, void* context), void* context,
         const SkSurfaceProps* props) {
@@ -214,3 +279,17 @@ sk_sp<SkSurface> SkSurface::MakeRaster(const SkImageInfo& info, size_t rowBytes,
     }
     return sk_make_sp<SkSurface_Raster>(info, std::move(pr), props);
 }
+
+sk_sp<SkSurface> SkSurface::MakeRasterThreaded(const SkImageInfo& info, int tiles,
+                                               SkExecutor* executor,
+                                               const SkSurfaceProps* props) {
+    if (!SkSurfaceValidateRasterInfo(info) || tiles <= 0) {
+        return nullptr;
+    }
+
+    sk_sp<SkPixelRef> pr = SkMallocPixelRef::MakeZeroed(info, 0);
+    if (!pr) {
+        return nullptr;
+    }
+    return sk_make_sp<SkSurface_RasterThreaded>(info, std::move(pr), tiles, executor, props);
+}
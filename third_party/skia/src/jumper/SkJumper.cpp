@@ -10,14 +10,15 @@
 #include "SkRasterPipeline.h"
 #include "SkTemplates.h"
 
-SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) const {
+SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(const StageList* stages,
+                                                                   void** ip) const {
 #ifndef SK_JUMPER_DISABLE_8BIT
     // We'll try to build a lowp pipeline, but if that fails fallback to a highp float pipeline.
     void** reset_point = ip;
 
     // Stages are stored backwards in fStages, so we reverse here, back to front.
     *--ip = (void*)SkOpts::just_return_lowp;
-    for (const StageList* st = fStages; st; st = st->prev) {
+    for (const StageList* st = stages; st; st = st->prev) {
         if (st->stage == SkRasterPipeline::clamp_0 ||
             st->stage == SkRasterPipeline::clamp_1) {
             continue;  // No-ops in lowp.
@@ -39,7 +40,7 @@ SkRasterPipeline::StartPipelineFn SkRasterPipeline::build_pipeline(void** ip) co
 #endif
 
     *--ip = (void*)SkOpts::just_return_highp;
-    for (const StageList* st = fStages; st; st = st->prev) {
+    for (const StageList* st = stages; st; st = st->prev) {
         if (st->ctx) {
             *--ip = st->ctx;
         }
@@ -60,7 +61,7 @@ void SkRasterPipeline::run(size_t x, size_t y, size_t w, size_t h) const {
     // Best to not use fAlloc here... we can't bound how often run() will be called.
     SkAutoSTMalloc<64, void*> program(fSlotsNeeded);
 
-    auto start_pipeline = this->build_pipeline(program.get() + fSlotsNeeded);
+    auto start_pipeline = this->build_pipeline(fStages, program.get() + fSlotsNeeded);
     start_pipeline(x,y,x+w,y+h, program.get());
 }
 
@@ -69,9 +70,12 @@ std::function<void(size_t, size_t, size_t, size_t)> SkRasterPipeline::compile()
         return [](size_t, size_t, size_t, size_t) {};
     }
 
-    void** program = fAlloc->makeArray<void*>(fSlotsNeeded);
+    int slotsNeeded;
+    const StageList* stages = this->fuse(&slotsNeeded);
+    void** program = fAlloc->makeArray<void*>(slotsNeeded);
 
-    auto start_pipeline = this->build_pipeline(program + fSlotsNeeded);
+    auto start_pipeline = this->build_pipeline(stages, program + slotsNeeded);
+    RecordShape(stages, start_pipeline == SkOpts::start_pipeline_lowp);
     return [=](size_t x, size_t y, size_t w, size_t h) {
         start_pipeline(x,y,x+w,y+h, program);
     };
@@ -66,6 +66,12 @@ struct SkJumper_ParametricTransferFunction {
     float G, A,B,C,D,E,F;
 };
 
+// Context of the fused stages, e.g. srcover_u8_8888: those of the stages they replace.
+struct SkJumper_FusedCtx {
+    const void*               coverage;  // SkJumper_MemoryCtx for _u8, float for _1_float.
+    const SkJumper_MemoryCtx* dst;
+};
+
 struct SkJumper_GradientCtx {
     size_t stopCount;
     float* fs[4];
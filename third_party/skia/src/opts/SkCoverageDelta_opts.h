@@ -0,0 +1,176 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkCoverageDelta_opts_DEFINED
+#define SkCoverageDelta_opts_DEFINED
+
+#include "SkCoverageDelta.h"
+#include "SkNx.h"
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace SK_OPTS_NS {
+
+// Sum count deltas, a multiple of SkCoverageDeltaMask::SIMD_WIDTH, into coverages, and convert
+// those to alphas. Integer sums wrap the same in any order, and out-of-range alphas saturate
+// to [0, 255] as SkNx_cast<uint8_t> does, so every version writes the same alphas.
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SKX
+
+    // Shift v up by n lanes, shifting in zeros.
+    template <int n>
+    static inline __m512i shift_lanes_up(__m512i v) {
+        return _mm512_alignr_epi32(v, _mm512_setzero_si512(), 16 - n);
+    }
+
+    static inline __m512i prefix_sum(__m512i v, __m512i carry) {
+        v = _mm512_add_epi32(v, shift_lanes_up<1>(v));
+        v = _mm512_add_epi32(v, shift_lanes_up<2>(v));
+        v = _mm512_add_epi32(v, shift_lanes_up<4>(v));
+        v = _mm512_add_epi32(v, shift_lanes_up<8>(v));
+        return _mm512_add_epi32(v, carry);
+    }
+
+    static inline __m512i to_alpha(__m512i c, bool isEvenOdd, bool isInverse, bool isConvex) {
+        __m512i a;
+        if (isConvex) {
+            a = _mm512_srai_epi32(_mm512_abs_epi32(c), 8);
+            a = _mm512_sub_epi32(a, _mm512_srai_epi32(a, 8));    // 256 to 255
+        } else {
+            if (isEvenOdd) {
+                __m512i mod17 = _mm512_and_si512(c, _mm512_set1_epi32(0x1ffff));
+                __m512i mod16 = _mm512_and_si512(c, _mm512_set1_epi32(0xffff));
+                c = _mm512_sub_epi32(_mm512_slli_epi32(mod16, 1), mod17);
+            }
+            a = _mm512_srai_epi32(_mm512_abs_epi32(c), 8);
+            a = _mm512_max_epi32(_mm512_min_epi32(a, _mm512_set1_epi32(255)),
+                                 _mm512_setzero_si512());
+        }
+        if (isInverse) {
+            a = _mm512_sub_epi32(_mm512_set1_epi32(255), a);
+        }
+        return _mm512_max_epi32(_mm512_min_epi32(a, _mm512_set1_epi32(255)),
+                                _mm512_setzero_si512());
+    }
+
+    static void coverage_deltas_to_alphas(const SkFixed* deltas, SkAlpha* alphas, int count,
+                                          bool isEvenOdd, bool isInverse, bool isConvex) {
+        SkASSERT(count % SkCoverageDeltaMask::SIMD_WIDTH == 0);
+        const __m512i last = _mm512_set1_epi32(15);
+        __m512i carry = _mm512_setzero_si512();
+        auto step = [&](int i) {
+            __m512i c = prefix_sum(_mm512_loadu_si512(deltas + i), carry);
+            carry = _mm512_permutexvar_epi32(last, c);
+            _mm_storeu_si128((__m128i*)(alphas + i),
+                             _mm512_cvtepi32_epi8(to_alpha(c, isEvenOdd, isInverse, isConvex)));
+        };
+        int i = 0;
+        for (; i + 32 <= count; i += 32) {
+            step(i);
+            step(i + 16);
+        }
+        for (; i + 16 <= count; i += 16) {
+            step(i);
+        }
+        if (i < count) {
+            // The last 8; go through a buffer rather than reading past the deltas.
+            SkFixed tail[16] = {0};
+            memcpy(tail, deltas + i, 8 * sizeof(SkFixed));
+            __m512i c = prefix_sum(_mm512_loadu_si512(tail), carry);
+            __m128i a = _mm512_cvtepi32_epi8(to_alpha(c, isEvenOdd, isInverse, isConvex));
+            _mm_storel_epi64((__m128i*)(alphas + i), a);
+        }
+    }
+
+#elif SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+    static inline __m256i prefix_sum(__m256i v, __m256i carry) {
+        // Sum within each 128-bit half, then add the low half's total to the high half.
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+        __m256i lowTotal = _mm256_shuffle_epi32(_mm256_permute2x128_si256(v, v, 0x08), 0xff);
+        return _mm256_add_epi32(_mm256_add_epi32(v, lowTotal), carry);
+    }
+
+    static inline __m256i to_alpha(__m256i c, bool isEvenOdd, bool isInverse, bool isConvex) {
+        __m256i a;
+        if (isConvex) {
+            a = _mm256_srai_epi32(_mm256_abs_epi32(c), 8);
+            a = _mm256_sub_epi32(a, _mm256_srai_epi32(a, 8));    // 256 to 255
+        } else {
+            if (isEvenOdd) {
+                __m256i mod17 = _mm256_and_si256(c, _mm256_set1_epi32(0x1ffff));
+                __m256i mod16 = _mm256_and_si256(c, _mm256_set1_epi32(0xffff));
+                c = _mm256_sub_epi32(_mm256_slli_epi32(mod16, 1), mod17);
+            }
+            a = _mm256_srai_epi32(_mm256_abs_epi32(c), 8);
+            a = _mm256_max_epi32(_mm256_min_epi32(a, _mm256_set1_epi32(255)),
+                                 _mm256_setzero_si256());
+        }
+        if (isInverse) {
+            a = _mm256_sub_epi32(_mm256_set1_epi32(255), a);
+        }
+        return a;   // Saturated by the packs below
+    }
+
+    static void coverage_deltas_to_alphas(const SkFixed* deltas, SkAlpha* alphas, int count,
+                                          bool isEvenOdd, bool isInverse, bool isConvex) {
+        SkASSERT(count % SkCoverageDeltaMask::SIMD_WIDTH == 0);
+        const __m256i last = _mm256_set1_epi32(7);
+        __m256i carry = _mm256_setzero_si256();
+        auto next = [&](int i) {
+            __m256i c = prefix_sum(_mm256_loadu_si256((const __m256i*)(deltas + i)), carry);
+            carry = _mm256_permutevar8x32_epi32(c, last);
+            return to_alpha(c, isEvenOdd, isInverse, isConvex);
+        };
+        int i = 0;
+        for (; i + 32 <= count; i += 32) {
+            __m256i a = next(i), b = next(i + 8), c = next(i + 16), d = next(i + 24);
+            // The packs work within 128-bit halves, leaving the 4-byte groups as
+            // a0 b0 c0 d0 a1 b1 c1 d1; put them back in order.
+            __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                                                _mm256_packs_epi32(c, d));
+            bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+            _mm256_storeu_si256((__m256i*)(alphas + i), bytes);
+        }
+        for (; i < count; i += 8) {
+            __m256i a = next(i);
+            __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(a),
+                                            _mm256_extracti128_si256(a, 1));
+            _mm_storel_epi64((__m128i*)(alphas + i), _mm_packus_epi16(words, words));
+        }
+    }
+
+#else
+
+    static void coverage_deltas_to_alphas(const SkFixed* deltas, SkAlpha* alphas, int count,
+                                          bool isEvenOdd, bool isInverse, bool isConvex) {
+        constexpr int SIMD_WIDTH = SkCoverageDeltaMask::SIMD_WIDTH;
+        SkASSERT(count % SIMD_WIDTH == 0);
+        SkFixed c[SIMD_WIDTH] = {0}; // prepare SIMD_WIDTH coverages at a time
+        for(int ix = 0; ix < count; ix += SIMD_WIDTH) {
+            // Cumulate deltas to get SIMD_WIDTH new coverages
+            c[0] = c[SIMD_WIDTH - 1] + deltas[ix];
+            for(int j = 1; j < SIMD_WIDTH; ++j) {
+                c[j] = c[j - 1] + deltas[ix + j];
+            }
+
+            using SkNi = SkNx<SIMD_WIDTH, int>;
+            SkNi cn = SkNi::Load(c);
+            SkNi an = isConvex ? ConvexCoverageToAlpha(cn, isInverse)
+                               : CoverageToAlpha(cn, isEvenOdd, isInverse);
+            SkNx_cast<SkAlpha>(an).store(alphas + ix);
+        }
+    }
+
+#endif
+
+}  // namespace SK_OPTS_NS
+
+#endif//SkCoverageDelta_opts_DEFINED
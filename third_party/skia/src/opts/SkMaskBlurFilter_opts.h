@@ -0,0 +1,155 @@
+/*
+ * Copyright 2018 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMaskBlurFilter_opts_DEFINED
+#define SkMaskBlurFilter_opts_DEFINED
+
+#include "SkNx.h"
+#include "SkTemplates.h"
+
+namespace SK_OPTS_NS {
+
+// This is PlanGauss::Scan from SkMaskBlurFilter.cpp run over N rows at once, one row per lane.
+// Every lane follows exactly the scalar arithmetic (uint32_t sums that may wrap, then the same
+// 32.32 fixed-point scale), so the output is bit-identical to the scalar path. Results are
+// written transposed, which puts the N lanes of one output in N adjacent bytes of dst.
+template <int N>
+class BoxBlurRows {
+public:
+    using V = SkNx<N, uint32_t>;
+
+    BoxBlurRows(uint32_t weight, int window0, int window1, int window2, int noChangeCount)
+        : fWeight{weight}
+        , fNoChangeCount{noChangeCount}
+        , fWindows{window0, window1, window2}
+        , fBuffer{static_cast<size_t>(N * (window0 + window1 + window2))} { }
+
+    // Blur rows [0, rows) of src, with rows <= N, into dst[x * dstRB + row].
+    void blur(const uint8_t* src, size_t srcRB, int srcW, int rows,
+              uint8_t* dst, size_t dstRB, int dstW) {
+        const uint8_t* srcRows[N];
+        for (int i = 0; i < N; i++) {
+            // Lanes past the last row repeat it; their results are dropped.
+            srcRows[i] = src + SkTMin(i, rows - 1) * srcRB;
+        }
+
+        uint8_t* dstCursor = dst;
+        auto emit = [&](uint8_t* to, const V& sum2) {
+            // Results never exceed 255, so going through int32_t narrows them exactly.
+            auto bytes = SkNx_cast<uint8_t>(SkNx_cast<int32_t>(this->finalScale(sum2)));
+            if (rows == N) {
+                bytes.store(to);
+            } else {
+                uint8_t lanes[N];
+                bytes.store(lanes);
+                memcpy(to, lanes, rows);
+            }
+        };
+
+        // Consume the source generating pixels.
+        this->reset();
+        for (int x = 0; x < srcW; x++, dstCursor += dstRB) {
+            V leadingEdge = gather(srcRows, x);
+            emit(dstCursor, this->step(leadingEdge));
+        }
+
+        // The leading edge is off the right side of the mask.
+        for (int i = 0; i < fNoChangeCount; i++, dstCursor += dstRB) {
+            emit(dstCursor, this->step(V{0}));
+        }
+
+        // Starting from the right, fill in the rest of the buffer.
+        this->reset();
+        uint8_t* dstEnd = dst + dstW * dstRB;
+        int x = srcW;
+        while (dstEnd > dstCursor) {
+            dstEnd -= dstRB;
+            V leadingEdge = gather(srcRows, --x);
+            emit(dstEnd, this->step(leadingEdge));
+        }
+    }
+
+private:
+    static V gather(const uint8_t* const srcRows[N], int x) {
+        uint32_t lanes[N];
+        for (int i = 0; i < N; i++) {
+            lanes[i] = srcRows[i][x];
+        }
+        return V::Load(lanes);
+    }
+
+    void reset() {
+        memset(fBuffer.get(), 0, N * (fWindows[0] + fWindows[1] + fWindows[2]) * sizeof(uint32_t));
+        uint32_t* buffer = fBuffer.get();
+        for (int i = 0; i < 3; i++) {
+            fRing[i] = fRingBegin[i] = buffer;
+            buffer += N * fWindows[i];
+            fRingEnd[i] = buffer;
+        }
+        fSum0 = fSum1 = fSum2 = V{0};
+    }
+
+    // Replaces the oldest value in ring i with v, returning the value it held.
+    V exchange(int i, const V& v) {
+        V old = V::Load(fRing[i]);
+        v.store(fRing[i]);
+        fRing[i] += N;
+        if (fRing[i] == fRingEnd[i]) {
+            fRing[i] = fRingBegin[i];
+        }
+        return old;
+    }
+
+    V step(const V& leadingEdge) {
+        fSum0 = fSum0 + leadingEdge;
+        fSum1 = fSum1 + fSum0;
+        fSum2 = fSum2 + fSum1;
+        V result = fSum2;
+
+        fSum2 = fSum2 - this->exchange(2, fSum1);
+        fSum1 = fSum1 - this->exchange(1, fSum0);
+        fSum0 = fSum0 - this->exchange(0, leadingEdge);
+        return result;
+    }
+
+    // (weight * sum + 2^31) >> 32, with the rounding bit taken from the low half.
+    V finalScale(const V& sum) const {
+        V weight{fWeight};
+        return sum.mulHi(weight) + ((sum * weight) >> 31);
+    }
+
+    uint32_t                 fWeight;
+    int                      fNoChangeCount;
+    int                      fWindows[3];
+    SkAutoTMalloc<uint32_t>  fBuffer;
+    uint32_t*                fRing[3];
+    uint32_t*                fRingBegin[3];
+    uint32_t*                fRingEnd[3];
+    V                        fSum0, fSum1, fSum2;
+};
+
+/*not static*/ inline void box_blur_a8_transposed(uint32_t weight,
+                                                  int window0, int window1, int window2,
+                                                  int noChangeCount,
+                                                  const uint8_t* src, size_t srcRB,
+                                                  int srcW, int rows,
+                                                  uint8_t* dst, size_t dstRB, int dstW) {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    // One 256-bit register of 8 rows.
+    static const int N = 8;
+#else
+    static const int N = 4;
+#endif
+    BoxBlurRows<N> scan{weight, window0, window1, window2, noChangeCount};
+    for (int y = 0; y < rows; y += N) {
+        scan.blur(src + y * srcRB, srcRB, srcW, SkTMin(N, rows - y), dst + y, dstRB, dstW);
+    }
+}
+
+}  // namespace SK_OPTS_NS
+
+#endif//SkMaskBlurFilter_opts_DEFINED
@@ -10,7 +10,9 @@
 
 #include "SkTypes.h"
 
-#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE41
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    #include <immintrin.h>
+#elif SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE41
     #include <smmintrin.h>
 #elif SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSSE3
     #include <tmmintrin.h>
@@ -410,6 +412,54 @@ public:
     __m128i fVec;
 };
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+// Without AVX2, Sk8u is the generic pair of Sk4u.
+template <>
+class SkNx<8, uint32_t> {
+public:
+    AI SkNx(const __m256i& vec) : fVec(vec) {}
+
+    AI SkNx() {}
+    AI SkNx(uint32_t val) : fVec(_mm256_set1_epi32(val)) {}
+    AI static SkNx Load(const void* ptr) { return _mm256_loadu_si256((const __m256i*)ptr); }
+    AI SkNx(uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+            uint32_t e, uint32_t f, uint32_t g, uint32_t h)
+        : fVec(_mm256_setr_epi32(a,b,c,d, e,f,g,h)) {}
+
+    AI void store(void* ptr) const { _mm256_storeu_si256((__m256i*)ptr, fVec); }
+
+    AI SkNx operator + (const SkNx& o) const { return _mm256_add_epi32(fVec, o.fVec);   }
+    AI SkNx operator - (const SkNx& o) const { return _mm256_sub_epi32(fVec, o.fVec);   }
+    AI SkNx operator * (const SkNx& o) const { return _mm256_mullo_epi32(fVec, o.fVec); }
+
+    AI SkNx operator & (const SkNx& o) const { return _mm256_and_si256(fVec, o.fVec); }
+    AI SkNx operator | (const SkNx& o) const { return _mm256_or_si256(fVec, o.fVec);  }
+    AI SkNx operator ^ (const SkNx& o) const { return _mm256_xor_si256(fVec, o.fVec); }
+
+    AI SkNx operator << (int bits) const { return _mm256_slli_epi32(fVec, bits); }
+    AI SkNx operator >> (int bits) const { return _mm256_srli_epi32(fVec, bits); }
+
+    AI SkNx operator == (const SkNx& o) const { return _mm256_cmpeq_epi32(fVec, o.fVec); }
+    AI SkNx operator != (const SkNx& o) const { return (*this == o) ^ 0xffffffff; }
+
+    AI uint32_t operator[](int k) const {
+        SkASSERT(0 <= k && k < 8);
+        union { __m256i v; uint32_t us[8]; } pun = {fVec};
+        return pun.us[k&7];
+    }
+
+    AI SkNx mulHi(SkNx m) const {
+        // The high halves of the even lanes' products, then of the odd lanes', interleaved.
+        __m256i v20 = _mm256_srli_epi64(_mm256_mul_epu32(m.fVec, fVec), 32);
+        __m256i v31 = _mm256_mul_epu32(_mm256_srli_epi64(m.fVec, 32), _mm256_srli_epi64(fVec, 32));
+
+        return _mm256_blend_epi32(v20, v31, 0xAA);
+    }
+
+    __m256i fVec;
+};
+#endif
+
 template <>
 class SkNx<4, uint16_t> {
 public:
@@ -810,6 +860,12 @@ template<> AI /*static*/ Sk4i SkNx_cast<int32_t, uint32_t>(const Sk4u& src) {
     return src.fVec;
 }
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+template<> AI /*static*/ Sk8i SkNx_cast<int32_t, uint32_t>(const Sk8u& src) {
+    return { Sk4i{_mm256_castsi256_si128(src.fVec)}, Sk4i{_mm256_extracti128_si256(src.fVec, 1)} };
+}
+#endif
+
 AI static Sk4i Sk4f_round(const Sk4f& x) {
     return _mm_cvtps_epi32(x.fVec);
 }
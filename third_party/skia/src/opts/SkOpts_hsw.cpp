@@ -8,11 +8,16 @@
 #include "SkOpts.h"
 
 #define SK_OPTS_NS hsw
+#include "SkCoverageDelta_opts.h"
+#include "SkMaskBlurFilter_opts.h"
 #include "SkRasterPipeline_opts.h"
 #include "SkUtils_opts.h"
 
 namespace SkOpts {
     void Init_hsw() {
+        box_blur_a8_transposed = hsw::box_blur_a8_transposed;
+        coverage_deltas_to_alphas = hsw::coverage_deltas_to_alphas;
+
     #define M(st) stages_highp[SkRasterPipeline::st] = (StageFn)SK_OPTS_NS::st;
         SK_RASTER_PIPELINE_STAGES(M)
         just_return_highp = (StageFn)SK_OPTS_NS::just_return;
@@ -15,8 +15,9 @@
     #define JUMPER_IS_SCALAR
 #elif defined(__ARM_NEON)
     #define JUMPER_IS_NEON
-#elif defined(__AVX512F__)
-    #define JUMPER_IS_AVX512
+#elif defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512CD__) && \
+      defined(__AVX512BW__) && defined(__AVX512VL__)
+    #define JUMPER_IS_SKX
 #elif defined(__AVX2__) && defined(__F16C__) && defined(__FMA__)
     #define JUMPER_IS_HSW
 #elif defined(__AVX__)
@@ -221,7 +222,163 @@ namespace SK_OPTS_NS {
         }
     }
 
-#elif defined(JUMPER_IS_AVX) || defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+#elif defined(JUMPER_IS_SKX)
+    // These are __m512 and __m512i, but friendlier and strongly-typed.
+    template <typename T> using V = T __attribute__((ext_vector_type(16)));
+    using F   = V<float   >;
+    using I32 = V< int32_t>;
+    using U64 = V<uint64_t>;
+    using U32 = V<uint32_t>;
+    using U16 = V<uint16_t>;
+    using U8  = V<uint8_t >;
+
+    SI F   mad(F f, F m, F a)   { return _mm512_fmadd_ps(f,m,a); }
+    SI F   min(F a, F b)        { return _mm512_min_ps(a,b);     }
+    SI F   max(F a, F b)        { return _mm512_max_ps(a,b);     }
+    SI F   abs_  (F v)          { return _mm512_and_ps(v, 0-v);  }
+    SI F   floor_(F v)          { return _mm512_floor_ps(v);     }
+    SI F   rcp   (F v)          { return _mm512_rcp14_ps  (v);   }
+    SI F   rsqrt (F v)          { return _mm512_rsqrt14_ps(v);   }
+    SI F    sqrt_(F v)          { return _mm512_sqrt_ps (v);     }
+    SI U32 round (F v, F scale) { return _mm512_cvtps_epi32(v*scale); }
+
+    // Both saturate like the signed-input _mm_packus_epi32() and _mm_packus_epi16() do.
+    SI U16 pack(U32 v) {
+        return _mm512_cvtusepi32_epi16(_mm512_max_epi32(v, _mm512_setzero_si512()));
+    }
+    SI U8 pack(U16 v) {
+        return _mm256_cvtusepi16_epi8(_mm256_max_epi16(v, _mm256_setzero_si256()));
+    }
+
+    SI F if_then_else(I32 c, F t, F e) {
+        return _mm512_mask_blend_ps(_mm512_movepi32_mask(c), e,t);
+    }
+
+    template <typename T>
+    SI V<T> gather(const T* p, U32 ix) {
+        return { p[ix[ 0]], p[ix[ 1]], p[ix[ 2]], p[ix[ 3]],
+                 p[ix[ 4]], p[ix[ 5]], p[ix[ 6]], p[ix[ 7]],
+                 p[ix[ 8]], p[ix[ 9]], p[ix[10]], p[ix[11]],
+                 p[ix[12]], p[ix[13]], p[ix[14]], p[ix[15]], };
+    }
+    SI F   gather(const float*    p, U32 ix) { return _mm512_i32gather_ps   (ix, p, 4); }
+    SI U32 gather(const uint32_t* p, U32 ix) { return _mm512_i32gather_epi32(ix, p, 4); }
+    SI U64 gather(const uint64_t* p, U32 ix) {
+        __m512i parts[] = {
+            _mm512_i32gather_epi64(_mm512_castsi512_si256   (ix   ), p, 8),
+            _mm512_i32gather_epi64(_mm512_extracti64x4_epi64(ix, 1), p, 8),
+        };
+        return bit_cast<U64>(parts);
+    }
+
+    // The first n lanes, n clamped to [0,32].  The loads and stores below use these to stop at
+    // the tail; masked off lanes are neither read nor written, and load as zero.
+    SI __mmask32 first_lanes(int n) {
+        return n <= 0 ? 0 : n >= 32 ? 0xffffffff : (1u << n) - 1;
+    }
+
+    SI void load3(const uint16_t* ptr, size_t tail, U16* r, U16* g, U16* b) {
+        int n = 3 * (tail ? (int)tail : 16);
+        __m512i _0 = _mm512_maskz_loadu_epi16(first_lanes(n -  0), ptr +  0),  // r0 g0 b0 ... g10
+                _1 = _mm512_maskz_loadu_epi16(first_lanes(n - 32), ptr + 32);  // b10 ... b15 xx
+
+        // Each channel is one permute of the 48 values, picking every third one.
+        static const uint16_t every_third[32] = {
+            0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45,
+        };
+        __m512i ix = _mm512_loadu_si512(every_third);
+        *r = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+        ix = _mm512_add_epi16(ix, _mm512_set1_epi16(1));
+        *g = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+        ix = _mm512_add_epi16(ix, _mm512_set1_epi16(1));
+        *b = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+    }
+    SI void load4(const uint16_t* ptr, size_t tail, U16* r, U16* g, U16* b, U16* a) {
+        int n = 4 * (tail ? (int)tail : 16);
+        __m512i _0 = _mm512_maskz_loadu_epi16(first_lanes(n -  0), ptr +  0),  // pixels 0-7
+                _1 = _mm512_maskz_loadu_epi16(first_lanes(n - 32), ptr + 32);  // pixels 8-15
+
+        static const uint16_t every_fourth[32] = {
+            0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60,
+        };
+        __m512i ix = _mm512_loadu_si512(every_fourth);
+        *r = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+        ix = _mm512_add_epi16(ix, _mm512_set1_epi16(1));
+        *g = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+        ix = _mm512_add_epi16(ix, _mm512_set1_epi16(1));
+        *b = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+        ix = _mm512_add_epi16(ix, _mm512_set1_epi16(1));
+        *a = _mm512_castsi512_si256(_mm512_permutex2var_epi16(_0, ix, _1));
+    }
+    SI void store4(uint16_t* ptr, size_t tail, U16 r, U16 g, U16 b, U16 a) {
+        __m512i rg = _mm512_inserti64x4(_mm512_castsi256_si512(r), g, 1),  // r0 ... r15 g0 ... g15
+                ba = _mm512_inserti64x4(_mm512_castsi256_si512(b), a, 1);  // b0 ... b15 a0 ... a15
+
+        static const uint16_t interleave[32] = {
+            0, 16, 32, 48,  1, 17, 33, 49,  2, 18, 34, 50,  3, 19, 35, 51,
+            4, 20, 36, 52,  5, 21, 37, 53,  6, 22, 38, 54,  7, 23, 39, 55,
+        };
+        __m512i ix = _mm512_loadu_si512(interleave);
+        __m512i _0 = _mm512_permutex2var_epi16(rg, ix, ba),
+                _1 = _mm512_permutex2var_epi16(rg, _mm512_add_epi16(ix, _mm512_set1_epi16(8)), ba);
+
+        int n = 4 * (tail ? (int)tail : 16);
+        _mm512_mask_storeu_epi16(ptr +  0, first_lanes(n -  0), _0);
+        _mm512_mask_storeu_epi16(ptr + 32, first_lanes(n - 32), _1);
+    }
+
+    SI void load4(const float* ptr, size_t tail, F* r, F* g, F* b, F* a) {
+        int n = 4 * (tail ? (int)tail : 16);
+        F _0 = _mm512_maskz_loadu_ps((__mmask16)first_lanes(n -  0), ptr +  0),  // pixels 0-3
+          _1 = _mm512_maskz_loadu_ps((__mmask16)first_lanes(n - 16), ptr + 16),  // pixels 4-7
+          _2 = _mm512_maskz_loadu_ps((__mmask16)first_lanes(n - 32), ptr + 32),  // pixels 8-11
+          _3 = _mm512_maskz_loadu_ps((__mmask16)first_lanes(n - 48), ptr + 48);  // pixels 12-15
+
+        // Pick each channel's pixels 0-7 out of _0,_1 and pixels 8-15 out of _2,_3.
+        static const int32_t every_fourth[16] = {
+            0, 4, 8, 12, 16, 20, 24, 28,  0, 4, 8, 12, 16, 20, 24, 28,
+        };
+        __m512i ix = _mm512_loadu_si512(every_fourth);
+        auto channel = [&] {
+            F v = _mm512_mask_blend_ps(0xff00, _mm512_permutex2var_ps(_0, ix, _1),
+                                               _mm512_permutex2var_ps(_2, ix, _3));
+            ix = _mm512_add_epi32(ix, _mm512_set1_epi32(1));
+            return v;
+        };
+        *r = channel();
+        *g = channel();
+        *b = channel();
+        *a = channel();
+    }
+    SI void store4(float* ptr, size_t tail, F r, F g, F b, F a) {
+        static const int32_t zip[16] = {
+            0, 16,  1, 17,  2, 18,  3, 19,  4, 20,  5, 21,  6, 22,  7, 23,
+        };
+        static const int32_t zip2[16] = {
+            0,  1, 16, 17,  2,  3, 18, 19,  4,  5, 20, 21,  6,  7, 22, 23,
+        };
+        __m512i ix    = _mm512_loadu_si512(zip ),
+                ix2   = _mm512_loadu_si512(zip2),
+                eight = _mm512_set1_epi32(8);
+
+        F rg0_7  = _mm512_permutex2var_ps(r, ix, g),                          // r0 g0 ... r7 g7
+          rg8_15 = _mm512_permutex2var_ps(r, _mm512_add_epi32(ix, eight), g),
+          ba0_7  = _mm512_permutex2var_ps(b, ix, a),
+          ba8_15 = _mm512_permutex2var_ps(b, _mm512_add_epi32(ix, eight), a);
+
+        F _0 = _mm512_permutex2var_ps(rg0_7 , ix2, ba0_7 ),                    // r0 g0 b0 a0 ...
+          _1 = _mm512_permutex2var_ps(rg0_7 , _mm512_add_epi32(ix2, eight), ba0_7 ),
+          _2 = _mm512_permutex2var_ps(rg8_15, ix2, ba8_15),
+          _3 = _mm512_permutex2var_ps(rg8_15, _mm512_add_epi32(ix2, eight), ba8_15);
+
+        int n = 4 * (tail ? (int)tail : 16);
+        _mm512_mask_storeu_ps(ptr +  0, (__mmask16)first_lanes(n -  0), _0);
+        _mm512_mask_storeu_ps(ptr + 16, (__mmask16)first_lanes(n - 16), _1);
+        _mm512_mask_storeu_ps(ptr + 32, (__mmask16)first_lanes(n - 32), _2);
+        _mm512_mask_storeu_ps(ptr + 48, (__mmask16)first_lanes(n - 48), _3);
+    }
+
+#elif defined(JUMPER_IS_AVX) || defined(JUMPER_IS_HSW)
     // These are __m256 and __m256i, but friendlier and strongly-typed.
     template <typename T> using V = T __attribute__((ext_vector_type(8)));
     using F   = V<float   >;
@@ -232,7 +389,7 @@ namespace SK_OPTS_NS {
     using U8  = V<uint8_t >;
 
     SI F mad(F f, F m, F a)  {
-    #if defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+    #if defined(JUMPER_IS_HSW)
         return _mm256_fmadd_ps(f,m,a);
     #else
         return f*m+a;
@@ -264,7 +421,7 @@ namespace SK_OPTS_NS {
         return { p[ix[0]], p[ix[1]], p[ix[2]], p[ix[3]],
                  p[ix[4]], p[ix[5]], p[ix[6]], p[ix[7]], };
     }
-    #if defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+    #if defined(JUMPER_IS_HSW)
         SI F   gather(const float*    p, U32 ix) { return _mm256_i32gather_ps   (p, ix, 4); }
         SI U32 gather(const uint32_t* p, U32 ix) { return _mm256_i32gather_epi32(p, ix, 4); }
         SI U64 gather(const uint64_t* p, U32 ix) {
@@ -660,7 +817,10 @@ SI F from_half(U16 h) {
 #if defined(__aarch64__) && !defined(SK_BUILD_FOR_GOOGLE3)  // Temporary workaround for some Google3 builds.
     return vcvt_f32_f16(h);
 
-#elif defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+#elif defined(JUMPER_IS_SKX)
+    return _mm512_cvtph_ps(h);
+
+#elif defined(JUMPER_IS_HSW)
     return _mm256_cvtph_ps(h);
 
 #else
@@ -680,7 +840,10 @@ SI U16 to_half(F f) {
 #if defined(__aarch64__) && !defined(SK_BUILD_FOR_GOOGLE3)  // Temporary workaround for some Google3 builds.
     return vcvt_f16_f32(f);
 
-#elif defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+#elif defined(JUMPER_IS_SKX)
+    return _mm512_cvtps_ph(f, _MM_FROUND_CUR_DIRECTION);
+
+#elif defined(JUMPER_IS_HSW)
     return _mm256_cvtps_ph(f, _MM_FROUND_CUR_DIRECTION);
 
 #else
@@ -820,6 +983,16 @@ SI V load(const T* src, size_t tail) {
     if (__builtin_expect(tail, 0)) {
         V v{};  // Any inactive lanes are zeroed.
         switch (tail) {
+        #if defined(JUMPER_IS_SKX)
+            case 15: v[14] = src[14];
+            case 14: v[13] = src[13];
+            case 13: v[12] = src[12];
+            case 12: memcpy(&v, src, 12*sizeof(T)); break;
+            case 11: v[10] = src[10];
+            case 10: v[ 9] = src[ 9];
+            case  9: v[ 8] = src[ 8];
+            case  8: memcpy(&v, src,  8*sizeof(T)); break;
+        #endif
             case 7: v[6] = src[6];
             case 6: v[5] = src[5];
             case 5: v[4] = src[4];
@@ -840,6 +1013,16 @@ SI void store(T* dst, V v, size_t tail) {
     __builtin_assume(tail < N);
     if (__builtin_expect(tail, 0)) {
         switch (tail) {
+        #if defined(JUMPER_IS_SKX)
+            case 15: dst[14] = v[14];
+            case 14: dst[13] = v[13];
+            case 13: dst[12] = v[12];
+            case 12: memcpy(dst, &v, 12*sizeof(T)); break;
+            case 11: dst[10] = v[10];
+            case 10: dst[ 9] = v[ 9];
+            case  9: dst[ 8] = v[ 8];
+            case  8: memcpy(dst, &v,  8*sizeof(T)); break;
+        #endif
             case 7: dst[6] = v[6];
             case 6: dst[5] = v[5];
             case 5: dst[4] = v[4];
@@ -939,7 +1122,7 @@ STAGE(seed_shader, Ctx::None) {
 
 STAGE(dither, const float* rate) {
     // Get [(dx,dy), (dx+1,dy), (dx+2,dy), ...] loaded up in integer vectors.
-    uint32_t iota[] = {0,1,2,3,4,5,6,7};
+    uint32_t iota[] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15};
     U32 X = dx + unaligned_load<U32>(iota),
         Y = dy;
 
@@ -1327,7 +1510,7 @@ STAGE(from_srgb, Ctx::None) {
 STAGE(to_srgb, Ctx::None) {
     auto fn = [](F l) {
         // We tweak c and d for each instruction set to make sure fn(1) is exactly 1.
-    #if defined(JUMPER_IS_AVX512)
+    #if defined(JUMPER_IS_SKX)
         const float c = 1.130026340485f,
                     d = 0.141387879848f;
     #elif defined(JUMPER_IS_SSE2) || defined(JUMPER_IS_SSE41) || \
@@ -1842,7 +2025,18 @@ STAGE(matrix_perspective, const float* m) {
 SI void gradient_lookup(const SkJumper_GradientCtx* c, U32 idx, F t,
                         F* r, F* g, F* b, F* a) {
     F fr, br, fg, bg, fb, bb, fa, ba;
-#if defined(JUMPER_IS_HSW) || defined(JUMPER_IS_AVX512)
+#if defined(JUMPER_IS_SKX)
+    if (c->stopCount <= 16) {
+        fr = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->fs[0]));
+        br = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->bs[0]));
+        fg = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->fs[1]));
+        bg = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->bs[1]));
+        fb = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->fs[2]));
+        bb = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->bs[2]));
+        fa = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->fs[3]));
+        ba = _mm512_permutexvar_ps(idx, _mm512_loadu_ps(c->bs[3]));
+    } else
+#elif defined(JUMPER_IS_HSW)
     if (c->stopCount <=8) {
         fr = _mm256_permutevar8x32_ps(_mm256_loadu_ps(c->fs[0]), idx);
         br = _mm256_permutevar8x32_ps(_mm256_loadu_ps(c->bs[0]), idx);
@@ -2165,6 +2359,36 @@ STAGE(bilerp_clamp_8888, const SkJumper_GatherCtx* ctx) {
     }
 }
 
+// ~~~~~~ Fused stages ~~~~~~ //
+// SkRasterPipeline::compile() swaps these in for the runs of stages that blend a color onto 8888
+// through a coverage mask or float, which is most anti-aliased fills and text.  Each runs the
+// kernels of the stages it replaces, so draws exactly the same pixels, but without the calls.
+
+#define FUSED_SRCOVER(STAGE_, name, cover, Cover, fmt)                                         \
+    STAGE_(name, const SkJumper_FusedCtx* ctx) {                                               \
+        cover##_k((const Cover*)ctx->coverage,       dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+        load_##fmt##_dst_k(ctx->dst,                 dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+        srcover_k(Ctx::None{},                       dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+        store_##fmt##_k(ctx->dst,                    dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+    }
+#define FUSED_SRC(STAGE_, name, cover, Cover, fmt)                                             \
+    STAGE_(name, const SkJumper_FusedCtx* ctx) {                                               \
+        load_##fmt##_dst_k(ctx->dst,                 dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+        cover##_k((const Cover*)ctx->coverage,       dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+        store_##fmt##_k(ctx->dst,                    dx,dy,tail, r,g,b,a, dr,dg,db,da);        \
+    }
+#define FUSED_STAGES(STAGE_)                                                                   \
+    FUSED_SRCOVER(STAGE_, srcover_u8_8888     , scale_u8     , SkJumper_MemoryCtx, 8888)       \
+    FUSED_SRCOVER(STAGE_, srcover_u8_bgra     , scale_u8     , SkJumper_MemoryCtx, bgra)       \
+    FUSED_SRCOVER(STAGE_, srcover_1_float_8888, scale_1_float, float             , 8888)       \
+    FUSED_SRCOVER(STAGE_, srcover_1_float_bgra, scale_1_float, float             , bgra)       \
+    FUSED_SRC    (STAGE_, src_u8_8888         , lerp_u8      , SkJumper_MemoryCtx, 8888)       \
+    FUSED_SRC    (STAGE_, src_u8_bgra         , lerp_u8      , SkJumper_MemoryCtx, bgra)       \
+    FUSED_SRC    (STAGE_, src_1_float_8888    , lerp_1_float , float             , 8888)       \
+    FUSED_SRC    (STAGE_, src_1_float_bgra    , lerp_1_float , float             , bgra)
+
+FUSED_STAGES(STAGE)
+
 namespace lowp {
 #if defined(JUMPER_IS_SCALAR)
     // If we're not compiled by Clang, or otherwise switched into scalar mode (old Clang, manually),
@@ -3188,6 +3412,10 @@ STAGE_PP(srcover_bgra_8888, const SkJumper_MemoryCtx* ctx) {
     store_8888_(ptr, tail, b,g,r,a);
 }
 
+// ~~~~~~ Fused stages ~~~~~~ //
+
+FUSED_STAGES(STAGE_PP)
+
 // Now we'll add null stand-ins for stages we haven't implemented in lowp.
 // If a pipeline uses these stages, it'll boot it out of lowp into highp.
 
@@ -3232,6 +3460,10 @@ static NotImplemented
 #endif//defined(JUMPER_IS_SCALAR) controlling whether we build lowp stages
 }  // namespace lowp
 
+#undef FUSED_STAGES
+#undef FUSED_SRC
+#undef FUSED_SRCOVER
+
 }  // namespace SK_OPTS_NS
 
 #endif//SkRasterPipeline_opts_DEFINED
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SkBlurMask.h"
+#include "SkExecutor.h"
+#include "SkMask.h"
+
+// Blurs A8 and ARGB masks through SkBlurMask::BoxBlur on the calling thread
+// and on an executor, and requires byte-identical results. Sizes sit on
+// either side of the mask size SkMaskBlurFilter starts handing out bands at,
+// for sigmas from 2 to 50; a counting executor checks that bands were
+// handed out above it and not below.
+
+static const int kMinParallelPixels = 256 * 256;  // SkMaskBlurFilter.cpp
+
+// Counts the work SkTaskGroup hands to a thread pool
+class CountingExecutor : public SkExecutor
+{
+public:
+	CountingExecutor() : fPool(SkExecutor::MakeFIFOThreadPool(4)), fTasks(0) {}
+
+	void add(std::function<void(void)> work) override
+	{
+		fTasks++;
+		fPool->add(std::move(work));
+	}
+
+	void addTask(void (*fn)(void *), void *ctx) override
+	{
+		fTasks++;
+		fPool->addTask(fn, ctx);
+	}
+
+	void borrow() override { fPool->borrow(); }
+
+	int TakeCount() { return fTasks.exchange(0); }
+
+private:
+	std::unique_ptr<SkExecutor> fPool;
+	std::atomic<int> fTasks;
+};
+
+// The blur's border at |sigma|, from a bounds-only BoxBlur
+static int Border(float sigma)
+{
+	SkMask src, dst;
+	src.fImage = nullptr;
+	src.fBounds = SkIRect::MakeWH(1, 1);
+	src.fRowBytes = 1;
+	src.fFormat = SkMask::kA8_Format;
+	SkIPoint margin = { 0, 0 };
+	if (!SkBlurMask::BoxBlur(&dst, src, sigma, kNormal_SkBlurStyle, &margin))
+		return -1;
+	return margin.fX;
+}
+
+static bool Blur(const SkMask &src, float sigma, SkExecutor *executor, std::vector<uint8_t> *out,
+	SkIRect *bounds)
+{
+	SkMask dst;
+	if (!SkBlurMask::BoxBlur(&dst, src, sigma, kNormal_SkBlurStyle, nullptr, executor))
+		return false;
+	SkAutoMaskFreeImage autoFree(dst.fImage);
+	*bounds = dst.fBounds;
+	out->assign(dst.fImage, dst.fImage + dst.computeImageSize());
+	return true;
+}
+
+int main()
+{
+	CountingExecutor executor;
+	std::mt19937 random(7);
+	const float kSigmas[] = { 2.0f, 3.5f, 6.0f, 11.0f, 20.0f, 33.3f, 50.0f };
+	const SkMask::Format kFormats[] = { SkMask::kA8_Format, SkMask::kARGB32_Format };
+	int cases = 0;
+	bool ok = true;
+
+	for (float sigma : kSigmas)
+	{
+		int border = Border(sigma);
+		// Destination one row short of the threshold, exactly on it, and past it
+		const struct { int dstW, dstH; } kSizes[] = { { 256, 255 }, { 256, 256 }, { 300, 400 } };
+		for (const auto &size : kSizes)
+		{
+			int srcW = size.dstW - 2 * border;
+			int srcH = size.dstH - 2 * border;
+			if (srcW < 1 || srcH < 1)
+				continue;  // the border alone is past the threshold
+			bool parallel = (int64_t)size.dstW * size.dstH >= kMinParallelPixels;
+
+			for (SkMask::Format format : kFormats)
+			{
+				int bytesPerPixel = format == SkMask::kA8_Format ? 1 : 4;
+				std::vector<uint8_t> pixels((size_t)srcW * srcH * bytesPerPixel);
+				for (uint8_t &p : pixels)
+					p = random() % 3 ? 0 : (uint8_t)random();
+				SkMask src;
+				src.fImage = pixels.data();
+				src.fBounds = SkIRect::MakeXYWH(3, -5, srcW, srcH);
+				src.fRowBytes = srcW * bytesPerPixel;
+				src.fFormat = format;
+
+				std::vector<uint8_t> serial, banded;
+				SkIRect serialBounds, bandedBounds;
+				executor.TakeCount();
+				bool blurred = Blur(src, sigma, nullptr, &serial, &serialBounds) &&
+					Blur(src, sigma, &executor, &banded, &bandedBounds);
+				int tasks = executor.TakeCount();
+				cases++;
+
+				const char *name = format == SkMask::kA8_Format ? "A8" : "ARGB";
+				if (!blurred || serialBounds != bandedBounds || serial != banded)
+				{
+					printf("%s %dx%d sigma %g: the banded blur differs\n", name, srcW, srcH, sigma);
+					ok = false;
+				}
+				if (serialBounds.width() != size.dstW || serialBounds.height() != size.dstH)
+				{
+					printf("%s %dx%d sigma %g: blurred to %dx%d, expected %dx%d\n", name, srcW, srcH,
+						sigma, serialBounds.width(), serialBounds.height(), size.dstW, size.dstH);
+					ok = false;
+				}
+				if (parallel ? tasks == 0 : tasks != 0)
+				{
+					printf("%s %dx%d sigma %g: %d tasks on the executor, expected %s\n", name,
+						srcW, srcH, sigma, tasks, parallel ? "some" : "none");
+					ok = false;
+				}
+			}
+		}
+	}
+
+	printf("%d cases %s\n", cases, ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "SkCanvas.h"
+#include "SkCornerPathEffect.h"
+#include "SkGraphics.h"
+#include "SkMaskFilter.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkResourceCache.h"
+#include "SkSurface.h"
+
+// Checks the blurred path masks SkBlurMF keeps in SkResourceCache: a redraw
+// at an integer offset reuses the cached entry, the cached pixels match the
+// uncached path, editing the path purges its entries, and paths the cache
+// does not take still draw the old way.
+//
+// The entries are seen through SkResourceCache::VisitAll. A miss on a key
+// already in the cache replaces its Rec, so an unchanged Rec is a hit. Key
+// hashes tell entries for different paths apart, since a purged Rec's
+// address may be reused by the next one.
+
+static const int kWidth = 640;
+static const int kHeight = 480;
+
+struct Entry
+{
+	const void *rec;
+	uint32_t hash;
+
+	bool operator==(const Entry &other) const { return rec == other.rec && hash == other.hash; }
+};
+
+static void CollectPathBlurRec(const SkResourceCache::Rec &rec, void *context)
+{
+	if (!strcmp(rec.getCategory(), "path-blur"))
+		static_cast<std::vector<Entry> *>(context)->push_back({ &rec, rec.getHash() });
+}
+
+static std::vector<Entry> PathBlurRecs()
+{
+	std::vector<Entry> recs;
+	SkResourceCache::VisitAll(CollectPathBlurRec, &recs);
+	return recs;
+}
+
+static SkPath MakeStar(SkScalar cx, SkScalar cy, SkScalar outer, SkScalar inner)
+{
+	SkPath star;
+	for (int i = 0; i < 14; i++)
+	{
+		SkScalar radius = i & 1 ? inner : outer;
+		SkScalar angle = i * 3.14159265f / 7;
+		if (i) star.lineTo(cx + radius * sinf(angle), cy - radius * cosf(angle));
+		else star.moveTo(cx + radius * sinf(angle), cy - radius * cosf(angle));
+	}
+	star.close();
+	return star;
+}
+
+static SkPaint MakeBlurPaint()
+{
+	SkPaint paint;
+	paint.setAntiAlias(true);
+	paint.setColor(SK_ColorBLACK);
+	paint.setStyle(SkPaint::kStrokeAndFill_Style);
+	paint.setStrokeWidth(6);
+	paint.setStrokeJoin(SkPaint::kRound_Join);
+	paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, 4.0f));
+	return paint;
+}
+
+static void Draw(SkSurface *surface, const SkPath &path, const SkPaint &paint,
+	SkScalar dx, SkScalar dy, const SkRect *clip = nullptr)
+{
+	SkCanvas *canvas = surface->getCanvas();
+	canvas->clear(SK_ColorWHITE);
+	canvas->save();
+	if (clip)
+		canvas->clipRect(*clip);
+	canvas->translate(dx, dy);
+	canvas->drawPath(path, paint);
+	canvas->restore();
+}
+
+// Largest channel difference between the two surfaces
+static int MaxDiff(SkSurface *a, SkSurface *b)
+{
+	SkPixmap pa, pb;
+	if (!a->peekPixels(&pa) || !b->peekPixels(&pb))
+		return 256;
+	int diff = 0;
+	for (int y = 0; y < kHeight; y++)
+	{
+		const uint8_t *ra = static_cast<const uint8_t *>(pa.addr(0, y));
+		const uint8_t *rb = static_cast<const uint8_t *>(pb.addr(0, y));
+		for (int x = 0; x < kWidth * 4; x++)
+			diff = SkTMax(diff, abs(ra[x] - rb[x]));
+	}
+	return diff;
+}
+
+static bool IsBlank(SkSurface *surface)
+{
+	SkPixmap pixmap;
+	surface->peekPixels(&pixmap);
+	for (int y = 0; y < kHeight; y++)
+		for (int x = 0; x < kWidth; x++)
+			if (*pixmap.addr32(x, y) != 0xFFFFFFFF)
+				return false;
+	return true;
+}
+
+int main()
+{
+	SkGraphics::Init();
+	SkImageInfo info = SkImageInfo::MakeN32Premul(kWidth, kHeight);
+	sk_sp<SkSurface> cached = SkSurface::MakeRaster(info);
+	sk_sp<SkSurface> uncached = SkSurface::MakeRaster(info);
+	bool ok = true;
+
+	SkPath path = MakeStar(0, 0, 90, 40);
+	SkPath volatilePath = path;
+	volatilePath.setIsVolatile(true);
+	SkPaint paint = MakeBlurPaint();
+
+	// One entry for the first draw; a draw at another integer offset finds it
+	SkResourceCache::PurgeAll();
+	Draw(cached.get(), path, paint, 150.25f, 140.5f);
+	std::vector<Entry> first = PathBlurRecs();
+	Draw(cached.get(), path, paint, 410.25f, 300.5f);
+	std::vector<Entry> second = PathBlurRecs();
+	if (first.size() != 1 || second != first)
+	{
+		printf("integer offset: %zu entries after the first draw, %zu after the second, %s\n",
+			first.size(), second.size(), second == first ? "same" : "replaced");
+		ok = false;
+	}
+
+	// The fractional part of the offset is part of the key
+	Draw(cached.get(), path, paint, 150.75f, 140.5f);
+	if (PathBlurRecs().size() != 2)
+	{
+		printf("fractional offset: %zu entries, expected 2\n", PathBlurRecs().size());
+		ok = false;
+	}
+
+	// Cached masks match the uncached path within one level, up to three
+	// along a clip edge, where the uncached path crops its source
+	const struct { SkScalar dx, dy; bool clipped; int tolerance; } kCompares[] = {
+		{ 150.25f, 140.5f, false, 1 },
+		{ 410.25f, 300.5f, false, 1 },
+		{ 300.0f, 200.0f, false, 1 },
+		{ 300.0f, 200.0f, true, 3 },
+	};
+	const SkRect clip = SkRect::MakeLTRB(0, 0, 320, 230);
+	for (const auto &compare : kCompares)
+	{
+		const SkRect *clipPtr = compare.clipped ? &clip : nullptr;
+		Draw(cached.get(), path, paint, compare.dx, compare.dy, clipPtr);
+		Draw(uncached.get(), volatilePath, paint, compare.dx, compare.dy, clipPtr);
+		int diff = MaxDiff(cached.get(), uncached.get());
+		if (diff > compare.tolerance || IsBlank(cached.get()))
+		{
+			printf("at (%g, %g)%s: differs from the uncached path by %d, tolerance %d\n",
+				compare.dx, compare.dy, compare.clipped ? " clipped" : "", diff, compare.tolerance);
+			ok = false;
+		}
+	}
+
+	// Editing the path fires its GenIDChangeListener; the purge is applied
+	// by the next cache lookup, the draw of the edited path. The path ref
+	// must not be shared, or the edit copies it and the old one lives on.
+	SkResourceCache::PurgeAll();
+	SkPath edited = MakeStar(0, 0, 90, 40);
+	Draw(cached.get(), edited, paint, 150, 140);
+	std::vector<Entry> beforeEdit = PathBlurRecs();
+	edited.lineTo(0, 0);
+	Draw(cached.get(), edited, paint, 150, 140);
+	std::vector<Entry> afterEdit = PathBlurRecs();
+	if (beforeEdit.size() != 1 || afterEdit.size() != 1 || afterEdit[0].hash == beforeEdit[0].hash)
+	{
+		printf("edit: %zu entries before, %zu after\n", beforeEdit.size(), afterEdit.size());
+		ok = false;
+	}
+
+	// Paths the cache does not take: over 1024x1024, volatile, or with a
+	// path effect. They still draw, the old way.
+	SkPath large = MakeStar(0, 0, 800, 500);
+	SkPaint effectPaint = MakeBlurPaint();
+	effectPaint.setPathEffect(SkCornerPathEffect::Make(10));
+	const struct { const char *name; const SkPath *path; const SkPaint *paint; } kUncached[] = {
+		{ "large", &large, &paint },
+		{ "volatile", &volatilePath, &paint },
+		{ "path effect", &path, &effectPaint },
+	};
+	for (const auto &uncachedCase : kUncached)
+	{
+		SkResourceCache::PurgeAll();
+		Draw(cached.get(), *uncachedCase.path, *uncachedCase.paint, 320, 240);
+		if (!PathBlurRecs().empty() || IsBlank(cached.get()))
+		{
+			printf("%s: %zu entries cached, %s\n", uncachedCase.name, PathBlurRecs().size(),
+				IsBlank(cached.get()) ? "nothing drawn" : "drawn");
+			ok = false;
+		}
+	}
+
+	printf("%s\n", ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "SkCpu.h"
+
+// Runs box_blur_a8_transposed from every SkOpts tier the CPU has (4 lanes on
+// portable and sse41, 8 on hsw) over random masks at sigma 1 to 50, and
+// requires each to be byte-identical to the scalar PlanGauss::Scan, guard
+// bytes included. Then times one pass of a square mask per tier, at sigmas
+// from 1 to 50 and sizes up to --max-size:
+//
+//	box_blur_fuzz [--iterations N] [--seed N] [--max-size N] [--reps N]
+
+typedef void BoxBlurA8(uint32_t weight, int window0, int window1, int window2,
+	int noChangeCount, const uint8_t *src, size_t srcRB, int srcW, int rows,
+	uint8_t *dst, size_t dstRB, int dstW);
+
+// box_blur_tier.cpp
+BoxBlurA8 box_blur_a8_transposed_portable;
+BoxBlurA8 box_blur_a8_transposed_sse41;
+BoxBlurA8 box_blur_a8_transposed_hsw;
+
+static const uint8_t kGuard = 0xA5;
+
+// PlanGauss from SkMaskBlurFilter.cpp: three box passes approximating sigma
+struct Plan
+{
+	explicit Plan(double sigma)
+	{
+		int window = std::max(1, (int)floor(sigma * 3 * sqrt(2 * M_PI) / 4 + 0.5));
+		pass0 = window - 1;
+		pass1 = window - 1;
+		pass2 = (window & 1) == 1 ? window - 1 : window;
+		border = (window & 1) == 1 ? 3 * ((window - 1) / 2) : 3 * (window / 2) - 1;
+		slidingWindow = 2 * border + 1;
+		uint64_t window2 = (uint64_t)window * window, window3 = window2 * window;
+		uint64_t divisor = (window & 1) == 1 ? window3 : window3 + window2;
+		weight = (uint64_t)round(1.0 / divisor * (1ull << 32));
+	}
+
+	// What SkMaskBlurFilter checks before using the kernels
+	bool Vectorized() const { return weight <= UINT32_MAX && pass0 > 0 && pass1 > 0 && pass2 > 0; }
+
+	int NoChangeCount(int srcW) const { return slidingWindow > srcW ? slidingWindow - srcW : 0; }
+
+	uint64_t weight;
+	int pass0, pass1, pass2, border, slidingWindow;
+};
+
+// PlanGauss::Scan over each row in turn, writing dst[x * dstRB + row]
+static void ScalarBlur(const Plan &plan, const uint8_t *src, size_t srcRB, int srcW, int rows,
+	uint8_t *dst, size_t dstRB, int dstW)
+{
+	std::vector<uint32_t> rings[3] = {
+		std::vector<uint32_t>(plan.pass0), std::vector<uint32_t>(plan.pass1), std::vector<uint32_t>(plan.pass2) };
+	int noChangeCount = plan.NoChangeCount(srcW);
+	for (int row = 0; row < rows; row++)
+	{
+		const uint8_t *from = src + row * srcRB;
+		uint8_t *to = dst + row;
+		uint32_t sum0, sum1, sum2;
+		size_t cursor[3];
+		auto reset = [&] {
+			for (int i = 0; i < 3; i++)
+			{
+				std::fill(rings[i].begin(), rings[i].end(), 0);
+				cursor[i] = 0;
+			}
+			sum0 = sum1 = sum2 = 0;
+		};
+		auto exchange = [&](int i, uint32_t v) {
+			uint32_t old = rings[i][cursor[i]];
+			rings[i][cursor[i]] = v;
+			cursor[i] = cursor[i] + 1 < rings[i].size() ? cursor[i] + 1 : 0;
+			return old;
+		};
+		auto step = [&](uint32_t leadingEdge) {
+			sum0 += leadingEdge;
+			sum1 += sum0;
+			sum2 += sum1;
+			uint8_t result = (uint8_t)((plan.weight * sum2 + (1ull << 31)) >> 32);
+			sum2 -= exchange(2, sum1);
+			sum1 -= exchange(1, sum0);
+			sum0 -= exchange(0, leadingEdge);
+			return result;
+		};
+
+		reset();
+		int x = 0;
+		for (; x < srcW; x++)
+			to[x * dstRB] = step(from[x]);
+		for (int i = 0; i < noChangeCount; i++, x++)
+			to[x * dstRB] = step(0);
+		reset();
+		for (int end = dstW, at = srcW; end > x; )
+			to[--end * dstRB] = step(from[--at]);
+	}
+}
+
+struct Tier
+{
+	const char *name;
+	BoxBlurA8 *run;
+};
+
+static void Blur(const Tier &tier, const Plan &plan, const uint8_t *src, size_t srcRB, int srcW, int rows,
+	uint8_t *dst, size_t dstRB, int dstW)
+{
+	tier.run((uint32_t)plan.weight, plan.pass0, plan.pass1, plan.pass2, plan.NoChangeCount(srcW),
+		src, srcRB, srcW, rows, dst, dstRB, dstW);
+}
+
+static void FillMask(std::mt19937 &random, std::vector<uint8_t> *mask)
+{
+	int mode = random() % 4;
+	for (size_t i = 0; i < mask->size(); i++)
+	{
+		uint8_t &alpha = (*mask)[i];
+		switch (mode)
+		{
+		case 0: alpha = (uint8_t)random(); break;
+		// Solid, for the largest sums
+		case 1: alpha = 0xFF; break;
+		// Sparse, like glyph edges
+		case 2: alpha = random() % 5 == 0 ? (uint8_t)random() : 0; break;
+		default: alpha = (uint8_t)(i * 7); break;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 20000;
+	unsigned seed = 1;
+	int maxSize = 4096;
+	int reps = 3;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--iterations")) iterations = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--seed")) seed = (unsigned)strtoul(argv[i + 1], nullptr, 10);
+		else if (!strcmp(argv[i], "--max-size")) maxSize = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--reps")) reps = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	SkCpu::CacheRuntimeFeatures();
+	std::vector<Tier> tiers = { { "portable", box_blur_a8_transposed_portable } };
+	if (SkCpu::Supports(SkCpu::SSE41))
+		tiers.push_back({ "sse41", box_blur_a8_transposed_sse41 });
+	if (SkCpu::Supports(SkCpu::HSW))
+		tiers.push_back({ "hsw", box_blur_a8_transposed_hsw });
+
+	std::mt19937 random(seed);
+	std::vector<uint8_t> src, expected, actual;
+	long long runs = 0, mismatches = 0;
+	for (int it = 0; it < iterations; it++)
+	{
+		// Whole numbers now and then, the rest anywhere from 1 to 50
+		double sigma = random() % 4 == 0 ? 1 + random() % 50 : 1 + (random() % 49000) / 1000.0;
+		Plan plan(sigma);
+		if (!plan.Vectorized())
+			continue;
+		// Narrow masks run off the edge before the window fills
+		int srcW = random() % 2 ? 1 + random() % 40 : 1 + random() % 400;
+		int rows = 1 + random() % 37;
+		size_t srcRB = srcW + random() % 8;
+		int dstW = srcW + 2 * plan.border;
+		size_t dstRB = rows + random() % 8;
+		src.resize(srcRB * rows);
+		FillMask(random, &src);
+
+		// One row of guard bytes past the last output
+		expected.assign(dstRB * (dstW + 1), kGuard);
+		ScalarBlur(plan, src.data(), srcRB, srcW, rows, expected.data(), dstRB, dstW);
+		for (const Tier &tier : tiers)
+		{
+			actual.assign(expected.size(), kGuard);
+			Blur(tier, plan, src.data(), srcRB, srcW, rows, actual.data(), dstRB, dstW);
+			runs++;
+			if (actual == expected)
+				continue;
+			if (mismatches++ < 10)
+			{
+				size_t at = 0;
+				while (actual[at] == expected[at]) at++;
+				printf("%s: iteration %d, sigma %.3f, %dx%d: output %zu of row %zu is %d, scalar %d\n",
+					tier.name, it, sigma, srcW, rows, at / dstRB, at % dstRB, actual[at], expected[at]);
+			}
+		}
+	}
+	printf("%lld comparisons across %zu tiers, %lld mismatches\n\n", runs, tiers.size(), mismatches);
+
+	// One pass over a square mask, as SkMaskBlurFilter's horizontal pass
+	printf("sigma   size    ns/px:  scalar");
+	for (const Tier &tier : tiers)
+		printf(" %9s", tier.name);
+	printf("\n");
+	for (int size = 64; size <= maxSize; size *= 4)
+	{
+		src.resize((size_t)size * size);
+		FillMask(random, &src);
+		for (double sigma : { 1.0, 2.0, 3.0, 5.0, 10.0, 20.0, 30.0, 50.0 })
+		{
+			Plan plan(sigma);
+			int dstW = size + 2 * plan.border;
+			actual.resize((size_t)dstW * size);
+			auto time = [&](const Tier *tier) {
+				double best = 1e30;
+				for (int rep = 0; rep < reps; rep++)
+				{
+					auto start = std::chrono::steady_clock::now();
+					if (tier)
+						Blur(*tier, plan, src.data(), size, size, size, actual.data(), size, dstW);
+					else
+						ScalarBlur(plan, src.data(), size, size, size, actual.data(), size, dstW);
+					best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+				}
+				return best / ((double)size * size);
+			};
+			printf("%5.0f %6d          %7.3f", sigma, size, time(nullptr));
+			for (const Tier &tier : tiers)
+				printf(" %9.3f", time(&tier));
+			printf("\n");
+		}
+	}
+	return mismatches ? 1 : 0;
+}
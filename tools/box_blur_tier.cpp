@@ -0,0 +1,15 @@
+#include "SkMaskBlurFilter_opts.h"
+
+// Built once per SkOpts tier, with that tier's SK_OPTS_NS and target flags,
+// the way SkOpts.cpp and SkOpts_*.cpp build SkMaskBlurFilter_opts.h.
+
+#define TIER_FUNCTION_(ns) box_blur_a8_transposed_##ns
+#define TIER_FUNCTION(ns) TIER_FUNCTION_(ns)
+
+void TIER_FUNCTION(SK_OPTS_NS)(uint32_t weight, int window0, int window1, int window2,
+	int noChangeCount, const uint8_t *src, size_t srcRB, int srcW, int rows,
+	uint8_t *dst, size_t dstRB, int dstW)
+{
+	SK_OPTS_NS::box_blur_a8_transposed(weight, window0, window1, window2, noChangeCount,
+		src, srcRB, srcW, rows, dst, dstRB, dstW);
+}
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wchar.h>
+#include "CaptionFile.h"
+
+// Times CaptionFile against the loader it replaced in LayeredWnd, which read
+// the whole file with fgetws into a vector<wstring> before showing anything,
+// on the same generated caption file.
+//
+//	caption_file_bench [--lines N] [--reps R]
+//
+// "first line" is how long after opening the first caption can be shown:
+// for the old loader that is after the last line was read, since the menu
+// handler only showed the file once the loop was done.
+
+typedef std::chrono::steady_clock Clock;
+
+static double Millis(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Mixed Hangul, kana and ASCII, 40 to 120 bytes per line
+static bool WriteFile(const char *path, int lines, size_t *bytes)
+{
+	static const char *kWords[] = {
+		"\xEC\x98\xA4\xEB\x8A\x98\xEC\x9D\x80", "\xEC\x9E\x90\xEB\xA7\x89",
+		"\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF", "\xE4\xBB\x8A\xE6\x97\xA5",
+		"Anemone", "overlay", "0123", "(ABC)",
+	};
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	fputs("\xEF\xBB\xBF", file);
+	unsigned seed = 1;
+	for (int i = 0; i < lines; i++)
+	{
+		std::string line = std::to_string(i);
+		int words = 4 + (int)((seed = seed * 1103515245 + 12345) >> 16) % 10;
+		for (int w = 0; w < words; w++)
+		{
+			line += ' ';
+			line += kWords[((seed = seed * 1103515245 + 12345) >> 16) % 8];
+		}
+		line += "\r\n";
+		fputs(line.c_str(), file);
+	}
+	*bytes = (size_t)ftell(file);
+	return fclose(file) == 0;
+}
+
+// The old LayeredWnd loader; _wfopen_s(L"rt,ccs=UTF-8") is fopen in a
+// UTF-8 locale here
+static bool LegacyLoad(const char *path, std::vector<std::wstring> *vecBuff)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp) return false;
+	wchar_t buff[2048];
+	std::wstring str;
+	while (fgetws(buff, 2048, fp))
+	{
+		str = buff;
+		str.erase(0, str.find_first_not_of(' '));
+		str.erase(str.find_last_not_of(' ') + 1);
+		if (!str.length()) continue;
+		vecBuff->push_back(str);
+	}
+	fclose(fp);
+	return true;
+}
+
+static void Trim(std::wstring *line)
+{
+	while (!line->empty() && (line->back() == L'\n' || line->back() == L'\r' || line->back() == L' '))
+		line->pop_back();
+	// fgetws leaves the BOM in
+	if (!line->empty() && line->front() == 0xFEFF)
+		line->erase(0, 1);
+}
+
+static double Median(std::vector<double> times)
+{
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+int main(int argc, char **argv)
+{
+	int lines = 200000;
+	int reps = 5;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--lines")) lines = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--reps")) reps = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (lines < 1 || reps < 1)
+	{
+		fprintf(stderr, "--lines and --reps must be positive\n");
+		return 2;
+	}
+	bool legacy = setlocale(LC_CTYPE, "C.UTF-8") || setlocale(LC_CTYPE, "en_US.UTF-8");
+	if (!legacy)
+		printf("no UTF-8 locale, timing CaptionFile only\n");
+
+	const char *path = "caption_file_bench.txt";
+	const std::wstring widePath = L"caption_file_bench.txt";
+	size_t bytes = 0;
+	if (!WriteFile(path, lines, &bytes))
+	{
+		fprintf(stderr, "cannot write %s\n", path);
+		return 2;
+	}
+
+	bool ok = true;
+	std::vector<double> legacyFull, first, full;
+	std::vector<std::wstring> vecBuff;
+	for (int rep = 0; rep < reps && ok; rep++)
+	{
+		if (legacy)
+		{
+			vecBuff.clear();
+			vecBuff.shrink_to_fit();
+			Clock::time_point start = Clock::now();
+			ok = LegacyLoad(path, &vecBuff);
+			legacyFull.push_back(Millis(start, Clock::now()));
+		}
+
+		CaptionFile captions;
+		std::wstring line;
+		Clock::time_point start = Clock::now();
+		if (!captions.Open(widePath))
+		{
+			printf("cannot open %s\n", path);
+			ok = false;
+			break;
+		}
+		while (!captions.GetLine(0, &line) && !captions.IsIndexed())
+			std::this_thread::yield();
+		first.push_back(Millis(start, Clock::now()));
+		captions.WaitForIndex();
+		full.push_back(Millis(start, Clock::now()));
+
+		if (captions.GetLineCount() != lines)
+		{
+			printf("CaptionFile indexed %d lines, expected %d\n", captions.GetLineCount(), lines);
+			ok = false;
+		}
+		// Both loaders read the same text
+		if (legacy && ok)
+		{
+			if (vecBuff.size() != (size_t)lines)
+			{
+				printf("fgetws read %zu lines, expected %d\n", vecBuff.size(), lines);
+				ok = false;
+			}
+			for (int i = 0; ok && i < lines; i += std::max(1, lines / 1000))
+			{
+				std::wstring expected = vecBuff[i];
+				Trim(&expected);
+				captions.GetLine(i, &line);
+				if (line != expected)
+				{
+					printf("line %d differs between the loaders\n", i);
+					ok = false;
+				}
+			}
+		}
+	}
+	remove(path);
+	if (!ok)
+		return 1;
+
+	printf("%d lines, %.1f MB, median of %d runs\n", lines, bytes / 1e6, reps);
+	if (legacy)
+		printf("fgetws + vector<wstring>: first line %.2f ms, full index %.2f ms (%.0f MB/s)\n",
+			Median(legacyFull), Median(legacyFull), bytes / 1e3 / Median(legacyFull));
+	printf("CaptionFile:              first line %.2f ms, full index %.2f ms (%.0f MB/s)\n",
+		Median(first), Median(full), bytes / 1e3 / Median(full));
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CaptionFile.h"
+
+// Checks how CaptionFile splits and decodes a few hand-made files, then
+// reopens and closes it over and over while reader threads call
+// GetLine/GetLineCount/IsIndexed on it, as the paint, hook and prefetcher
+// threads do, and checks that every line read belongs to one of the files.
+// Before readers pinned the mapping this read unmapped memory.
+//
+//	caption_file_test [--reopens N]
+
+static const int kLines = 100000;
+static const int kReaders = 3;
+
+// "<tag> <index> 자막", with a trailing blank to be trimmed
+static std::string FileLine(char tag, int index)
+{
+	return std::string(1, tag) + " " + std::to_string(index) + " \xEC\x9E\x90\xEB\xA7\x89 \r\n";
+}
+
+static std::wstring ExpectedLine(char tag, int index)
+{
+	std::string digits = std::to_string(index);
+	return std::wstring(1, (wchar_t)tag) + L" " + std::wstring(digits.begin(), digits.end()) + L" 자막";
+}
+
+static bool WriteFile(const char *path, char tag)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	for (int i = 0; i < kLines; i++)
+	{
+		// Blank lines are not indexed
+		if (i % 7 == 0) fputs("  \r\n", file);
+		fputs(FileLine(tag, i).c_str(), file);
+	}
+	return fclose(file) == 0;
+}
+
+struct DecodeCase
+{
+	const char *name;
+	std::string bytes;
+	std::vector<std::wstring> lines;
+};
+
+// Each bad byte of a malformed or truncated sequence is one U+FFFD
+static const DecodeCase kDecodeCases[] = {
+	{ "UTF-8 BOM", "\xEF\xBB\xBF\xEC\x9E\x90\xEB\xA7\x89\nline 2\n", { L"\uC790\uB9C9", L"line 2" } },
+	{ "BOM then blank line", "\xEF\xBB\xBF\r\nfirst\r\n", { L"first" } },
+	{ "CRLF", "one\r\ntwo \r\n\r\n  three\r\n", { L"one", L"two", L"three" } },
+	{ "CR-only blank lines", "one\n\r\n\r\r\n \r \r\ntwo\r", { L"one", L"two" } },
+	{ "no final newline", "one\ntwo", { L"one", L"two" } },
+	{ "stray continuation byte", "a\x80" "b\n", { L"a\uFFFDb" } },
+	{ "invalid lead byte", "\xFF\xFE" "x\n", { L"\uFFFD\uFFFDx" } },
+	{ "truncated mid-line", "\xE3\x81" "a\xF0\x9F\x98" "b\n", { L"\uFFFD\uFFFDa\uFFFD\uFFFD\uFFFDb" } },
+	{ "truncated at end of line", "ok \xEC\x9E\r\nnext\n", { L"ok \uFFFD\uFFFD", L"next" } },
+	{ "truncated at end of file", "last \xF0\x9F", { L"last \uFFFD\uFFFD" } },
+	{ "good sequence after bad", "\xC3\xC3\xA9\n", { L"\uFFFD\u00E9" } },
+	{ "supplementary plane", "\xF0\x9F\x98\x80\n", { std::wstring(sizeof(wchar_t) == 2 ? L"\xD83D\xDE00" : L"\U0001F600") } },
+	{ "blank only", "\xEF\xBB\xBF \r\n\t\n\r", {} },
+};
+
+static bool CheckDecoding(const char *path, const std::wstring &widePath)
+{
+	bool ok = true;
+	CaptionFile captions;
+	for (const DecodeCase &test : kDecodeCases)
+	{
+		FILE *file = fopen(path, "wb");
+		if (!file || fwrite(test.bytes.data(), 1, test.bytes.size(), file) != test.bytes.size() || fclose(file) != 0)
+		{
+			printf("cannot write %s\n", path);
+			return false;
+		}
+		if (!captions.Open(widePath))
+		{
+			printf("%s: cannot open\n", test.name);
+			ok = false;
+			continue;
+		}
+		captions.WaitForIndex();
+
+		std::vector<std::wstring> lines;
+		std::wstring line;
+		for (int i = 0; captions.GetLine(i, &line); i++)
+			lines.push_back(line);
+		if (lines.size() != (size_t)captions.GetLineCount() || lines != test.lines)
+		{
+			printf("%s: read %zu lines, expected %zu\n", test.name, lines.size(), test.lines.size());
+			for (const std::wstring &read : lines)
+			{
+				printf("  ");
+				for (wchar_t c : read)
+					printf(" %04X", (unsigned)c);
+				printf("\n");
+			}
+			ok = false;
+		}
+		captions.Close();
+	}
+	remove(path);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	int reopens = 300;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--reopens")) reopens = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	const char *paths[] = { "caption_file_test_a.txt", "caption_file_test_b.txt" };
+	const std::wstring widePaths[] = { L"caption_file_test_a.txt", L"caption_file_test_b.txt" };
+	if (!CheckDecoding(paths[0], widePaths[0]))
+		return 1;
+
+	if (!WriteFile(paths[0], 'A') || !WriteFile(paths[1], 'B'))
+	{
+		fprintf(stderr, "cannot write the test files\n");
+		return 2;
+	}
+
+	CaptionFile captions;
+	std::atomic<bool> done(false);
+	std::atomic<long long> reads(0), bad(0);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < kReaders; r++)
+	{
+		readers.emplace_back([&, r] {
+			std::mt19937 random(r + 1);
+			std::wstring line;
+			while (!done.load(std::memory_order_relaxed))
+			{
+				int count = captions.GetLineCount();
+				captions.IsIndexed();
+				// Sometimes past the end, which must fail cleanly
+				int index = (int)(random() % (count + 8));
+				if (!captions.GetLine(index, &line))
+					continue;
+				reads++;
+				if (line != ExpectedLine('A', index) && line != ExpectedLine('B', index) && bad++ < 5)
+					printf("line %d read as \"%ls\"\n", index, line.c_str());
+			}
+		});
+	}
+
+	bool ok = true;
+	for (int i = 0; i < reopens && ok; i++)
+	{
+		if (i % 10 == 9)
+			captions.Close();
+		else if (!captions.Open(widePaths[i & 1]))
+		{
+			printf("cannot open %s\n", paths[i & 1]);
+			ok = false;
+		}
+		// Let the readers in while the index is still growing
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+	// The index is complete once WaitForIndex returns
+	if (ok && captions.Open(widePaths[0]))
+	{
+		captions.WaitForIndex();
+		if (!captions.IsIndexed() || captions.GetLineCount() != kLines)
+		{
+			printf("indexed %d lines, expected %d\n", captions.GetLineCount(), kLines);
+			ok = false;
+		}
+	}
+
+	done = true;
+	for (std::thread &reader : readers)
+		reader.join();
+	captions.Close();
+	remove(paths[0]);
+	remove(paths[1]);
+
+	printf("%d reopens, %lld lines read, %lld wrong\n", reopens, (long long)reads, (long long)bad);
+	return ok && !bad ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include "CaptionPrefetcher.h"
+#include "SkGraphics.h"
+
+// Prefetch() runs on the keyboard hook thread and must never wait on the
+// worker. This gives the worker a line source as slow as a cold page of a
+// huge caption file and restyles it now and then, and requires every
+// Prefetch() to return well within one slow fetch; then checks that the
+// lines around the last one did get rendered.
+
+static const std::chrono::milliseconds kFetch(20);
+static const double kMaxPrefetchMs = 5.0;
+
+static std::wstring LineText(int line)
+{
+	return L"자막 line " + std::to_wstring(line);
+}
+
+int main()
+{
+	SkGraphics::Init();
+
+	CaptionPrefetcher prefetcher(2);
+	prefetcher.SetLineSource([](int line, std::wstring *text) {
+		std::this_thread::sleep_for(kFetch);
+		*text = LineText(line);
+		return line < 1000;
+	}, [] { return true; });
+
+	SubtitleStyle style;
+	SkImageInfo info = SkImageInfo::MakeN32Premul(600, 160);
+	prefetcher.Configure(style, info);
+	prefetcher.Start();
+
+	double worst = 0;
+	int line = 0;
+	for (int step = 0; step < 100; step++)
+	{
+		if (step % 25 == 24)
+		{
+			style.fTextSize += 2;
+			prefetcher.Configure(style, info);
+		}
+		line = step / 2;
+		auto start = std::chrono::steady_clock::now();
+		prefetcher.Prefetch(line);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		worst = std::max(worst, ms);
+		std::this_thread::sleep_for(std::chrono::milliseconds(3));
+	}
+
+	// Both neighbours of the last line, fetched and drawn within a second
+	bool rendered = false;
+	for (int wait = 0; wait < 100 && !rendered; wait++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		rendered = prefetcher.Find(LineText(line + 1)) && prefetcher.Find(LineText(line - 1));
+	}
+	prefetcher.Stop();
+
+	printf("slowest Prefetch() %.3f ms, neighbours %s\n", worst, rendered ? "rendered" : "missing");
+	return worst < kMaxPrefetchMs && rendered ? 0 : 1;
+}
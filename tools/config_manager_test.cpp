@@ -0,0 +1,269 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ConfigManager.h"
+
+// Round-trips ConfigManager snapshots through Serialize/Deserialize and
+// Save/Load, feeds it unknown ids, truncated and out-of-range snapshots, and
+// checks which keys its listeners are told about.
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+		{ \
+			printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static void Append(std::vector<uint8_t> *data, uint32_t value)
+{
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+	data->insert(data->end(), bytes, bytes + sizeof(value));
+}
+
+static void AppendFloat(std::vector<uint8_t> *data, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	Append(data, bits);
+}
+
+// Header as Serialize writes it: "ANCF", version 1, record count
+static std::vector<uint8_t> Header(uint32_t count)
+{
+	std::vector<uint8_t> data;
+	Append(&data, 0x46434E41);
+	Append(&data, 1);
+	Append(&data, count);
+	return data;
+}
+
+static void TestRoundTrip()
+{
+	ConfigManager config;
+	config.Set<Config::TextSize>(48.0f);
+	config.Set<Config::FillColor>(0xFF102030u);
+	config.Set<Config::StrikeArchive>(0u);
+	std::vector<uint8_t> data;
+	config.Serialize(&data);
+	CHECK(data.size() == 12 + Config::kCount * 8);
+
+	ConfigManager copy;
+	CHECK(copy.Deserialize(data.data(), data.size()));
+	CHECK(copy.Get<Config::TextSize>() == 48.0f);
+	CHECK(copy.Get<Config::FillColor>() == 0xFF102030u);
+	CHECK(copy.Get<Config::StrikeArchive>() == 0u);
+	CHECK(copy.Get<Config::LineSpacing>() == Config::LineSpacing::Default());
+
+	std::vector<uint8_t> again;
+	copy.Serialize(&again);
+	CHECK(again == data);
+
+	// And through a file
+	const std::wstring path = L"config_manager_test.cfg";
+	CHECK(config.Save(path));
+	ConfigManager loaded;
+	CHECK(loaded.Load(path));
+	again.clear();
+	loaded.Serialize(&again);
+	CHECK(again == data);
+	remove("config_manager_test.cfg");
+	CHECK(!loaded.Load(path));
+}
+
+static void TestUnknownIds()
+{
+	// Ids from a newer build are skipped; keys the snapshot lacks keep
+	// their current value
+	std::vector<uint8_t> data = Header(3);
+	Append(&data, Config::kCount + 5);
+	Append(&data, 0xDEADBEEF);
+	Append(&data, Config::kInnerColor_Id);
+	Append(&data, 0xFF445566u);
+	Append(&data, 0xFFFFFFFFu);
+	Append(&data, 1);
+
+	ConfigManager config;
+	config.Set<Config::Padding>(20.0f);
+	CHECK(config.Deserialize(data.data(), data.size()));
+	CHECK(config.Get<Config::InnerColor>() == 0xFF445566u);
+	CHECK(config.Get<Config::Padding>() == 20.0f);
+	CHECK(config.Get<Config::TextSize>() == Config::TextSize::Default());
+}
+
+static void TestTruncated()
+{
+	ConfigManager reference;
+	std::vector<uint8_t> full;
+	reference.Serialize(&full);
+
+	ConfigManager config;
+	config.Set<Config::TextSize>(40.0f);
+	// Every cut shorter than the header fails; longer ones fail because
+	// the count promises more records than are left
+	for (size_t size = 0; size < full.size(); size++)
+		CHECK(!config.Deserialize(full.data(), size));
+	CHECK(config.Get<Config::TextSize>() == 40.0f);
+
+	std::vector<uint8_t> badMagic = full;
+	badMagic[0] ^= 1;
+	CHECK(!config.Deserialize(badMagic.data(), badMagic.size()));
+	std::vector<uint8_t> badVersion = full;
+	badVersion[4] = 2;
+	CHECK(!config.Deserialize(badVersion.data(), badVersion.size()));
+	std::vector<uint8_t> hugeCount = Header(0xFFFFFFFFu);
+	Append(&hugeCount, Config::kTextSize_Id);
+	AppendFloat(&hugeCount, 20.0f);
+	CHECK(!config.Deserialize(hugeCount.data(), hugeCount.size()));
+	CHECK(config.Get<Config::TextSize>() == 40.0f);
+
+	// An empty snapshot is valid and changes nothing
+	std::vector<uint8_t> empty = Header(0);
+	CHECK(config.Deserialize(empty.data(), empty.size()));
+	CHECK(config.Get<Config::TextSize>() == 40.0f);
+}
+
+static void TestClamping()
+{
+	std::vector<uint8_t> data = Header(5);
+	Append(&data, Config::kTextSize_Id);
+	AppendFloat(&data, NAN);
+	Append(&data, Config::kOuterStroke_Id);
+	AppendFloat(&data, -3.0f);
+	Append(&data, Config::kInnerStroke_Id);
+	AppendFloat(&data, 0.0f);
+	Append(&data, Config::kLineBreak_Id);
+	AppendFloat(&data, INFINITY);
+	Append(&data, Config::kStrikeArchive_Id);
+	Append(&data, 7);
+
+	ConfigManager config;
+	CHECK(config.Deserialize(data.data(), data.size()));
+	CHECK(config.Get<Config::TextSize>() == Config::TextSize::Default());
+	CHECK(config.Get<Config::OuterStroke>() == Config::OuterStroke::Min());
+	CHECK(config.Get<Config::InnerStroke>() == Config::InnerStroke::Min());
+	CHECK(config.Get<Config::LineBreak>() == Config::LineBreak::Max());
+	CHECK(config.Get<Config::StrikeArchive>() == 1u);
+
+	// Set clamps the same way
+	config.Set<Config::TextSize>(-1.0f);
+	CHECK(config.Get<Config::TextSize>() == Config::TextSize::Min());
+	config.Set<Config::TextSize>(NAN);
+	CHECK(config.Get<Config::TextSize>() == Config::TextSize::Default());
+	config.Set<Config::ShadowRadius>(1e9f);
+	CHECK(config.Get<Config::ShadowRadius>() == Config::ShadowRadius::Max());
+}
+
+static std::vector<uint8_t> ReadFile(const char *path)
+{
+	std::vector<uint8_t> data;
+	if (FILE *fp = fopen(path, "rb"))
+	{
+		int c;
+		while ((c = fgetc(fp)) != EOF)
+			data.push_back((uint8_t)c);
+		fclose(fp);
+	}
+	return data;
+}
+
+static void WriteFile(const char *path, const std::vector<uint8_t> &data)
+{
+	if (FILE *fp = fopen(path, "wb"))
+	{
+		fwrite(data.data(), 1, data.size(), fp);
+		fclose(fp);
+	}
+}
+
+static void TestLoadOrCreate()
+{
+	const char *path = "config_manager_test_startup.cfg";
+	const std::wstring widePath = L"config_manager_test_startup.cfg";
+	remove(path);
+
+	// First run: no file, so the defaults are written out
+	ConfigManager config;
+	CHECK(config.LoadOrCreate(widePath));
+	std::vector<uint8_t> defaults;
+	config.Serialize(&defaults);
+	CHECK(ReadFile(path) == defaults);
+
+	// A file from a newer build is neither loaded nor replaced
+	ConfigManager newer;
+	newer.Set<Config::TextSize>(60.0f);
+	std::vector<uint8_t> newerData;
+	newer.Serialize(&newerData);
+	newerData[4] = 2;
+	WriteFile(path, newerData);
+	CHECK(!config.LoadOrCreate(widePath));
+	CHECK(ReadFile(path) == newerData);
+	CHECK(config.Get<Config::TextSize>() == Config::TextSize::Default());
+
+	// Nor is a damaged one
+	std::vector<uint8_t> truncated(newerData.begin(), newerData.begin() + 10);
+	WriteFile(path, truncated);
+	CHECK(!config.LoadOrCreate(widePath));
+	CHECK(ReadFile(path) == truncated);
+
+	// A good file is loaded as it is
+	newer.Save(widePath);
+	std::vector<uint8_t> saved = ReadFile(path);
+	CHECK(config.LoadOrCreate(widePath));
+	CHECK(config.Get<Config::TextSize>() == 60.0f);
+	CHECK(ReadFile(path) == saved);
+	remove(path);
+}
+
+static void TestListeners()
+{
+	ConfigManager config;
+	std::vector<Config::Mask> first, second;
+	int a = config.AddListener([&](Config::Mask changed) { first.push_back(changed); });
+	config.AddListener([&](Config::Mask changed) { second.push_back(changed); });
+
+	config.Set<Config::TextSize>(50.0f);
+	config.Set<Config::TextSize>(50.0f);           // unchanged, no call
+	config.Set<Config::TextSize>(1000.0f);         // clamped to Max
+	config.Set<Config::TextSize>(400.0f);          // clamps to the same Max
+	CHECK(first.size() == 2 && first[0] == Config::MaskOf<Config::TextSize>() &&
+		first[1] == Config::MaskOf<Config::TextSize>());
+
+	// One call per Deserialize, with the bits of the keys that changed
+	ConfigManager other;
+	other.Set<Config::TextSize>(50.0f);
+	other.Set<Config::FillColor>(0xFF000000u);
+	other.Set<Config::ClipDebounce>(300.0f);
+	std::vector<uint8_t> data;
+	other.Serialize(&data);
+	const Config::Mask otherKeys =
+		Config::MaskOf<Config::TextSize, Config::FillColor, Config::ClipDebounce>();
+	first.clear();
+	CHECK(config.Deserialize(data.data(), data.size()));
+	CHECK(first.size() == 1 && first[0] == otherKeys);
+	first.clear();
+	CHECK(config.Deserialize(data.data(), data.size()));
+	CHECK(first.empty());
+
+	config.RemoveListener(a);
+	second.clear();
+	config.Reset();
+	CHECK(first.empty());
+	CHECK(second.size() == 1 && second[0] == otherKeys);
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestUnknownIds();
+	TestTruncated();
+	TestClamping();
+	TestLoadOrCreate();
+	TestListeners();
+	printf("%s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "SkCoverageDelta.h"
+#include "SkCpu.h"
+
+// Feeds random delta rows to coverage_deltas_to_alphas from every SkOpts
+// tier the CPU runs and requires byte-identical alphas, for all flag
+// combinations, then times each tier on one long row:
+//
+//	coverage_delta_fuzz [--iterations N] [--seed N]
+
+typedef void CoverageDeltasToAlphas(const SkFixed *deltas, SkAlpha *alphas, int count,
+	bool isEvenOdd, bool isInverse, bool isConvex);
+
+// coverage_delta_tier.cpp
+CoverageDeltasToAlphas coverage_deltas_to_alphas_portable;
+CoverageDeltasToAlphas coverage_deltas_to_alphas_hsw;
+CoverageDeltasToAlphas coverage_deltas_to_alphas_skx;
+
+static const int kMaxCount = 40 * SkCoverageDeltaMask::SIMD_WIDTH;
+static const SkAlpha kGuard = 0xA5;
+
+struct Tier
+{
+	const char *name;
+	CoverageDeltasToAlphas *run;
+};
+
+static void FillDeltas(std::mt19937 &random, std::vector<SkFixed> *deltas)
+{
+	int mode = random() % 4;
+	for (SkFixed &delta : *deltas)
+	{
+		switch (mode)
+		{
+		case 0:
+			// Anything at all, overflowing sums included
+			delta = (SkFixed)random();
+			break;
+		case 1:
+			// Around one pixel of coverage either way
+			delta = (SkFixed)(random() % 0x30000) - 0x18000;
+			break;
+		case 2:
+			// Sparse, as real edges are
+			delta = random() % 3 == 0 ? (SkFixed)(random() % 0x20000) - 0x10000 : 0;
+			break;
+		default:
+		{
+			static const SkFixed kEdges[] = { INT32_MIN, INT32_MAX, SK_Fixed1, -SK_Fixed1, SK_Fixed1 - 1, 1, -1, 0 };
+			delta = kEdges[random() % SK_ARRAY_COUNT(kEdges)];
+			break;
+		}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 200000;
+	unsigned seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--iterations")) iterations = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--seed")) seed = (unsigned)strtoul(argv[i + 1], nullptr, 10);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	SkCpu::CacheRuntimeFeatures();
+	std::vector<Tier> tiers = { { "portable", coverage_deltas_to_alphas_portable } };
+	if (SkCpu::Supports(SkCpu::HSW))
+		tiers.push_back({ "hsw", coverage_deltas_to_alphas_hsw });
+	if (SkCpu::Supports(SkCpu::SKX))
+		tiers.push_back({ "skx", coverage_deltas_to_alphas_skx });
+	if (tiers.size() == 1)
+		printf("this CPU runs only the portable tier, nothing to compare\n");
+
+	std::mt19937 random(seed);
+	std::vector<SkFixed> deltas;
+	SkAlpha expected[kMaxCount + 1], actual[kMaxCount + 1];
+	long long runs = 0, mismatches = 0;
+	for (int it = 0; it < iterations; it++)
+	{
+		int count = SkCoverageDeltaMask::SIMD_WIDTH * (1 + random() % 40);
+		deltas.resize(count);
+		FillDeltas(random, &deltas);
+		for (int flags = 0; flags < 8; flags++)
+		{
+			bool isEvenOdd = flags & 1, isInverse = flags & 2, isConvex = flags & 4;
+			memset(expected, kGuard, sizeof(expected));
+			tiers[0].run(deltas.data(), expected, count, isEvenOdd, isInverse, isConvex);
+			for (size_t t = 1; t < tiers.size(); t++)
+			{
+				memset(actual, kGuard, sizeof(actual));
+				tiers[t].run(deltas.data(), actual, count, isEvenOdd, isInverse, isConvex);
+				runs++;
+				if (!memcmp(expected, actual, count) && actual[count] == kGuard)
+					continue;
+				if (mismatches++ < 10)
+				{
+					int at = 0;
+					while (at < count && expected[at] == actual[at]) at++;
+					printf("%s: iteration %d, count %d, evenOdd %d inverse %d convex %d: ",
+						tiers[t].name, it, count, isEvenOdd, isInverse, isConvex);
+					if (at < count)
+						printf("alpha %d is %d, portable %d\n", at, actual[at], expected[at]);
+					else
+						printf("wrote past the row\n");
+				}
+			}
+		}
+	}
+	printf("%lld comparisons, %lld mismatches\n", runs, mismatches);
+
+	// Time one long row of deltas under a pixel
+	std::vector<SkFixed> row(1024);
+	for (SkFixed &delta : row)
+		delta = (SkFixed)(random() % 0x20000) - 0x10000;
+	SkAlpha alphas[1024];
+	for (const Tier &tier : tiers)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 20000; i++)
+			tier.run(row.data(), alphas, 1024, false, false, false);
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		printf("%-8s %.3f ns per alpha\n", tier.name, ns / (20000.0 * 1024));
+	}
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#include "SkCoverageDelta_opts.h"
+
+// Built once per SkOpts tier, with that tier's SK_OPTS_NS and target flags,
+// the way SkOpts.cpp and SkOpts_*.cpp build SkCoverageDelta_opts.h.
+
+#define TIER_FUNCTION_(ns) coverage_deltas_to_alphas_##ns
+#define TIER_FUNCTION(ns) TIER_FUNCTION_(ns)
+
+void TIER_FUNCTION(SK_OPTS_NS)(const SkFixed *deltas, SkAlpha *alphas, int count,
+	bool isEvenOdd, bool isInverse, bool isConvex)
+{
+	SK_OPTS_NS::coverage_deltas_to_alphas(deltas, alphas, count, isEvenOdd, isInverse, isConvex);
+}
@@ -0,0 +1,194 @@
+#include <atomic>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkExecutor.h"
+#include "SkGraphics.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkScan.h"
+
+// Draws tall, complex paths with delta AA, once serially and once with
+// SkScan::SetDAAExecutor(), which splits their rows into bands generated on
+// the executor, and requires identical pixels. Every path is drawn with all
+// four fill types, unclipped, through a rect clip and through an
+// anti-aliased clip path.
+
+static const int kWidth = 1500;
+static const int kHeight = 1200;
+
+// Forwards to a thread pool, counting the bands it was handed
+class CountingExecutor : public SkExecutor
+{
+public:
+	CountingExecutor() : fPool(SkExecutor::MakeFIFOThreadPool(4)), fTasks(0) {}
+
+	void add(std::function<void(void)> work) override
+	{
+		fTasks++;
+		fPool->add(std::move(work));
+	}
+
+	void addTask(void (*fn)(void *), void *ctx) override
+	{
+		fTasks++;
+		fPool->addTask(fn, ctx);
+	}
+
+	int Tasks() const { return fTasks.load(); }
+
+private:
+	std::unique_ptr<SkExecutor> fPool;
+	std::atomic<int> fTasks;
+};
+
+struct Scene
+{
+	const char *name;
+	SkPath path;
+};
+
+static SkPoint RandomPoint(std::mt19937 &random)
+{
+	return { (float)(random() % (kWidth * 16)) / 16, (float)(random() % (kHeight * 16)) / 16 };
+}
+
+static Scene Polygon(std::mt19937 &random)
+{
+	Scene scene = { "polygon" };
+	scene.path.moveTo(RandomPoint(random));
+	for (int i = 0; i < 300; i++)
+		scene.path.lineTo(RandomPoint(random));
+	return scene;
+}
+
+// Quads and cubics around the centre, spanning the full height
+static Scene Star(std::mt19937 &)
+{
+	Scene scene = { "curve star" };
+	const int kPoints = 60;
+	for (int i = 0; i <= kPoints; i++)
+	{
+		double angle = 2 * M_PI * i / kPoints;
+		double radius = i % 2 ? 590 : 150;
+		SkPoint p = { (float)(kWidth / 2 + radius * 1.2 * cos(angle)), (float)(kHeight / 2 + radius * sin(angle)) };
+		if (i == 0)
+			scene.path.moveTo(p);
+		else if (i % 3)
+			scene.path.quadTo({ kWidth / 2.0f, kHeight / 2.0f - 600 + i * 20 }, p);
+		else
+			scene.path.cubicTo({ 0, (float)(i * 19 % kHeight) }, { (float)kWidth, (float)(i * 37 % kHeight) }, p);
+	}
+	return scene;
+}
+
+static Scene Circles(std::mt19937 &random)
+{
+	Scene scene = { "2000 circles" };
+	for (int i = 0; i < 2000; i++)
+	{
+		SkPoint center = RandomPoint(random);
+		scene.path.addCircle(center.fX, center.fY, 2 + (float)(random() % 400) / 10);
+	}
+	return scene;
+}
+
+static Scene Field(std::mt19937 &)
+{
+	Scene scene = { "rect and oval field" };
+	for (int y = 0; y < kHeight; y += 37)
+	{
+		for (int x = 0; x < kWidth; x += 53)
+		{
+			SkRect r = SkRect::MakeXYWH(x + 0.3f, y + 0.6f, 41.5f, 29.25f);
+			if ((x + y) % 3)
+				scene.path.addOval(r);
+			else
+				scene.path.addRect(r);
+		}
+	}
+	return scene;
+}
+
+struct Clip
+{
+	const char *name;
+	void (*apply)(SkCanvas *canvas);
+};
+
+static const Clip kClips[] = {
+	{ "unclipped", [](SkCanvas *) {} },
+	{ "rect clip", [](SkCanvas *canvas) { canvas->clipRect(SkRect::MakeLTRB(70, 90, 1410, 1130)); } },
+	{ "aa clip path", [](SkCanvas *canvas) {
+		SkPath clip;
+		clip.addOval(SkRect::MakeLTRB(40.5f, 20.25f, 1460.5f, 1180.75f));
+		canvas->clipPath(clip, true);
+	} },
+};
+
+static void Draw(SkBitmap *bitmap, const SkPath &path, const Clip &clip)
+{
+	bitmap->eraseColor(SK_ColorWHITE);
+	SkCanvas canvas(*bitmap);
+	clip.apply(&canvas);
+	SkPaint paint;
+	paint.setAntiAlias(true);
+	paint.setColor(0xC02060D0);
+	canvas.drawPath(path, paint);
+}
+
+int main()
+{
+	SkGraphics::Init();
+	gSkForceDeltaAA = true;
+
+	std::mt19937 random(1);
+	Scene scenes[] = { Polygon(random), Star(random), Circles(random), Field(random) };
+	const SkPath::FillType kFillTypes[] = { SkPath::kWinding_FillType, SkPath::kEvenOdd_FillType,
+		SkPath::kInverseWinding_FillType, SkPath::kInverseEvenOdd_FillType };
+	const char *kFillNames[] = { "winding", "even-odd", "inverse winding", "inverse even-odd" };
+
+	CountingExecutor executor;
+	SkBitmap serial, banded;
+	serial.allocN32Pixels(kWidth, kHeight);
+	banded.allocN32Pixels(kWidth, kHeight);
+	int draws = 0, mismatches = 0;
+	for (Scene &scene : scenes)
+	{
+		for (int fill = 0; fill < 4; fill++)
+		{
+			scene.path.setFillType(kFillTypes[fill]);
+			for (const Clip &clip : kClips)
+			{
+				SkScan::SetDAAExecutor(nullptr);
+				Draw(&serial, scene.path, clip);
+				SkScan::SetDAAExecutor(&executor);
+				Draw(&banded, scene.path, clip);
+				SkScan::SetDAAExecutor(nullptr);
+				draws++;
+				if (!memcmp(serial.getPixels(), banded.getPixels(), serial.computeByteSize()))
+					continue;
+				mismatches++;
+				for (int y = 0; y < kHeight; y++)
+				{
+					int x = 0;
+					while (x < kWidth && *serial.getAddr32(x, y) == *banded.getAddr32(x, y)) x++;
+					if (x < kWidth)
+					{
+						printf("%s, %s, %s: pixel (%d, %d) is %08x, serially %08x\n", scene.name,
+							kFillNames[fill], clip.name, x, y, *banded.getAddr32(x, y), *serial.getAddr32(x, y));
+						break;
+					}
+				}
+			}
+		}
+	}
+	gSkForceDeltaAA = false;
+
+	printf("%d draws, %d bands on the executor, %d differ\n", draws, executor.Tasks(), mismatches);
+	// Every scene is tall enough to band; without any, nothing was compared
+	return mismatches || executor.Tasks() == 0 ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SkExecutor.h"
+#include "SkTaskGroup.h"
+
+// Times SkTaskGroup workloads on the FIFO, LIFO and work-stealing pools at
+// 1 to 64 threads, best of --reps runs each, checking every result:
+//
+//	executor_bench [--reps N] [--tasks N] [--max-threads N]
+//
+// batch:  one batch() of tiny tasks, the tiled-device flush pattern
+// add:    the same tasks add()ed one by one from a single thread
+// nested: tasks that run a task group of their own and wait on it
+
+static std::atomic<long long> gSum(0);
+
+static bool Check(long long expected, const char *what, int threads, const char *pool)
+{
+	if (gSum == expected) return true;
+	printf("%s on %d %s threads: sum %lld, expected %lld\n", what, threads, pool, (long long)gSum, expected);
+	return false;
+}
+
+static double Millis(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	int reps = 3;
+	int tasks = 200000;
+	int maxThreads = 64;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--reps")) reps = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--tasks")) tasks = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--max-threads")) maxThreads = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (reps < 1 || tasks < 1 || maxThreads < 1)
+	{
+		fprintf(stderr, "--reps, --tasks and --max-threads must be positive\n");
+		return 2;
+	}
+
+	const struct
+	{
+		const char *name;
+		std::unique_ptr<SkExecutor> (*make)(int);
+	} pools[] = {
+		{ "fifo", SkExecutor::MakeFIFOThreadPool },
+		{ "lifo", SkExecutor::MakeLIFOThreadPool },
+		{ "steal", SkExecutor::MakeWorkStealingThreadPool },
+	};
+	const long long taskSum = (long long)tasks * (tasks - 1) / 2;
+	const int outer = 200, inner = tasks / outer > 0 ? tasks / outer : 1;
+	const long long nestedSum = (long long)outer * inner * (inner - 1) / 2;
+
+	bool ok = true;
+	printf("%d tasks, best of %d\n", tasks, reps);
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		for (const auto &pool : pools)
+		{
+			std::unique_ptr<SkExecutor> executor = pool.make(threads);
+			double best[3] = { 1e30, 1e30, 1e30 };
+			for (int rep = 0; rep < reps; rep++)
+			{
+				double times[3];
+
+				gSum = 0;
+				auto start = std::chrono::steady_clock::now();
+				{
+					SkTaskGroup group(*executor);
+					group.batch(tasks, [](int i) { gSum += i; });
+					group.wait();
+				}
+				times[0] = Millis(start);
+				ok &= Check(taskSum, "batch", threads, pool.name);
+
+				gSum = 0;
+				start = std::chrono::steady_clock::now();
+				{
+					SkTaskGroup group(*executor);
+					for (int i = 0; i < tasks; i++)
+						group.add([i] { gSum += i; });
+					group.wait();
+				}
+				times[1] = Millis(start);
+				ok &= Check(taskSum, "add", threads, pool.name);
+
+				gSum = 0;
+				start = std::chrono::steady_clock::now();
+				{
+					SkExecutor *exec = executor.get();
+					SkTaskGroup group(*exec);
+					group.batch(outer, [exec, inner](int) {
+						SkTaskGroup nested(*exec);
+						nested.batch(inner, [](int i) { gSum += i; });
+						nested.wait();
+					});
+					group.wait();
+				}
+				times[2] = Millis(start);
+				ok &= Check(nestedSum, "nested", threads, pool.name);
+
+				for (int k = 0; k < 3; k++)
+					if (times[k] < best[k]) best[k] = times[k];
+			}
+			printf("%2d threads %-5s  batch %8.2f ms  add %8.2f ms  nested %8.2f ms\n",
+				threads, pool.name, best[0], best[1], best[2]);
+		}
+	}
+
+	// Work still queued when a pool goes away runs before its threads exit. The
+	// LIFO pool pops its shutdown signals ahead of that work, so it is left out.
+	for (const auto &pool : pools)
+	{
+		if (!strcmp(pool.name, "lifo"))
+			continue;
+		gSum = 0;
+		{
+			std::unique_ptr<SkExecutor> executor = pool.make(4);
+			for (int i = 0; i < 1000; i++)
+				executor->add([] { gSum++; });
+		}
+		ok &= Check(1000, "drain at destruction", 4, pool.name);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "SkFontDescriptor.h"
+#include "SkFontMgr.h"
+#include "SkGraphics.h"
+#include "SkTextBlobRunIterator.h"
+#include "SkTypeface.h"
+#include "FontFallback.h"
+#include "SubtitleRenderer.h"
+
+// Resolves a mixed Hangul, kana, hanzi, emoji and Latin string through the
+// fontconfig font manager and checks that every character lands on the
+// first typeface that covers it, that each codepoint costs at most one font
+// manager query, that the 255-typeface cap holds, and that the renderer's
+// text blob starts a new run exactly where the typeface changes.
+//
+// Which scripts fall back depends on the fonts installed; characters the
+// primary typeface lacks but fontconfig has are added, so some always do.
+
+static const wchar_t kMixedText[] =
+	L"안녕하세요 こんにちは 中文字幕 "
+	L"\U0001F600\U0001F389 Anemone 2.0 자막です。";
+
+static bool Covers(const sk_sp<SkTypeface> &typeface, SkUnichar c)
+{
+	SkGlyphID glyph = 0;
+	typeface->charsToGlyphs(&c, SkTypeface::kUTF32_Encoding, &glyph, 1);
+	return glyph != 0;
+}
+
+// Covers exactly one codepoint; has no outlines
+class SingleCharTypeface : public SkTypeface
+{
+public:
+	explicit SingleCharTypeface(SkUnichar c) : SkTypeface(SkFontStyle(), false), fChar(c) {}
+
+protected:
+	SkStreamAsset *onOpenStream(int *) const override { return nullptr; }
+	SkScalerContext *onCreateScalerContext(const SkScalerContextEffects &, const SkDescriptor *) const override
+	{
+		return nullptr;
+	}
+	void onFilterRec(SkScalerContextRec *) const override {}
+	void onGetFontDescriptor(SkFontDescriptor *, bool *) const override {}
+	int onCharsToGlyphs(const void *chars, Encoding encoding, SkGlyphID glyphs[], int glyphCount) const override
+	{
+		int covered = 0;
+		for (int i = 0; i < glyphCount; i++)
+		{
+			bool match = encoding == kUTF32_Encoding && static_cast<const SkUnichar *>(chars)[i] == fChar;
+			if (glyphs) glyphs[i] = match ? 1 : 0;
+			if (match && covered == i) covered++;
+		}
+		return covered;
+	}
+	int onCountGlyphs() const override { return 2; }
+	int onGetUPEM() const override { return 1000; }
+	void onGetFamilyName(SkString *familyName) const override { familyName->printf("U+%04X", fChar); }
+	LocalizedStrings *onCreateFamilyNameIterator() const override { return nullptr; }
+	int onGetVariationDesignPosition(SkFontArguments::VariationPosition::Coordinate[], int) const override
+	{
+		return 0;
+	}
+	int onGetTableTags(SkFontTableTag[]) const override { return 0; }
+	size_t onGetTableData(SkFontTableTag, size_t, size_t, void *) const override { return 0; }
+
+private:
+	SkUnichar fChar;
+};
+
+// Forwards to the default font manager and records the characters it was
+// asked to find a typeface for. With |synthetic|, answers those with a new
+// SingleCharTypeface each.
+class CountingFontMgr : public SkFontMgr
+{
+public:
+	explicit CountingFontMgr(bool synthetic = false)
+		: fReal(SkFontMgr::RefDefault())
+		, fSynthetic(synthetic)
+	{}
+
+	std::vector<SkUnichar> fQueries;
+
+protected:
+	int onCountFamilies() const override { return fReal->countFamilies(); }
+	void onGetFamilyName(int index, SkString *name) const override { fReal->getFamilyName(index, name); }
+	SkFontStyleSet *onCreateStyleSet(int index) const override { return fReal->createStyleSet(index); }
+	SkFontStyleSet *onMatchFamily(const char name[]) const override { return fReal->matchFamily(name); }
+	SkTypeface *onMatchFamilyStyle(const char name[], const SkFontStyle &style) const override
+	{
+		return fReal->matchFamilyStyle(name, style);
+	}
+	SkTypeface *onMatchFamilyStyleCharacter(const char name[], const SkFontStyle &style,
+		const char *bcp47[], int bcp47Count, SkUnichar c) const override
+	{
+		const_cast<CountingFontMgr *>(this)->fQueries.push_back(c);
+		if (fSynthetic)
+			return new SingleCharTypeface(c);
+		return fReal->matchFamilyStyleCharacter(name, style, bcp47, bcp47Count, c);
+	}
+	SkTypeface *onMatchFaceStyle(const SkTypeface *typeface, const SkFontStyle &style) const override
+	{
+		return fReal->matchFaceStyle(typeface, style);
+	}
+	sk_sp<SkTypeface> onMakeFromData(sk_sp<SkData> data, int index) const override
+	{
+		return fReal->makeFromData(std::move(data), index);
+	}
+	sk_sp<SkTypeface> onMakeFromStreamIndex(std::unique_ptr<SkStreamAsset> stream, int index) const override
+	{
+		return fReal->makeFromStream(std::move(stream), index);
+	}
+	sk_sp<SkTypeface> onMakeFromFile(const char path[], int index) const override
+	{
+		return fReal->makeFromFile(path, index);
+	}
+	sk_sp<SkTypeface> onLegacyMakeTypeface(const char name[], SkFontStyle style) const override
+	{
+		return fReal->legacyMakeTypeface(name, style);
+	}
+
+private:
+	sk_sp<SkFontMgr> fReal;
+	bool fSynthetic;
+};
+
+// The typeface SubtitleRenderer resolves as its primary one
+static sk_sp<SkTypeface> PrimaryTypeface()
+{
+	sk_sp<SkFontMgr> mgr(SkFontMgr::RefDefault());
+	sk_sp<SkTypeface> primary(mgr->matchFamilyStyleCharacter(nullptr, SkFontStyle(), nullptr, 0, 0xAC00));
+	return primary ? primary : SkTypeface::MakeDefault();
+}
+
+// Characters |primary| lacks that fontconfig has a typeface for
+static std::wstring FindFallbackChars(const sk_sp<SkTypeface> &primary, int count)
+{
+	sk_sp<SkFontMgr> mgr(SkFontMgr::RefDefault());
+	std::wstring found;
+	int queries = 0;
+	for (SkUnichar c = 0xA0; c < 0x3000 && (int)found.size() < count && queries < 2000; c++)
+	{
+		if (Covers(primary, c)) continue;
+		queries++;
+		sk_sp<SkTypeface> match(mgr->matchFamilyStyleCharacter(nullptr, primary->fontStyle(), nullptr, 0, c));
+		if (match && Covers(match, c))
+			found += (wchar_t)c;
+	}
+	return found;
+}
+
+static bool TestMixedScripts(const std::wstring &text)
+{
+	bool ok = true;
+	sk_sp<CountingFontMgr> mgr(new CountingFontMgr());
+	FontFallback fallback(mgr, PrimaryTypeface());
+
+	std::vector<SkUnichar> chars;
+	SubtitleLayout::Decode(text, &chars);
+	std::vector<int> resolved;
+	for (SkUnichar c : chars)
+		resolved.push_back(fallback.Resolve(c));
+
+	// Each character is on the first typeface that covers it; one no
+	// typeface covers stays on the primary one, and neither had fontconfig
+	sk_sp<SkFontMgr> real(SkFontMgr::RefDefault());
+	for (size_t i = 0; i < chars.size(); i++)
+	{
+		SkUnichar c = chars[i];
+		int index = resolved[i];
+		if (index < 0 || index >= fallback.Count())
+		{
+			printf("U+%04X resolved to typeface %d of %d\n", c, index, fallback.Count());
+			ok = false;
+			continue;
+		}
+		for (int j = 0; j < index; j++)
+		{
+			if (Covers(fallback.Typeface(j), c))
+			{
+				printf("U+%04X resolved to typeface %d, but %d before it covers it\n", c, index, j);
+				ok = false;
+			}
+		}
+		if (c <= ' ' || Covers(fallback.Typeface(index), c))
+			continue;
+		sk_sp<SkTypeface> match(real->matchFamilyStyleCharacter(nullptr, SkFontStyle(), nullptr, 0, c));
+		if (index != 0 || (match && Covers(match, c)))
+		{
+			printf("U+%04X resolved to typeface %d, which lacks it\n", c, index);
+			ok = false;
+		}
+	}
+
+	// At most one query per distinct codepoint, none for repeats or a
+	// second pass, none for spaces
+	std::vector<SkUnichar> queries = mgr->fQueries;
+	std::sort(queries.begin(), queries.end());
+	if (std::adjacent_find(queries.begin(), queries.end()) != queries.end() ||
+		std::count(queries.begin(), queries.end(), ' '))
+	{
+		printf("the font manager was asked for a codepoint twice, or for a space\n");
+		ok = false;
+	}
+	size_t firstPass = mgr->fQueries.size();
+	for (size_t i = 0; i < chars.size(); i++)
+	{
+		if (fallback.Resolve(chars[i]) != resolved[i])
+		{
+			printf("U+%04X resolved differently the second time\n", chars[i]);
+			ok = false;
+		}
+	}
+	if (mgr->fQueries.size() != firstPass)
+	{
+		printf("the second pass made %zu font manager queries\n", mgr->fQueries.size() - firstPass);
+		ok = false;
+	}
+
+	printf("%zu characters, %d typefaces, %zu font manager queries\n",
+		chars.size(), fallback.Count(), firstPass);
+	return ok;
+}
+
+static bool TestTypefaceCap()
+{
+	// Every query adds a typeface that covers only the character asked for
+	bool ok = true;
+	sk_sp<CountingFontMgr> mgr(new CountingFontMgr(true));
+	FontFallback fallback(mgr, SkTypeface::MakeDefault());
+	const int kChars = 300;
+	const SkUnichar kBase = 0xE000;  // private use, uncovered by real fonts
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < kChars; i++)
+		{
+			// Entries hold index + 1 in a byte, so 255 typefaces at most,
+			// the primary one included; the rest stay on the primary one
+			int expected = i < 254 ? i + 1 : 0;
+			int index = fallback.Resolve(kBase + i);
+			if (index != expected)
+			{
+				printf("pass %d: U+%04X resolved to %d, expected %d\n", pass, kBase + i, index, expected);
+				ok = false;
+			}
+			else if (expected && !Covers(fallback.Typeface(index), kBase + i))
+			{
+				printf("U+%04X resolved to a typeface that lacks it\n", kBase + i);
+				ok = false;
+			}
+		}
+	}
+	if (fallback.Count() != 255 || mgr->fQueries.size() != 254)
+	{
+		printf("cap: %d typefaces after %zu queries, expected 255 after 254\n",
+			fallback.Count(), mgr->fQueries.size());
+		ok = false;
+	}
+	return ok;
+}
+
+static bool TestTextBlob(const std::wstring &text)
+{
+	bool ok = true;
+	SubtitleRenderer renderer;
+	renderer.SetStyle(SubtitleStyle());
+	// Wide enough for a single line
+	renderer.AttachLayers(SkImageInfo::MakeN32Premul(8000, 200));
+	renderer.RenderTextLayer(text);
+	const sk_sp<SkTextBlob> &blob = renderer.GetTextBlob();
+	if (!blob)
+	{
+		printf("no text blob\n");
+		return false;
+	}
+
+	// Expected runs: maximal spans of characters on one typeface
+	FontFallback fallback(SkFontMgr::RefDefault(), PrimaryTypeface());
+	std::vector<SkUnichar> chars;
+	SubtitleLayout::Decode(text, &chars);
+	struct Run { int font; int start; int count; };
+	std::vector<Run> expected;
+	for (int i = 0; i < (int)chars.size(); i++)
+	{
+		int font = fallback.Resolve(chars[i]);
+		if (expected.empty() || expected.back().font != font)
+			expected.push_back({ font, i, 0 });
+		expected.back().count++;
+	}
+
+	size_t run = 0;
+	sk_sp<SkTypeface> previous;
+	for (SkTextBlobRunIterator it(blob.get()); !it.done(); it.next(), run++)
+	{
+		SkPaint paint;
+		it.applyFontToPaint(&paint);
+		sk_sp<SkTypeface> typeface = paint.refTypeface();
+		if (previous && SkTypeface::Equal(previous.get(), typeface.get()))
+		{
+			printf("run %zu has the same typeface as the one before it\n", run);
+			ok = false;
+		}
+		previous = typeface;
+		if (run >= expected.size())
+			continue;
+
+		const Run &want = expected[run];
+		std::vector<SkGlyphID> glyphs(want.count);
+		fallback.Typeface(want.font)->charsToGlyphs(&chars[want.start], SkTypeface::kUTF32_Encoding,
+			glyphs.data(), want.count);
+		if (!SkTypeface::Equal(typeface.get(), fallback.Typeface(want.font).get()) ||
+			it.glyphCount() != (uint32_t)want.count ||
+			!std::equal(glyphs.begin(), glyphs.end(), it.glyphs()))
+		{
+			printf("run %zu: %u glyphs, expected %d from typeface %d\n", run, it.glyphCount(),
+				want.count, want.font);
+			ok = false;
+		}
+	}
+	if (run != expected.size())
+	{
+		printf("the blob has %zu runs, expected %zu\n", run, expected.size());
+		ok = false;
+	}
+	printf("%zu runs\n", run);
+	return ok;
+}
+
+int main()
+{
+	SkGraphics::Init();
+
+	// Some characters fall back whatever fonts are installed
+	std::wstring fallbackChars = FindFallbackChars(PrimaryTypeface(), 6);
+	std::wstring text = kMixedText;
+	for (wchar_t c : fallbackChars)
+	{
+		text += c;
+		text += c;
+		text += L"a";
+	}
+	if (fallbackChars.empty())
+		printf("fontconfig has no typeface for anything the primary one lacks\n");
+
+	bool ok = TestMixedScripts(text);
+	ok &= TestTypefaceCap();
+	ok &= TestTextBlob(text);
+	printf("%s\n", ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <math.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include "FrameScheduler.h"
+
+// Drives FrameScheduler::Tick() with a virtual clock at 60 fps and checks the
+// fade curves, the frame counts, and that invalidations between two frames
+// fold into one. Then runs the real worker thread and checks that it
+// sleeps once the fade is over.
+
+typedef FrameScheduler::Clock Clock;
+
+static const int kFps = 60;
+static const Clock::duration kPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / kFps;
+static int gFailures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		gFailures++;
+	}
+}
+
+static double Ms(Clock::duration d)
+{
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+// Ticks once per period until the fade is over; returns the frames emitted
+static int RunFade(FrameScheduler &scheduler, Clock::time_point *now, std::vector<int> *shown, int *ticks)
+{
+	size_t before = shown->size();
+	*ticks = 0;
+	while (scheduler.Tick(*now) && *ticks < 1000)
+	{
+		*now += kPeriod;
+		++*ticks;
+	}
+	return (int)(shown->size() - before);
+}
+
+int main()
+{
+	FrameScheduler scheduler(kFps);
+	std::vector<int> shown;
+	scheduler.SetFrameCallback([&](int opacity) { shown.push_back(opacity); });
+
+	Clock::time_point now = Clock::time_point() + std::chrono::hours(1);
+
+	// The first tick paints the initial, hidden state
+	scheduler.Tick(now);
+	Check(shown.size() == 1 && shown[0] == 0, "first tick paints opacity 0");
+	now += kPeriod;
+	scheduler.Tick(now);
+	Check(shown.size() == 1, "an idle tick emits nothing");
+
+	// Fade in: 256 levels per 200 ms, so opaque 12 frames after the tick
+	// that anchors the clock at 60 fps
+	scheduler.SetHover(true);
+	int ticks;
+	int frames = RunFade(scheduler, &now, &shown, &ticks);
+	printf("fade in: %d ticks, %d frames, opacity %d\n", ticks, frames, scheduler.Opacity());
+	Check(scheduler.Opacity() == 255, "fade in ends opaque");
+	Check(ticks == 12, "fade in takes 12 frames");
+	Check(frames == 12, "every fade-in tick shows a new opacity");
+	for (int i = 0; i < frames; i++)
+	{
+		// The first tick only anchors the clock, so frame i is i + 1 periods in
+		double expected = std::min(255.0, Ms(kPeriod) * (i + 1) * 256.0 / 200.0);
+		int opacity = shown[shown.size() - frames + i];
+		if (fabs(opacity - expected) > 1.0)
+		{
+			printf("fade in frame %d: opacity %d, expected %.1f\n", i, opacity, expected);
+			Check(false, "fade in follows a linear curve");
+			break;
+		}
+	}
+
+	// Fade out: 256 levels per 500 ms, down to 1, which stays hit-testable
+	scheduler.SetHover(false);
+	frames = RunFade(scheduler, &now, &shown, &ticks);
+	printf("fade out: %d ticks, %d frames, opacity %d\n", ticks, frames, scheduler.Opacity());
+	Check(scheduler.Opacity() == 1, "fade out ends at 1");
+	Check(ticks == 30, "fade out takes 30 frames");
+	Check(std::is_sorted(shown.end() - frames, shown.end(), [](int a, int b) { return a > b; }),
+		"fade out only ever decreases");
+
+	// Invalidations between two frames fold into one
+	size_t before = shown.size();
+	for (int i = 0; i < 100; i++)
+		scheduler.Invalidate();
+	now += kPeriod;
+	scheduler.Tick(now);
+	now += kPeriod;
+	scheduler.Tick(now);
+	Check(shown.size() == before + 1, "100 invalidations in a frame repaint once");
+
+	// Ticks faster than the curve moves emit only visible changes
+	scheduler.SetHover(true);
+	before = shown.size();
+	int fastTicks = 0;
+	for (; scheduler.Tick(now) && fastTicks < 10000; fastTicks++)
+		now += std::chrono::microseconds(100);
+	int fastFrames = (int)(shown.size() - before);
+	printf("fade in at 10 kHz: %d ticks, %d frames\n", fastTicks, fastFrames);
+	Check(fastFrames <= 255 && fastFrames < fastTicks, "ticks without a visible change emit nothing");
+	for (size_t i = before + 1; i < shown.size(); i++)
+		Check(shown[i] != shown[i - 1], "consecutive frames differ");
+
+	// The worker paces a real fade and then sleeps
+	FrameScheduler live(kFps);
+	int liveFrames = 0;
+	live.SetFrameCallback([&](int) { liveFrames++; });
+	live.Start();
+	live.SetHover(true);
+	std::this_thread::sleep_for(std::chrono::milliseconds(400));
+	int fadeFrames = liveFrames;
+	std::clock_t cpuStart = std::clock();
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	double idleCpuMs = 1000.0 * (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	int idleFrames = liveFrames - fadeFrames;
+	live.Stop();
+	printf("live: %d frames fading in, %d while idle, %.1f ms CPU over 300 ms idle\n",
+		fadeFrames, idleFrames, idleCpuMs);
+	Check(live.Opacity() == 255, "live fade in ends opaque");
+	Check(fadeFrames >= 2 && fadeFrames <= 400 / 16 + 2, "live fade in is paced");
+	Check(idleFrames == 0, "an idle worker emits nothing");
+	Check(idleCpuMs < 30.0, "an idle worker sleeps");
+
+	printf("%d failures\n", gFailures);
+	return gFailures ? 1 : 0;
+}
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <x86intrin.h>
+#include "SkArenaAlloc.h"
+#include "SkCpu.h"
+#include "SkOpts.h"
+#include "SkRasterPipeline.h"
+#include "../jumper/SkJumper.h"
+
+// Runs the raster pipelines Anemone's draws turn into on every SkOpts tier
+// this CPU has, at lowp and highp, and compares their pixels with the
+// portable highp stages over every tail length up to 40. Then reports how
+// many pixels per TSC cycle each tier manages. Each run of stages compile()
+// fuses must draw exactly what run() draws unfused, on every tier and at
+// both precisions.
+//
+//	pipeline_bench [--rows N] [--reps N] [--shapes]
+//
+// --shapes turns on SkRasterPipeline::TrackShapes() and dumps the pipelines
+// compiled, after fusion, at the end.
+//
+// Only Clang builds the vector tiers; under GCC every tier is the scalar
+// fallback and the comparison is trivially exact.
+
+namespace SkOpts
+{
+	// src/opts/SkOpts_*.cpp
+	void Init_sse41();
+	void Init_avx();
+	void Init_hsw();
+	void Init_skx();
+}
+
+static const int kStages = SK_ARRAY_COUNT(SkOpts::stages_highp);
+static const int kWidth = 1024;
+static const int kTexture = 64;
+static const int kMaxTail = 40;
+// lowp rounds differently from highp, and vector tiers use rcp estimates
+static const int kTolerance = 2;
+
+struct Tier
+{
+	const char *name;
+	SkOpts::StageFn highp[kStages], lowp[kStages];
+	SkOpts::StageFn justReturnHighp, justReturnLowp;
+	void (*startHighp)(size_t, size_t, size_t, size_t, void **);
+	void (*startLowp)(size_t, size_t, size_t, size_t, void **);
+};
+
+static Tier Capture(const char *name)
+{
+	Tier tier;
+	tier.name = name;
+	memcpy(tier.highp, SkOpts::stages_highp, sizeof(tier.highp));
+	memcpy(tier.lowp, SkOpts::stages_lowp, sizeof(tier.lowp));
+	tier.justReturnHighp = SkOpts::just_return_highp;
+	tier.justReturnLowp = SkOpts::just_return_lowp;
+	tier.startHighp = SkOpts::start_pipeline_highp;
+	tier.startLowp = SkOpts::start_pipeline_lowp;
+	return tier;
+}
+
+// Without lowp stages every pipeline builds from the highp ones
+static void Install(const Tier &tier, bool lowp)
+{
+	memcpy(SkOpts::stages_highp, tier.highp, sizeof(tier.highp));
+	if (lowp)
+		memcpy(SkOpts::stages_lowp, tier.lowp, sizeof(tier.lowp));
+	else
+		memset(SkOpts::stages_lowp, 0, sizeof(tier.lowp));
+	SkOpts::just_return_highp = tier.justReturnHighp;
+	SkOpts::just_return_lowp = tier.justReturnLowp;
+	SkOpts::start_pipeline_highp = tier.startHighp;
+	SkOpts::start_pipeline_lowp = tier.startLowp;
+}
+
+#define M(st) #st,
+static const char *kStageNames[] = { SK_RASTER_PIPELINE_STAGES(M) };
+#undef M
+
+struct Contexts
+{
+	SkJumper_MemoryCtx src, dst, coverage;
+	float coverageFloat;
+	SkJumper_GatherCtx texture;
+	SkJumper_TileCtx tile;
+	float matrix[6];
+	// Every stage appended, to tell whether a tier has all of them in lowp
+	std::vector<SkRasterPipeline::StockStage> stages;
+};
+
+static void Append(SkRasterPipeline *p, Contexts *ctx, SkRasterPipeline::StockStage stage, void *arg = nullptr)
+{
+	p->append(stage, arg);
+	ctx->stages.push_back(stage);
+}
+
+typedef void (*Build)(SkRasterPipeline *pipeline, SkArenaAlloc *alloc, Contexts *ctx);
+
+static void BuildSrcOver(SkRasterPipeline *p, SkArenaAlloc *, Contexts *ctx)
+{
+	Append(p, ctx, SkRasterPipeline::load_8888, &ctx->src);
+	Append(p, ctx, SkRasterPipeline::load_8888_dst, &ctx->dst);
+	Append(p, ctx, SkRasterPipeline::srcover);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+// A solid paint through a glyph or blur mask, the bulk of a subtitle frame
+static void BuildCoverage(SkRasterPipeline *p, SkArenaAlloc *alloc, Contexts *ctx)
+{
+	const float color[4] = { 0.18f, 0.45f, 0.81f, 0.9f };
+	p->append_constant_color(alloc, color);
+	ctx->stages.push_back(SkRasterPipeline::uniform_color);
+	Append(p, ctx, SkRasterPipeline::scale_u8, &ctx->coverage);
+	Append(p, ctx, SkRasterPipeline::load_8888_dst, &ctx->dst);
+	Append(p, ctx, SkRasterPipeline::srcover);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+static void BuildMultiply(SkRasterPipeline *p, SkArenaAlloc *, Contexts *ctx)
+{
+	Append(p, ctx, SkRasterPipeline::load_8888, &ctx->src);
+	Append(p, ctx, SkRasterPipeline::load_8888_dst, &ctx->dst);
+	Append(p, ctx, SkRasterPipeline::multiply);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+static void BuildSRGB(SkRasterPipeline *p, SkArenaAlloc *, Contexts *ctx)
+{
+	Append(p, ctx, SkRasterPipeline::load_8888, &ctx->src);
+	Append(p, ctx, SkRasterPipeline::unpremul);
+	Append(p, ctx, SkRasterPipeline::from_srgb);
+	Append(p, ctx, SkRasterPipeline::to_srgb);
+	Append(p, ctx, SkRasterPipeline::premul);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+static void BuildSample(SkRasterPipeline *p, SkArenaAlloc *, Contexts *ctx)
+{
+	Append(p, ctx, SkRasterPipeline::seed_shader);
+	Append(p, ctx, SkRasterPipeline::matrix_2x3, ctx->matrix);
+	Append(p, ctx, SkRasterPipeline::repeat_x, &ctx->tile);
+	Append(p, ctx, SkRasterPipeline::repeat_y, &ctx->tile);
+	Append(p, ctx, SkRasterPipeline::gather_8888, &ctx->texture);
+	Append(p, ctx, SkRasterPipeline::load_8888_dst, &ctx->dst);
+	Append(p, ctx, SkRasterPipeline::srcover);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+static void BuildBilerp(SkRasterPipeline *p, SkArenaAlloc *, Contexts *ctx)
+{
+	Append(p, ctx, SkRasterPipeline::seed_shader);
+	Append(p, ctx, SkRasterPipeline::matrix_2x3, ctx->matrix);
+	Append(p, ctx, SkRasterPipeline::bilerp_clamp_8888, &ctx->texture);
+	Append(p, ctx, SkRasterPipeline::store_8888, &ctx->dst);
+}
+
+static const struct
+{
+	const char *name;
+	Build build;
+} kPipelines[] = {
+	{ "srcover", BuildSrcOver },
+	{ "coverage", BuildCoverage },
+	{ "multiply", BuildMultiply },
+	{ "srgb", BuildSRGB },
+	{ "sample", BuildSample },
+	{ "bilerp", BuildBilerp },
+};
+
+// The runs SkRasterPipeline::compile() fuses, each after a uniform color
+struct Fusion
+{
+	const char *name;
+	SkRasterPipeline::StockStage coverage, load, store;
+	bool srcover;  // coverage, load, srcover, store; else load, coverage, store
+};
+
+static const Fusion kFusions[] = {
+	{ "srcover_u8_8888", SkRasterPipeline::scale_u8, SkRasterPipeline::load_8888_dst, SkRasterPipeline::store_8888, true },
+	{ "srcover_u8_bgra", SkRasterPipeline::scale_u8, SkRasterPipeline::load_bgra_dst, SkRasterPipeline::store_bgra, true },
+	{ "srcover_1_float_8888", SkRasterPipeline::scale_1_float, SkRasterPipeline::load_8888_dst, SkRasterPipeline::store_8888, true },
+	{ "srcover_1_float_bgra", SkRasterPipeline::scale_1_float, SkRasterPipeline::load_bgra_dst, SkRasterPipeline::store_bgra, true },
+	{ "src_u8_8888", SkRasterPipeline::lerp_u8, SkRasterPipeline::load_8888_dst, SkRasterPipeline::store_8888, false },
+	{ "src_u8_bgra", SkRasterPipeline::lerp_u8, SkRasterPipeline::load_bgra_dst, SkRasterPipeline::store_bgra, false },
+	{ "src_1_float_8888", SkRasterPipeline::lerp_1_float, SkRasterPipeline::load_8888_dst, SkRasterPipeline::store_8888, false },
+	{ "src_1_float_bgra", SkRasterPipeline::lerp_1_float, SkRasterPipeline::load_bgra_dst, SkRasterPipeline::store_bgra, false },
+};
+
+static void BuildFusion(SkRasterPipeline *p, SkArenaAlloc *alloc, Contexts *ctx, const Fusion &fusion)
+{
+	const float color[4] = { 0.18f, 0.45f, 0.81f, 0.9f };
+	p->append_constant_color(alloc, color);
+	ctx->stages.push_back(SkRasterPipeline::uniform_color);
+	void *coverage = fusion.coverage == SkRasterPipeline::scale_u8 || fusion.coverage == SkRasterPipeline::lerp_u8
+		? (void *)&ctx->coverage : (void *)&ctx->coverageFloat;
+	if (fusion.srcover)
+	{
+		Append(p, ctx, fusion.coverage, coverage);
+		Append(p, ctx, fusion.load, &ctx->dst);
+		Append(p, ctx, SkRasterPipeline::srcover);
+		Append(p, ctx, fusion.store, &ctx->dst);
+	}
+	else
+	{
+		Append(p, ctx, fusion.load, &ctx->dst);
+		Append(p, ctx, fusion.coverage, coverage);
+		Append(p, ctx, fusion.store, &ctx->dst);
+	}
+}
+
+struct Pixels
+{
+	int rows;
+	std::vector<uint32_t> src, dst, texture;
+	std::vector<uint8_t> coverage;
+};
+
+static uint32_t RandomPremul(std::mt19937 &random)
+{
+	uint32_t a = random() % 256;
+	// Opaque and transparent pixels are common, and take different paths
+	if (random() % 4 == 0) a = random() % 2 ? 255 : 0;
+	uint32_t pixel = a << 24;
+	for (int shift = 0; shift < 24; shift += 8)
+		pixel |= (a ? random() % (a + 1) : 0) << shift;
+	return pixel;
+}
+
+static Pixels MakePixels(int rows, unsigned seed)
+{
+	std::mt19937 random(seed);
+	Pixels pixels;
+	pixels.rows = rows;
+	pixels.src.resize(kWidth * rows);
+	pixels.dst.resize(kWidth * rows);
+	pixels.coverage.resize(kWidth * rows);
+	pixels.texture.resize(kTexture * kTexture);
+	for (uint32_t &p : pixels.src) p = RandomPremul(random);
+	for (uint32_t &p : pixels.dst) p = RandomPremul(random);
+	for (uint32_t &p : pixels.texture) p = RandomPremul(random);
+	for (uint8_t &c : pixels.coverage) c = random() % 3 ? (uint8_t)random() : (random() % 2 ? 255 : 0);
+	return pixels;
+}
+
+static void MakeContexts(const Pixels &pixels, uint32_t *dst, Contexts *ctx)
+{
+	ctx->src = { (void *)pixels.src.data(), kWidth };
+	ctx->dst = { dst, kWidth };
+	ctx->coverage = { (void *)pixels.coverage.data(), kWidth };
+	ctx->coverageFloat = 0.6f;
+	ctx->texture = { pixels.texture.data(), kTexture, (float)kTexture, (float)kTexture };
+	ctx->tile = { (float)kTexture, 1.0f / kTexture };
+	// Scaled and rotated, so samples land between texels
+	const float angle = 0.3f, scale = 0.7f;
+	ctx->matrix[0] = scale * cosf(angle);
+	ctx->matrix[1] = -scale * sinf(angle);
+	ctx->matrix[2] = scale * sinf(angle);
+	ctx->matrix[3] = scale * cosf(angle);
+	ctx->matrix[4] = 3.25f;
+	ctx->matrix[5] = -7.5f;
+}
+
+// Draws |build| over |width| x |pixels.rows| into a copy of pixels.dst
+static std::vector<uint32_t> Run(Build build, const Pixels &pixels, int width)
+{
+	std::vector<uint32_t> dst = pixels.dst;
+	Contexts ctx;
+	MakeContexts(pixels, dst.data(), &ctx);
+	SkSTArenaAlloc<1024> alloc;
+	SkRasterPipeline pipeline(&alloc);
+	build(&pipeline, &alloc, &ctx);
+	pipeline.run(0, 0, width, pixels.rows);
+	return dst;
+}
+
+// Draws |fusion| like Run(), through compile(), which fuses it, or run()
+static std::vector<uint32_t> RunFusion(const Fusion &fusion, const Pixels &pixels, int width, bool compiled)
+{
+	std::vector<uint32_t> dst = pixels.dst;
+	Contexts ctx;
+	MakeContexts(pixels, dst.data(), &ctx);
+	SkSTArenaAlloc<1024> alloc;
+	SkRasterPipeline pipeline(&alloc);
+	BuildFusion(&pipeline, &alloc, &ctx, fusion);
+	if (compiled)
+		pipeline.compile()(0, 0, width, pixels.rows);
+	else
+		pipeline.run(0, 0, width, pixels.rows);
+	return dst;
+}
+
+// Fewest TSC cycles one pass over all of |pixels| took; blending into the
+// same dst again each pass is fine for timing
+static unsigned long long Time(Build build, const Pixels &pixels, int reps)
+{
+	std::vector<uint32_t> dst = pixels.dst;
+	Contexts ctx;
+	MakeContexts(pixels, dst.data(), &ctx);
+	SkSTArenaAlloc<1024> alloc;
+	SkRasterPipeline pipeline(&alloc);
+	build(&pipeline, &alloc, &ctx);
+	std::function<void(size_t, size_t, size_t, size_t)> run = pipeline.compile();
+	unsigned long long best = ~0ull;
+	for (int rep = 0; rep < reps; rep++)
+	{
+		unsigned long long start = __rdtsc();
+		run(0, 0, kWidth, pixels.rows);
+		best = std::min(best, __rdtsc() - start);
+	}
+	return best;
+}
+
+// The first of |build|'s stages |tier| has no lowp version of, or nullptr;
+// SkRasterPipeline quietly runs such pipelines in highp
+static const char *MissingLowp(const Tier &tier, Build build)
+{
+	Contexts ctx;
+	SkSTArenaAlloc<1024> alloc;
+	SkRasterPipeline pipeline(&alloc);
+	build(&pipeline, &alloc, &ctx);
+	for (SkRasterPipeline::StockStage stage : ctx.stages)
+		if (!tier.lowp[stage]) return kStageNames[stage];
+	return nullptr;
+}
+
+static int MaxDifference(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b, int width, int rows)
+{
+	int worst = 0;
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < kWidth; x++)
+		{
+			uint32_t pa = a[y * kWidth + x], pb = b[y * kWidth + x];
+			// Outside the run nothing may change at all
+			if (x >= width && pa != pb) return 256;
+			for (int shift = 0; shift < 32; shift += 8)
+				worst = std::max(worst, abs((int)(pa >> shift & 255) - (int)(pb >> shift & 255)));
+		}
+	}
+	return worst;
+}
+
+int main(int argc, char **argv)
+{
+	int rows = 64;
+	int reps = 20;
+	bool shapes = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--shapes")) shapes = true;
+		else if (!strcmp(argv[i], "--rows") && i + 1 < argc) rows = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--reps") && i + 1 < argc) reps = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (rows < 1 || reps < 1)
+	{
+		fprintf(stderr, "--rows and --reps must be positive\n");
+		return 2;
+	}
+
+	// Not SkGraphics::Init(): that installs the best tier before the
+	// portable tables can be saved
+	SkCpu::CacheRuntimeFeatures();
+	std::vector<Tier> tiers;
+	tiers.push_back(Capture("portable"));
+	if (SkCpu::Supports(SkCpu::SSE41))
+	{
+		SkOpts::Init_sse41();
+		tiers.push_back(Capture("sse41"));
+	}
+	if (SkCpu::Supports(SkCpu::AVX))
+	{
+		SkOpts::Init_avx();
+		tiers.push_back(Capture("avx"));
+	}
+	if (SkCpu::Supports(SkCpu::HSW))
+	{
+		SkOpts::Init_hsw();
+		tiers.push_back(Capture("hsw"));
+	}
+	if (SkCpu::Supports(SkCpu::SKX))
+	{
+		SkOpts::Init_skx();
+		tiers.push_back(Capture("skx"));
+	}
+	const Tier *hsw = nullptr;
+	for (const Tier &tier : tiers)
+		if (!strcmp(tier.name, "hsw")) hsw = &tier;
+
+	if (shapes)
+		SkRasterPipeline::TrackShapes(true);
+
+	Pixels small = MakePixels(3, 1);
+	Pixels large = MakePixels(rows, 2);
+	bool ok = true;
+
+	// compile() fuses, run() never does; a fused run must not change a pixel.
+	// fuse() checks its own slot count against the stages it emits.
+	for (const Fusion &fusion : kFusions)
+	{
+		for (const Tier &tier : tiers)
+		{
+			for (bool lowp : { true, false })
+			{
+				const char *missing = nullptr;
+				if (lowp)
+				{
+					Contexts ctx;
+					SkSTArenaAlloc<1024> alloc;
+					SkRasterPipeline pipeline(&alloc);
+					BuildFusion(&pipeline, &alloc, &ctx, fusion);
+					for (SkRasterPipeline::StockStage stage : ctx.stages)
+						if (!missing && !tier.lowp[stage]) missing = kStageNames[stage];
+				}
+				if (missing)
+				{
+					printf("%-20s %-9s %-5s  no lowp %s\n", fusion.name, tier.name, "lowp", missing);
+					continue;
+				}
+				Install(tier, lowp);
+				int worst = 0;
+				for (int width = 1; width <= kMaxTail; width++)
+					worst = std::max(worst, MaxDifference(RunFusion(fusion, small, width, false),
+						RunFusion(fusion, small, width, true), width, small.rows));
+				ok &= worst == 0;
+				printf("%-20s %-9s %-5s  compiled %s\n", fusion.name, tier.name, lowp ? "lowp" : "highp",
+					worst ? "differs from run()  FAIL" : "matches run()");
+			}
+		}
+	}
+	printf("\n");
+	printf("%-9s %-9s %-5s  %8s  %6s  %10s\n", "pipeline", "tier", "", "vs port", "vs hsw", "px/cycle");
+	for (const auto &pipeline : kPipelines)
+	{
+		// Every tail length against portable highp, and against hsw at the same precision
+		std::vector<std::vector<uint32_t>> reference;
+		Install(tiers[0], false);
+		for (int width = 1; width <= kMaxTail; width++)
+			reference.push_back(Run(pipeline.build, small, width));
+
+		for (const Tier &tier : tiers)
+		{
+			for (bool lowp : { true, false })
+			{
+				const char *missing = lowp ? MissingLowp(tier, pipeline.build) : nullptr;
+				if (missing)
+				{
+					printf("%-9s %-9s %-5s  no lowp %s\n", pipeline.name, tier.name, "lowp", missing);
+					continue;
+				}
+				// Against hsw only at the same precision
+				bool vsHswToo = hsw && hsw != &tier && !(lowp && MissingLowp(*hsw, pipeline.build));
+				int vsPortable = 0, vsHsw = 0;
+				for (int width = 1; width <= kMaxTail; width++)
+				{
+					Install(tier, lowp);
+					std::vector<uint32_t> out = Run(pipeline.build, small, width);
+					vsPortable = std::max(vsPortable, MaxDifference(reference[width - 1], out, width, small.rows));
+					if (vsHswToo)
+					{
+						Install(*hsw, lowp);
+						std::vector<uint32_t> other = Run(pipeline.build, small, width);
+						vsHsw = std::max(vsHsw, MaxDifference(other, out, width, small.rows));
+					}
+				}
+				bool failed = vsPortable > kTolerance || vsHsw > kTolerance;
+				ok &= !failed;
+
+				Install(tier, lowp);
+				unsigned long long best = Time(pipeline.build, large, reps);
+				char hswColumn[16] = "-";
+				if (vsHswToo)
+					snprintf(hswColumn, sizeof(hswColumn), "%d", vsHsw);
+				printf("%-9s %-9s %-5s  %8d  %6s  %10.3f%s\n", pipeline.name, tier.name, lowp ? "lowp" : "highp",
+					vsPortable, hswColumn, (double)kWidth * rows / best, failed ? "  FAIL" : "");
+			}
+		}
+	}
+	if (shapes)
+		SkRasterPipeline::DumpShapes();
+	return ok ? 0 : 1;
+}
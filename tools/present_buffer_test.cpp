@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SkGraphics.h"
+#include "SubtitleRenderer.h"
+
+// Renders into a MemoryPresentBuffer frame after frame, the way PaintLoop
+// does once a caption is up, and requires that no steady-state frame
+// allocates: the buffers and the surfaces wrapping them persist, and only
+// Resize() to a new size replaces them.
+//
+//	present_buffer_test [--frames N]
+//
+// Every heap allocation is counted by wrapping glibc's malloc family, which
+// catches operator new and sk_malloc alike.
+
+#ifndef __GLIBC__
+#error present_buffer_test counts allocations through the glibc malloc
+#endif
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<long long> gAllocations(0);
+
+extern "C" {
+void *malloc(size_t size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	*ptr = memalign(alignment, size);
+	return *ptr ? 0 : ENOMEM;
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+}
+
+// One caption's worth of chrome: the title bar fading in and out, the
+// buttons hovered now and then
+static SubtitleFrameState FrameState(int frame)
+{
+	const int kCycle = 40;
+	int phase = frame % kCycle;
+	SubtitleFrameState state;
+	state.fOpacity = std::min(255, std::max(0, 255 - std::abs(phase * 2 - kCycle) * 512 / kCycle));
+	state.fHoverMinimize = phase >= 10 && phase < 14;
+	state.fHoverClose = phase >= 20 && phase < 22;
+	state.fLine = 7;
+	state.fLineCount = 120;
+	return state;
+}
+
+int main(int argc, char **argv)
+{
+	int frames = 400;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--frames")) frames = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	SkGraphics::Init();
+
+	MemoryPresentBuffer buffer;
+	SkImageInfo info = SkImageInfo::MakeN32Premul(800, 200);
+	SubtitleRenderer renderer;
+	renderer.SetStyle(SubtitleStyle());
+	if (!buffer.Resize(info) || !renderer.Attach(&buffer))
+	{
+		fprintf(stderr, "cannot set up the present buffers\n");
+		return 2;
+	}
+	renderer.SetText(L"오늘은 날씨가 정말 좋네요. Anemone 0123");
+
+	// The first pass through the cycle lays the text out and fills the caches
+	for (int frame = 0; frame < 80; frame++)
+		renderer.Render(FrameState(frame));
+
+	bool ok = true;
+	const void *pixels[] = { buffer.GetPixels(0), buffer.GetPixels(1) };
+	long long before = gAllocations.load();
+	int presented = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		renderer.Render(FrameState(frame));
+		if (!renderer.GetDamage().isEmpty())
+			presented++;
+	}
+	long long allocations = gAllocations.load() - before;
+	printf("%d frames, %d presented, %lld allocations\n", frames, presented, allocations);
+	if (allocations || !presented)
+		ok = false;
+
+	// Resizing to the same size keeps the buffers; a new size replaces them
+	before = gAllocations.load();
+	buffer.Resize(info);
+	if (gAllocations.load() != before || buffer.GetPixels(0) != pixels[0] || buffer.GetPixels(1) != pixels[1])
+	{
+		printf("Resize() to the same size reallocated\n");
+		ok = false;
+	}
+	if (!buffer.Resize(SkImageInfo::MakeN32Premul(640, 160)) || buffer.Info().width() != 640)
+	{
+		printf("Resize() to a new size failed\n");
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include "SkBitmap.h"
+#include "SkColorSpace.h"
+#include "SkColorSpaceXform.h"
+#include "SkGradientShader.h"
+#include "SkImageEncoder.h"
+
+// The snapshot carries neither third_party/skcms nor the image encoders.
+// Nothing the renderer draws needs them: every surface is sRGB N32, so no
+// color space conversion is ever asked for, and nothing is encoded.
+
+std::unique_ptr<SkColorSpaceXform> SkMakeColorSpaceXform(SkColorSpace *, SkColorSpace *, SkTransferFunctionBehavior)
+{
+	return nullptr;
+}
+
+bool SkColorSpaceXform::Apply(SkColorSpace *, ColorFormat, void *, SkColorSpace *, ColorFormat, const void *, int, AlphaOp)
+{
+	return false;
+}
+
+sk_sp<SkColorSpace> SkColorSpace::MakeICC(const void *, size_t)
+{
+	return nullptr;
+}
+
+sk_sp<SkData> SkEncodeBitmap(const SkBitmap &, SkEncodedImageFormat, int)
+{
+	return nullptr;
+}
+
+sk_sp<SkData> SkEncodePixmap(const SkPixmap &, SkEncodedImageFormat, int)
+{
+	return nullptr;
+}
+
+// Gradients live in SkGradientShader.cpp, which needs skcms
+void SkGradientShader::InitializeFlattenables()
+{
+}
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkDescriptor.h"
+#include "SkGraphics.h"
+#include "SkMask.h"
+#include "SkPaint.h"
+#include "SkStream.h"
+#include "SkStrikeArchive.h"
+#include "SkStrikeCache.h"
+#include "SkSurface.h"
+#include "SkTypeface.h"
+
+// Writes a strike archive from a warmed strike cache, purges the cache and
+// draws the same text from the reloaded archive: the pixels must be
+// identical and no real scaler context may be created for archived glyphs.
+// Then damages copies of the file, each in one way validate() must catch,
+// and requires Load to refuse them.
+
+static const char kText[] = "Strike archive 0123 (round trip), jumps over the lazy dog!";
+static const char kPath[] = "strike_archive_test.skstrike";
+static const char kDamagedPath[] = "strike_archive_test_damaged.skstrike";
+
+// The file layout as SkStrikeArchive.cpp writes it; the header's size
+// fields are checked against these below
+struct Header
+{
+	char fMagic[8];
+	uint32_t fVersion;
+	uint32_t fRecSize;
+	uint32_t fStrikeSize;
+	uint32_t fGlyphSize;
+	uint64_t fLength;
+	uint32_t fStrikeCount;
+	uint32_t fPad;
+};
+
+struct StrikeRecord
+{
+	uint64_t fTypefaceKey;
+	uint32_t fDescOffset;
+	uint32_t fGlyphOffset;
+	uint32_t fGlyphCount;
+	uint32_t fTypefaceGlyphCount;
+	SkPaint::FontMetrics fFontMetrics;
+};
+
+struct GlyphRecord
+{
+	uint32_t fPackedID;
+	float fAdvanceX, fAdvanceY;
+	uint16_t fWidth, fHeight;
+	int16_t fTop, fLeft;
+	int8_t fForceBW;
+	uint8_t fMaskFormat;
+	uint16_t fFlags;
+	uint32_t fImageOffset;
+	uint32_t fPathOffset;
+	uint32_t fPathSize;
+};
+
+// Forwards to a real typeface and counts the scaler contexts made for it.
+// Archived strikes match it, since it has the same name, style and tables.
+class CountingTypeface : public SkTypeface
+{
+public:
+	explicit CountingTypeface(sk_sp<SkTypeface> real)
+		: SkTypeface(real->fontStyle(), real->isFixedPitch())
+		, fReal(std::move(real))
+		, fScalerContexts(0)
+	{}
+
+	int TakeScalerContexts() { int count = fScalerContexts; fScalerContexts = 0; return count; }
+
+protected:
+	SkScalerContext *onCreateScalerContext(const SkScalerContextEffects &effects, const SkDescriptor *desc) const override
+	{
+		fScalerContexts++;
+		return fReal->createScalerContext(effects, desc, true).release();
+	}
+	void onFilterRec(SkScalerContextRec *rec) const override { fReal->filterRec(rec); }
+	SkStreamAsset *onOpenStream(int *ttcIndex) const override { return fReal->openStream(ttcIndex); }
+	int onGetVariationDesignPosition(SkFontArguments::VariationPosition::Coordinate coordinates[],
+		int coordinateCount) const override
+	{
+		return fReal->getVariationDesignPosition(coordinates, coordinateCount);
+	}
+	void onGetFontDescriptor(SkFontDescriptor *desc, bool *isLocal) const override
+	{
+		fReal->getFontDescriptor(desc, isLocal);
+	}
+	int onCharsToGlyphs(const void *chars, Encoding encoding, SkGlyphID glyphs[], int glyphCount) const override
+	{
+		return fReal->charsToGlyphs(chars, encoding, glyphs, glyphCount);
+	}
+	int onCountGlyphs() const override { return fReal->countGlyphs(); }
+	int onGetUPEM() const override { return fReal->getUnitsPerEm(); }
+	void onGetFamilyName(SkString *familyName) const override { fReal->getFamilyName(familyName); }
+	LocalizedStrings *onCreateFamilyNameIterator() const override { return fReal->createFamilyNameIterator(); }
+	int onGetTableTags(SkFontTableTag tags[]) const override { return fReal->getTableTags(tags); }
+	size_t onGetTableData(SkFontTableTag tag, size_t offset, size_t length, void *data) const override
+	{
+		return fReal->getTableData(tag, offset, length, data);
+	}
+
+private:
+	sk_sp<SkTypeface> fReal;
+	mutable int fScalerContexts;
+};
+
+// Glyph images at two sizes, one stroked, and outlines past the largest
+// size cached as images
+static void Draw(SkSurface *surface, const sk_sp<SkTypeface> &typeface)
+{
+	SkCanvas *canvas = surface->getCanvas();
+	canvas->clear(SK_ColorWHITE);
+	SkPaint paint;
+	paint.setAntiAlias(true);
+	paint.setTypeface(typeface);
+	paint.setTextSize(18);
+	canvas->drawText(kText, strlen(kText), 10, 30, paint);
+	paint.setTextSize(40);
+	canvas->drawText(kText, strlen(kText), 10, 90, paint);
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeWidth(3);
+	canvas->drawText(kText, strlen(kText), 10, 150, paint);
+	paint.setStyle(SkPaint::kFill_Style);
+	paint.setTextSize(300);
+	canvas->drawText(kText, 8, 10, 450, paint);
+}
+
+static bool SamePixels(SkSurface *a, SkSurface *b)
+{
+	SkPixmap pa, pb;
+	if (!a->peekPixels(&pa) || !b->peekPixels(&pb))
+		return false;
+	for (int y = 0; y < pa.height(); y++)
+		if (memcmp(pa.addr(0, y), pb.addr(0, y), pa.width() * 4))
+			return false;
+	return true;
+}
+
+static bool ReadFile(const char *path, std::vector<uint8_t> *bytes)
+{
+	sk_sp<SkData> data = SkData::MakeFromFileName(path);
+	if (!data) return false;
+	bytes->assign(data->bytes(), data->bytes() + data->size());
+	return true;
+}
+
+static bool WriteFile(const char *path, const std::vector<uint8_t> &bytes)
+{
+	SkFILEWStream stream(path);
+	return stream.isValid() && stream.write(bytes.data(), bytes.size());
+}
+
+template <typename T>
+static T *At(std::vector<uint8_t> &bytes, size_t offset)
+{
+	return reinterpret_cast<T *>(bytes.data() + offset);
+}
+
+static bool TestRoundTrip(const sk_sp<CountingTypeface> &typeface)
+{
+	bool ok = true;
+	SkImageInfo info = SkImageInfo::MakeN32Premul(1400, 500);
+	sk_sp<SkSurface> warm = SkSurface::MakeRaster(info);
+	sk_sp<SkSurface> archived = SkSurface::MakeRaster(info);
+
+	SkStrikeArchive::Unload();
+	SkStrikeCache::PurgeAll();
+	Draw(warm.get(), typeface);
+	if (!typeface->TakeScalerContexts())
+	{
+		printf("round trip: the first draw made no scaler contexts\n");
+		ok = false;
+	}
+	if (!SkStrikeArchive::Write(kPath))
+	{
+		printf("round trip: cannot write %s\n", kPath);
+		return false;
+	}
+
+	SkStrikeCache::PurgeAll();
+	if (!SkStrikeArchive::Load(kPath))
+	{
+		printf("round trip: cannot load %s\n", kPath);
+		return false;
+	}
+	Draw(archived.get(), typeface);
+	if (!SamePixels(warm.get(), archived.get()))
+	{
+		printf("round trip: the archived strikes draw different pixels\n");
+		ok = false;
+	}
+	int created = typeface->TakeScalerContexts();
+	if (created)
+	{
+		printf("round trip: %d real scaler contexts created for archived glyphs\n", created);
+		ok = false;
+	}
+
+	// A glyph the archive lacks comes from a real scaler context
+	SkPaint paint;
+	paint.setTypeface(typeface);
+	paint.setTextSize(18);
+	warm->getCanvas()->drawText("#", 1, 10, 30, paint);
+	if (typeface->TakeScalerContexts() != 1)
+	{
+		printf("round trip: a glyph missing from the archive made no real scaler context\n");
+		ok = false;
+	}
+	SkStrikeArchive::Unload();
+	return ok;
+}
+
+static bool TestDamaged()
+{
+	bool ok = true;
+	std::vector<uint8_t> good;
+	if (!ReadFile(kPath, &good) || good.size() < sizeof(Header))
+	{
+		printf("damaged: cannot read %s\n", kPath);
+		return false;
+	}
+	const Header header = *At<Header>(good, 0);
+	if (header.fStrikeSize != sizeof(StrikeRecord) || header.fGlyphSize != sizeof(GlyphRecord) ||
+		header.fLength != good.size() || !header.fStrikeCount)
+	{
+		printf("damaged: the archive layout is not the one this test knows\n");
+		return false;
+	}
+
+	// The first strike and glyph, and a glyph with an archived path
+	const StrikeRecord strike = *At<StrikeRecord>(good, sizeof(Header));
+	size_t pathGlyph = 0;
+	for (uint32_t s = 0; s < header.fStrikeCount && !pathGlyph; s++)
+	{
+		const StrikeRecord &record = *At<StrikeRecord>(good, sizeof(Header) + s * sizeof(StrikeRecord));
+		for (uint32_t g = 0; g < record.fGlyphCount && !pathGlyph; g++)
+		{
+			size_t offset = record.fGlyphOffset + g * sizeof(GlyphRecord);
+			if (At<GlyphRecord>(good, offset)->fPathOffset)
+				pathGlyph = offset;
+		}
+	}
+	if (!pathGlyph)
+	{
+		printf("damaged: no glyph with an archived path\n");
+		return false;
+	}
+
+	struct Damage
+	{
+		const char *name;
+		void (*apply)(std::vector<uint8_t> &bytes, size_t strike, size_t glyph, size_t pathGlyph);
+	};
+	const Damage kDamages[] = {
+		{ "empty", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { b.clear(); } },
+		{ "short header", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { b.resize(sizeof(Header) - 1); } },
+		{ "truncated", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { b.resize(b.size() - 1); } },
+		{ "truncated with the length patched", [](std::vector<uint8_t> &b, size_t, size_t, size_t) {
+			b.resize(b.size() / 2);
+			At<Header>(b, 0)->fLength = b.size();
+		} },
+		{ "bad magic", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { b[0] ^= 1; } },
+		{ "another version", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { At<Header>(b, 0)->fVersion++; } },
+		{ "another rec size", [](std::vector<uint8_t> &b, size_t, size_t, size_t) { At<Header>(b, 0)->fRecSize += 4; } },
+		{ "too many strikes", [](std::vector<uint8_t> &b, size_t, size_t, size_t) {
+			At<Header>(b, 0)->fStrikeCount = 0x10000000;
+		} },
+		{ "bad descriptor checksum", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			*At<uint32_t>(b, At<StrikeRecord>(b, s)->fDescOffset) ^= 0x10;
+		} },
+		{ "descriptor changed under its checksum", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			b[At<StrikeRecord>(b, s)->fDescOffset + sizeof(SkDescriptor) + sizeof(SkDescriptor::Entry)] ^= 1;
+		} },
+		{ "descriptor past the end", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			At<StrikeRecord>(b, s)->fDescOffset = (uint32_t)SkAlign8(b.size());
+		} },
+		{ "oversized descriptor entry", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			// Checksum recomputed, so only the entry size is wrong
+			uint32_t offset = At<StrikeRecord>(b, s)->fDescOffset;
+			At<SkDescriptor::Entry>(b, offset + sizeof(SkDescriptor))->fLen += 8;
+			At<SkDescriptor>(b, offset)->computeChecksum();
+		} },
+		{ "misaligned glyphs", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			At<StrikeRecord>(b, s)->fGlyphOffset += 4;
+		} },
+		{ "too many glyphs", [](std::vector<uint8_t> &b, size_t s, size_t, size_t) {
+			At<StrikeRecord>(b, s)->fGlyphCount = 0x10000000;
+		} },
+		{ "unknown mask format", [](std::vector<uint8_t> &b, size_t, size_t g, size_t) {
+			At<GlyphRecord>(b, g)->fMaskFormat = SkMask::kCountMaskFormats;
+		} },
+		{ "unknown glyph flags", [](std::vector<uint8_t> &b, size_t, size_t g, size_t) {
+			At<GlyphRecord>(b, g)->fFlags = 0x8000;
+		} },
+		{ "just an advance, with a path", [](std::vector<uint8_t> &b, size_t, size_t, size_t p) {
+			At<GlyphRecord>(b, p)->fFlags = 1;
+		} },
+		{ "image past the end", [](std::vector<uint8_t> &b, size_t, size_t g, size_t) {
+			GlyphRecord *glyph = At<GlyphRecord>(b, g);
+			glyph->fWidth = glyph->fHeight = 4000;
+			glyph->fImageOffset = 8;
+		} },
+		{ "glyphs out of order", [](std::vector<uint8_t> &b, size_t, size_t g, size_t) {
+			At<GlyphRecord>(b, g + sizeof(GlyphRecord))->fPackedID = At<GlyphRecord>(b, g)->fPackedID;
+		} },
+		{ "path past the end", [](std::vector<uint8_t> &b, size_t, size_t, size_t p) {
+			At<GlyphRecord>(b, p)->fPathOffset = (uint32_t)b.size() - 4;
+		} },
+		{ "path offset out of range", [](std::vector<uint8_t> &b, size_t, size_t, size_t p) {
+			At<GlyphRecord>(b, p)->fPathOffset = 0xFFFFFFF0;
+		} },
+		{ "path size out of range", [](std::vector<uint8_t> &b, size_t, size_t, size_t p) {
+			At<GlyphRecord>(b, p)->fPathSize = 0xFFFFFFF0;
+		} },
+	};
+	if (strike.fGlyphCount < 2)
+	{
+		printf("damaged: the first strike has fewer than two glyphs\n");
+		return false;
+	}
+
+	for (const Damage &damage : kDamages)
+	{
+		std::vector<uint8_t> bytes = good;
+		damage.apply(bytes, sizeof(Header), strike.fGlyphOffset, pathGlyph);
+		if (!WriteFile(kDamagedPath, bytes))
+		{
+			printf("damaged: cannot write %s\n", kDamagedPath);
+			return false;
+		}
+		if (SkStrikeArchive::Load(kDamagedPath))
+		{
+			printf("damaged: loaded the archive with %s\n", damage.name);
+			ok = false;
+		}
+	}
+
+	// The untouched file still loads, through the same path
+	if (!WriteFile(kDamagedPath, good) || !SkStrikeArchive::Load(kDamagedPath))
+	{
+		printf("damaged: the untouched copy does not load\n");
+		ok = false;
+	}
+	SkStrikeArchive::Unload();
+	remove(kDamagedPath);
+	return ok;
+}
+
+int main()
+{
+	SkGraphics::Init();
+	sk_sp<CountingTypeface> typeface(new CountingTypeface(SkTypeface::MakeDefault()));
+	bool ok = TestRoundTrip(typeface);
+	ok &= TestDamaged();
+	remove(kPath);
+	printf("%s\n", ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SkCanvas.h"
+#include "SkExecutor.h"
+#include "SkGraphics.h"
+#include "SkPaint.h"
+#include "SkStrikeCache.h"
+#include "SkSurface.h"
+#include "SubtitleRenderer.h"
+
+// Prewarms known text through SkStrikeCache::PrewarmGlyphs on an executor
+// and checks that done() reports every distinct glyph resident, that drawing
+// the text afterwards adds nothing to the strike cache, and that fewer are
+// reported resident when the cache budget cannot hold them all. The same
+// no-growth check runs through SubtitleRenderer::PrewarmGlyphs.
+
+static const char kText[] = "The quick brown fox jumps over the lazy dog. 0123456789 "
+	"THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG! (again, again)";
+
+// Waits for the done callback of one prewarm request
+class DoneWaiter
+{
+public:
+	DoneWaiter() : fResident(-1), fCalls(0) {}
+
+	std::function<void(int)> Callback()
+	{
+		return [this](int resident)
+		{
+			std::lock_guard<std::mutex> lock(fMutex);
+			fResident = resident;
+			fCalls++;
+			fCond.notify_all();
+		};
+	}
+
+	int Wait()
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		fCond.wait(lock, [this] { return fCalls > 0; });
+		return fResident;
+	}
+
+	int Calls()
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		return fCalls;
+	}
+
+private:
+	std::mutex fMutex;
+	std::condition_variable fCond;
+	int fResident;
+	int fCalls;
+};
+
+static int DistinctGlyphs(const SkPaint &paint, const void *text, size_t byteLength)
+{
+	std::vector<SkGlyphID> glyphs(paint.textToGlyphs(text, byteLength, nullptr));
+	paint.textToGlyphs(text, byteLength, glyphs.data());
+	std::sort(glyphs.begin(), glyphs.end());
+	return (int)(std::unique(glyphs.begin(), glyphs.end()) - glyphs.begin());
+}
+
+// The flags a raster device without a linear color space draws text with
+static const SkScalerContextFlags kRasterFlags = SkScalerContextFlags::kFakeGammaAndBoostContrast;
+
+static bool TestPrewarmThenDraw(SkExecutor *executor, SkScalar textSize)
+{
+	bool ok = true;
+	sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(1600, 800);
+	SkPaint paint;
+	paint.setAntiAlias(true);
+	paint.setTextSize(textSize);
+	paint.setTextEncoding(SkPaint::kUTF8_TextEncoding);
+	size_t length = strlen(kText);
+	int distinct = DistinctGlyphs(paint, kText, length);
+
+	SkStrikeCache::PurgeAll();
+	DoneWaiter waiter;
+	SkStrikeCache::PrewarmGlyphs(paint, kText, length, &surface->props(), kRasterFlags,
+		SkMatrix::I(), executor, waiter.Callback());
+	int resident = waiter.Wait();
+	if (resident != distinct)
+	{
+		printf("size %g: %d resident, %d distinct glyphs\n", textSize, resident, distinct);
+		ok = false;
+	}
+
+	// Drawing at a translation uses the prewarmed strike and adds nothing
+	size_t bytes = SkGraphics::GetFontCacheUsed();
+	int strikes = SkGraphics::GetFontCacheCountUsed();
+	surface->getCanvas()->drawText(kText, length, 10.5f, textSize, paint);
+	if (SkGraphics::GetFontCacheUsed() != bytes || SkGraphics::GetFontCacheCountUsed() != strikes)
+	{
+		printf("size %g: the draw added %d bytes and %d strikes\n", textSize,
+			(int)(SkGraphics::GetFontCacheUsed() - bytes), SkGraphics::GetFontCacheCountUsed() - strikes);
+		ok = false;
+	}
+	if (waiter.Calls() != 1)
+	{
+		printf("size %g: done called %d times\n", textSize, waiter.Calls());
+		ok = false;
+	}
+	return ok;
+}
+
+static bool TestSmallBudget(SkExecutor *executor)
+{
+	// Large glyph images; the smallest budget the cache takes holds a few
+	bool ok = true;
+	size_t oldLimit = SkGraphics::SetFontCacheLimit(0);
+	sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(64, 64);
+	SkPaint paint;
+	paint.setAntiAlias(true);
+	paint.setTextSize(200);
+	paint.setTextEncoding(SkPaint::kUTF8_TextEncoding);
+	size_t length = strlen(kText);
+	int distinct = DistinctGlyphs(paint, kText, length);
+
+	SkStrikeCache::PurgeAll();
+	DoneWaiter waiter;
+	SkStrikeCache::PrewarmGlyphs(paint, kText, length, &surface->props(), kRasterFlags,
+		SkMatrix::I(), executor, waiter.Callback());
+	int resident = waiter.Wait();
+	if (resident < 0 || resident >= distinct)
+	{
+		printf("small budget: %d resident of %d distinct glyphs, expected fewer\n", resident, distinct);
+		ok = false;
+	}
+	if (SkGraphics::GetFontCacheUsed() > SkGraphics::GetFontCacheLimit())
+	{
+		printf("small budget: %zu bytes used, over the %zu limit\n", SkGraphics::GetFontCacheUsed(),
+			SkGraphics::GetFontCacheLimit());
+		ok = false;
+	}
+	SkGraphics::SetFontCacheLimit(oldLimit);
+	return ok;
+}
+
+static bool TestRenderer()
+{
+	// Strokes and fill of the default style, prewarmed by one renderer and
+	// drawn by another, as CaptionPrefetcher does
+	bool ok = true;
+	const std::wstring text = L"Anemone subtitle overlay, 0123456789 (prewarmed)";
+	SkImageInfo info = SkImageInfo::MakeN32Premul(4000, 200);
+	SubtitleRenderer prefetcher, renderer;
+	prefetcher.SetStyle(SubtitleStyle());
+	prefetcher.AttachLayers(info);
+	renderer.SetStyle(SubtitleStyle());
+	renderer.AttachLayers(info);
+
+	SkStrikeCache::PurgeAll();
+	prefetcher.PrewarmGlyphs(text);
+	size_t bytes = SkGraphics::GetFontCacheUsed();
+	if (!bytes || !renderer.RenderTextLayer(text))
+	{
+		printf("renderer: nothing prewarmed or rendered\n");
+		return false;
+	}
+	if (SkGraphics::GetFontCacheUsed() != bytes)
+	{
+		printf("renderer: drawing added %d bytes to %zu prewarmed\n",
+			(int)(SkGraphics::GetFontCacheUsed() - bytes), bytes);
+		ok = false;
+	}
+	return ok;
+}
+
+int main()
+{
+	SkGraphics::Init();
+	std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(2);
+	bool ok = true;
+
+	// Glyph images, then outlines past the largest size cached as images;
+	// on the executor and on the calling thread
+	const SkScalar kSizes[] = { 24, 300 };
+	for (SkScalar size : kSizes)
+	{
+		ok &= TestPrewarmThenDraw(executor.get(), size);
+		ok &= TestPrewarmThenDraw(nullptr, size);
+	}
+	ok &= TestSmallBudget(executor.get());
+	ok &= TestRenderer();
+
+	printf("%s\n", ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
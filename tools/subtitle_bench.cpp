@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SkGraphics.h"
+#include "SkUtils.h"
+#include "SubtitleRenderer.h"
+
+// Drives SubtitleRenderer the way PaintLoop does, into heap buffers instead
+// of a layered window, and reports how long each frame took and how many
+// bytes of the back buffer it recomposited.
+//
+//	subtitle_bench [--frames N] [--width W] [--height H] [--hold K] [--captions FILE]
+//
+// The text changes every K frames, as when captions follow a game, and the
+// title bar fades in and out in between, as when the cursor comes and goes.
+
+static const wchar_t *kSampleLines[] = {
+	L"\uC624\uB298\uC740 \uB0A0\uC528\uAC00 \uC815\uB9D0 \uC88B\uB124\uC694.",
+	L"\u3053\u3093\u306B\u3061\u306F\u3001\u4ECA\u65E5\u3082\u3088\u308D\u3057\u304F\u304A\u9858\u3044\u3057\u307E\u3059\u3002",
+	L"\uADF8\uB7EC\uB2C8\uAE4C \uC5B4\uC81C \uB9D0\uD55C \uADF8 \uC0AC\uB78C\uC774 \uBC14\uB85C \uB2F9\uC2E0\uC758 \uD615\uC774\uB77C\uB294 \uAC70\uC8E0? \uC815\uB9D0 \uBBFF\uC744 \uC218\uAC00 \uC5C6\uB124\uC694.",
+	L"Anemone overlay 0123456789 (ABC) [xyz] !?",
+	L"\u300C\u307E\u3060\u7D42\u308F\u3063\u3066\u3044\u306A\u3044\u300D\u3068\u5F7C\u5973\u306F\u8A00\u3063\u305F\u3002",
+	L"\uD55C \uC904\uC774 \uCC3D \uB108\uBE44\uBCF4\uB2E4 \uAE38\uC5B4\uC11C \uC5EC\uB7EC \uC904\uB85C \uB098\uB258\uC5B4\uC57C \uD558\uB294 \uC790\uB9C9\uC785\uB2C8\uB2E4. \uB2E4\uC74C \uC904\uAE4C\uC9C0 \uC774\uC5B4\uC9D1\uB2C8\uB2E4.",
+};
+
+static bool LoadCaptions(const char *path, std::vector<std::wstring> *lines)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+	std::string utf8;
+	while (std::getline(file, utf8))
+	{
+		if (!utf8.empty() && utf8.back() == '\r') utf8.pop_back();
+		if (utf8.empty()) continue;
+
+		std::wstring line;
+		const char *src = utf8.data();
+		const char *end = src + utf8.size();
+		while (src < end)
+		{
+			SkUnichar c = SkUTF8_NextUnicharWithError(&src, end);
+			if (c < 0) break;
+			if (sizeof(wchar_t) == 2 && c > 0xFFFF)
+			{
+				uint16_t pair[2];
+				SkUTF16_FromUnichar(c, pair);
+				line += (wchar_t)pair[0];
+				line += (wchar_t)pair[1];
+			}
+			else
+				line += (wchar_t)c;
+		}
+		lines->push_back(line);
+	}
+	return !lines->empty();
+}
+
+// Back buffer bytes the last Render recomposited
+static size_t TouchedBytes(const SubtitleRenderer &renderer, const SkImageInfo &info)
+{
+	const SkIRect &redraw = renderer.GetRedrawRect();
+	return (size_t)redraw.width() * redraw.height() * info.bytesPerPixel();
+}
+
+static double Percentile(const std::vector<double> &sorted, double p)
+{
+	size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char **argv)
+{
+	int frames = 5000;
+	int width = 800;
+	int height = 200;
+	int hold = 30;
+	const char *captions = nullptr;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--frames")) frames = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--width")) width = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--height")) height = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--hold")) hold = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--captions")) captions = argv[i + 1];
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (frames < 1 || width < 1 || height < 1 || hold < 1)
+	{
+		fprintf(stderr, "--frames, --width, --height and --hold must be positive\n");
+		return 2;
+	}
+
+	std::vector<std::wstring> lines;
+	if (captions && !LoadCaptions(captions, &lines))
+	{
+		fprintf(stderr, "cannot read captions from %s\n", captions);
+		return 1;
+	}
+	if (lines.empty())
+		lines.assign(std::begin(kSampleLines), std::end(kSampleLines));
+
+	SkGraphics::Init();
+
+	MemoryPresentBuffer buffer;
+	SkImageInfo info = SkImageInfo::MakeN32Premul(width, height);
+	if (!buffer.Resize(info))
+	{
+		fprintf(stderr, "cannot allocate %dx%d present buffers\n", width, height);
+		return 1;
+	}
+	SubtitleRenderer renderer;
+	renderer.SetStyle(SubtitleStyle());
+	if (!renderer.Attach(&buffer))
+	{
+		fprintf(stderr, "cannot attach the renderer\n");
+		return 1;
+	}
+
+	std::vector<double> times;
+	times.reserve(frames);
+	int drawn = 0;
+	double touchedTotal = 0;
+	const size_t fullFrame = info.computeMinByteSize();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		int line = (frame / hold) % (int)lines.size();
+		int phase = frame % hold;
+
+		SubtitleFrameState state;
+		// Up for the first half of each caption, back down for the second
+		state.fOpacity = std::min(255, std::max(0, 255 - std::abs(phase * 2 - hold) * 512 / hold));
+		state.fHoverMinimize = phase == hold / 3;
+		state.fHoverClose = phase == hold / 2;
+		state.fLine = line;
+		state.fLineCount = (int)lines.size();
+
+		auto start = std::chrono::steady_clock::now();
+		if (lines[line] != renderer.GetText())
+			renderer.SetText(lines[line]);
+		renderer.Render(state);
+		auto end = std::chrono::steady_clock::now();
+
+		times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+		if (!renderer.GetDamage().isEmpty())
+			drawn++;
+		touchedTotal += TouchedBytes(renderer, info);
+	}
+
+	// Hovering a button while the title bar is fully up recomposites the
+	// buttons only, once the frame before was a hover change too
+	SubtitleFrameState still;
+	still.fOpacity = 255;
+	still.fLine = 0;
+	still.fLineCount = (int)lines.size();
+	renderer.SetText(lines[0]);
+	size_t hoverBytes = 0;
+	for (int frame = 0; frame < 4; frame++)
+	{
+		still.fHoverMinimize = frame >= 2 && frame % 2 == 0;
+		renderer.Render(still);
+		hoverBytes = TouchedBytes(renderer, info);
+	}
+	bool hoverShrinks = hoverBytes > 0 && hoverBytes < fullFrame;
+
+	double total = 0;
+	for (double t : times)
+		total += t;
+	std::sort(times.begin(), times.end());
+	printf("%d frames at %dx%d, %d drawn, %zu captions held %d frames each\n",
+		frames, width, height, drawn, lines.size(), hold);
+	printf("frame time (us): mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+		total / frames, Percentile(times, 50), Percentile(times, 90), Percentile(times, 99),
+		Percentile(times, 99.9), times.back());
+	printf("bytes touched per drawn frame: mean %.0f, %.1f%% of a full frame (%zu)\n",
+		drawn ? touchedTotal / drawn : 0.0, drawn ? 100.0 * touchedTotal / drawn / fullFrame : 0.0, fullFrame);
+	printf("bytes touched by a hover change: %zu, %.1f%% of a full frame\n",
+		hoverBytes, 100.0 * hoverBytes / fullFrame);
+	if (!hoverShrinks)
+		printf("a hover change recomposited the whole frame\n");
+	return drawn > 0 && hoverShrinks ? 0 : 1;
+}
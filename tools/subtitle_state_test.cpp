@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SubtitleState.h"
+
+// Hammers SubtitleStateStore with several writers publishing, as the hook
+// threads do, while readers pin snapshots, as the paint and UI threads do.
+// Every snapshot read must be whole (its text matches its line), and once
+// the writers are done the store must hold the last state published. A
+// snapshot freed under a reader shows up as a torn or garbage state.
+//
+//	subtitle_state_test [--publishes N]
+
+static const int kWriters = 3;
+static const int kReaders = 4;
+
+// Long enough to live on the heap, so a freed snapshot doesn't read back intact
+static std::wstring LineText(int line)
+{
+	return L"자막 line " + std::to_wstring(line) + L" of the stress test, with some padding";
+}
+
+int main(int argc, char **argv)
+{
+	int publishes = 200000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--publishes")) publishes = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	SubtitleStateStore store;
+	std::atomic<bool> done(false);
+	std::atomic<long long> reads(0), bad(0);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < kReaders; r++)
+	{
+		readers.emplace_back([&] {
+			while (!done.load(std::memory_order_relaxed))
+			{
+				SubtitleStateStore::Reader state = store.Read();
+				reads++;
+				if (state->fLine < 0 ? !state->fText.empty() : state->fText != LineText(state->fLine))
+				{
+					if (bad++ < 5)
+						printf("line %d read as \"%ls\"\n", state->fLine, state->fText.c_str());
+				}
+			}
+		});
+	}
+
+	// Writer w publishes lines w, w + kWriters, ...; once all are done the
+	// selection is cleared
+	double worst = 0;
+	std::vector<std::thread> writers;
+	std::vector<double> slowest(kWriters);
+	for (int w = 0; w < kWriters; w++)
+	{
+		writers.emplace_back([&, w] {
+			for (int line = w; line < publishes; line += kWriters)
+			{
+				auto start = std::chrono::steady_clock::now();
+				store.Publish(LineText(line), line);
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				slowest[w] = std::max(slowest[w], ms);
+			}
+		});
+	}
+	for (std::thread &writer : writers)
+		writer.join();
+	store.Publish(SubtitleState());
+
+	done = true;
+	for (std::thread &reader : readers)
+		reader.join();
+	for (double ms : slowest)
+		worst = std::max(worst, ms);
+
+	bool cleared = store.Read()->fLine == -1 && store.Read()->fText.empty();
+	if (!cleared)
+		printf("last state published was not the one read back\n");
+
+	printf("%d publishes from %d writers, %lld reads from %d readers, %lld torn, slowest Publish() %.3f ms\n",
+		publishes, kWriters, (long long)reads, kReaders, (long long)bad, worst);
+	return !bad && cleared ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TextIngest.h"
+
+// Feeds TextIngest from a synthetic source as fast as it will take
+// snapshots: new lines arrive as bursts of noisy copies (CRLF or LF,
+// trailing blanks, blank lines around them), now and then going back to the
+// line on screen, the way a clipboard hook sees a game's text. Reports
+// snapshots and megabytes per second through normalize, hash and dedup, and
+// checks the counts and that the last line is the one published last.
+//
+//	text_ingest_bench [--snapshots N] [--debounce-us N]
+
+// Korean, Japanese, Latin and characters past the BMP
+static std::wstring Line(int n)
+{
+	static const wchar_t *kWords[] = { L"자막", L"오늘은", L"날씨가", L"字幕", L"ですね", L"Anemone",
+		L"translation", L"\U0001F600", L"\U00020B9F", L"—", L"line" };
+	std::wstring line;
+	for (int i = 0; i < 6 + n % 9; i++)
+	{
+		line += kWords[(n * 7 + i * 3) % (sizeof(kWords) / sizeof(kWords[0]))];
+		line += i % 4 == 3 ? L"\n" : L" ";
+	}
+	return line + std::to_wstring(n);
+}
+
+class SyntheticSource : public TextSource
+{
+public:
+	SyntheticSource(int snapshots) : fSnapshots(snapshots), fIndex(0), fBytes(0), fClosed(false), fDone(false) {}
+
+	bool Next(std::wstring *text) override
+	{
+		if (fClosed || fIndex >= fSnapshots)
+		{
+			fDone = true;
+			return false;
+		}
+		int i = fIndex++;
+		// Every fourth snapshot starts a new line; one burst in eight
+		// returns to the line before
+		int line = i / 4;
+		if (line % 8 == 7 && i % 4 == 3)
+			line--;
+		std::wstring noisy = Line(line);
+		switch (i % 4)
+		{
+		case 1:
+			for (size_t at = 0; (at = noisy.find(L'\n', at)) != std::wstring::npos; at += 2)
+				noisy.replace(at, 1, L"\r\n");
+			break;
+		case 2: noisy = L"\n  \n" + noisy + L"  \t"; break;
+		case 3: noisy += L"\u3000\n\n"; break;
+		}
+		fBytes += noisy.size() * sizeof(wchar_t);
+		fLast = Line(line);
+		text->swap(noisy);
+		return true;
+	}
+
+	void Close() override { fClosed = true; }
+
+	bool Done() const { return fDone; }
+	long long Bytes() const { return fBytes; }
+	const std::wstring &Last() const { return fLast; }
+
+private:
+	int fSnapshots;
+	int fIndex;
+	long long fBytes;
+	std::wstring fLast;
+	std::atomic<bool> fClosed;
+	std::atomic<bool> fDone;
+};
+
+int main(int argc, char **argv)
+{
+	int snapshots = 200000;
+	int debounceUs = 1000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--snapshots")) snapshots = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--debounce-us")) debounceUs = atoi(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	bool ok = true;
+	// wchar_t is 32 bits here; code units must not collide on their low 16 bits
+	if (sizeof(wchar_t) > 2 && TextIngest::Hash(L"\U0001F600") == TextIngest::Hash(L"\U0000F600"))
+	{
+		printf("Hash() drops the high bits of a code unit\n");
+		ok = false;
+	}
+
+	SyntheticSource *source = new SyntheticSource(snapshots);
+	TextIngest ingest(std::unique_ptr<TextSource>(source),
+		std::chrono::duration_cast<TextIngest::Clock::duration>(std::chrono::microseconds(debounceUs)));
+	std::mutex mutex;
+	std::wstring published;
+	bool normalized = true;
+	ingest.SetPublishCallback([&](const std::wstring &text) {
+		std::wstring again;
+		TextIngest::Normalize(text, &again);
+		std::lock_guard<std::mutex> lock(mutex);
+		normalized &= again == text;
+		published = text;
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	ingest.Start();
+	while (!source->Done())
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// The last line is published once the debounce window has passed
+	std::wstring expected;
+	TextIngest::Normalize(source->Last(), &expected);
+	for (int wait = 0; wait < 200; wait++)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (published == expected) break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ingest.Stop();
+
+	TextIngest::Stats stats = ingest.GetStats();
+	printf("%d snapshots in %.3f s: %.0f snapshots/s, %.1f MB/s\n", snapshots, seconds,
+		snapshots / seconds, source->Bytes() / seconds / 1e6);
+	printf("%llu received, %llu dropped, %llu published\n", (unsigned long long)stats.fReceived,
+		(unsigned long long)stats.fDropped, (unsigned long long)stats.fPublished);
+	if (stats.fReceived != (uint64_t)snapshots || stats.fDropped < (uint64_t)snapshots / 2 || !stats.fPublished)
+	{
+		printf("noisy copies of a line were not dropped\n");
+		ok = false;
+	}
+	if (published != expected || !normalized)
+	{
+		printf("the last line published is not the last line read, normalized\n");
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SkBitmap.h"
+#include "SkBlurImageFilter.h"
+#include "SkCanvas.h"
+#include "SkExecutor.h"
+#include "SkFontMgr.h"
+#include "SkGraphics.h"
+#include "SkImage.h"
+#include "SkMaskFilter.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkRRect.h"
+#include "SkSurface.h"
+#include "SkTextBlob.h"
+#include "SkTypeface.h"
+#include "SkVertices.h"
+
+// Draws the same scenes into SkSurface::MakeRasterThreaded and a plain
+// SkBitmapDevice surface and requires identical pixels, for several tile
+// counts, with and without an executor. Each scene is read back a different
+// way (readPixels, a snapshot, peekPixels), since each has to flush the
+// queued tiles first.
+
+static const int kWidth = 400;
+static const int kHeight = 300;
+
+struct Assets
+{
+	sk_sp<SkTypeface> typeface;
+	sk_sp<SkImage> image;
+};
+
+typedef void (*Scene)(SkCanvas *canvas, const Assets &assets, SkPaint &paint);
+
+static void DrawRect(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	canvas->clear(SK_ColorWHITE);
+	paint.setColor(SK_ColorRED);
+	canvas->drawRect({ 10, 10, 300, 200 }, paint);
+}
+
+static void DrawPath(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	SkPath path;
+	for (int i = 0; i < 40; i++)
+		path.lineTo(SkIntToScalar(i * 17 % 400), SkIntToScalar(i * 29 % 300));
+	paint.setColor(0x8000ff00);
+	canvas->drawPath(path, paint);
+}
+
+static void DrawStrokes(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeWidth(7);
+	canvas->drawOval({ 20, 30, 380, 270 }, paint);
+	canvas->drawRRect(SkRRect::MakeRectXY({ 50, 50, 350, 250 }, 30, 20), paint);
+}
+
+// Anti-aliased hairlines blend pixel pairs, which straddle tile edges
+static void DrawHairlines(SkCanvas *canvas, const Assets &assets, SkPaint &paint)
+{
+	SkPath star;
+	for (int i = 0; i < 40; i++)
+	{
+		SkScalar radius = SkIntToScalar(i & 1 ? 60 : 145);
+		star.lineTo(200 + radius * sinf(i * 0.157f), 150 + radius * cosf(i * 0.157f));
+	}
+	star.close();
+	paint.setStyle(SkPaint::kStroke_Style);
+	const SkColor colors[] = { 0x80ff0000, SK_ColorBLUE, SK_ColorBLACK };
+	const SkPaint::Cap caps[] = { SkPaint::kButt_Cap, SkPaint::kSquare_Cap, SkPaint::kRound_Cap };
+	for (int i = 0; i < 3; i++)
+	{
+		paint.setColor(colors[i]);
+		paint.setStrokeCap(caps[i]);
+		canvas->drawPath(star, paint);
+		canvas->rotate(3, 200, 150);
+	}
+	paint.setShader(assets.image->makeShader(SkShader::kRepeat_TileMode, SkShader::kRepeat_TileMode));
+	canvas->drawPath(star, paint);
+}
+
+static void DrawBlurMask(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, 6));
+	paint.setColor(SK_ColorBLUE);
+	canvas->drawCircle(200, 150, 90, paint);
+	SkPath path;
+	path.addCircle(100, 100, 60);
+	path.addRect({ 150, 150, 390, 290 });
+	canvas->drawPath(path, paint);
+}
+
+static void DrawText(SkCanvas *canvas, const Assets &assets, SkPaint &paint)
+{
+	paint.setTypeface(assets.typeface);
+	paint.setTextSize(40);
+	paint.setColor(SK_ColorBLACK);
+	canvas->drawString("Tiled text gjy", 10, 60, paint);
+
+	SkTextBlobBuilder builder;
+	paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+	const SkTextBlobBuilder::RunBuffer &run = builder.allocRunPosH(paint, 12, 150);
+	for (int i = 0; i < 12; i++)
+	{
+		run.glyphs[i] = (SkGlyphID)(36 + i);
+		run.pos[i] = SkIntToScalar(10 + i * 30);
+	}
+	paint.setTextEncoding(SkPaint::kUTF8_TextEncoding);
+	canvas->drawTextBlob(builder.make(), 0, 0, paint);
+
+	// Stroked, rotated glyphs straddle tile edges as paths
+	paint.setStyle(SkPaint::kStroke_Style);
+	paint.setStrokeWidth(4);
+	paint.setTextSize(70);
+	canvas->rotate(10);
+	canvas->drawString("Stroke", 40, 240, paint);
+}
+
+static void DrawLayerAlpha(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	SkPaint layer;
+	layer.setAlpha(128);
+	canvas->saveLayer(nullptr, &layer);
+	paint.setColor(SK_ColorMAGENTA);
+	canvas->drawRect({ 0, 0, 250, 250 }, paint);
+	paint.setColor(SK_ColorCYAN);
+	canvas->drawCircle(250, 150, 100, paint);
+	canvas->restore();
+}
+
+static void DrawFilteredLayer(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	SkPaint layer;
+	layer.setImageFilter(SkBlurImageFilter::Make(5, 5, nullptr));
+	canvas->saveLayer(nullptr, &layer);
+	paint.setColor(SK_ColorBLACK);
+	canvas->drawRect({ 100, 100, 300, 200 }, paint);
+	canvas->restore();
+}
+
+static void DrawImages(SkCanvas *canvas, const Assets &assets, SkPaint &)
+{
+	canvas->drawImage(assets.image, 15, 25);
+	SkPaint filtered;
+	filtered.setFilterQuality(kLow_SkFilterQuality);
+	canvas->drawImageRect(assets.image, SkRect::MakeXYWH(50, 40, 330, 250), &filtered);
+	canvas->translate(5, 7);
+	canvas->drawImage(assets.image, 100, 100, &filtered);
+}
+
+static void DrawImageShader(SkCanvas *canvas, const Assets &assets, SkPaint &paint)
+{
+	paint.setShader(assets.image->makeShader(SkShader::kRepeat_TileMode, SkShader::kMirror_TileMode));
+	paint.setFilterQuality(kLow_SkFilterQuality);
+	canvas->rotate(7);
+	canvas->clipRect({ 30, 30, 370, 270 }, true);
+	canvas->drawPaint(paint);
+}
+
+static void DrawVertices(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	SkPoint vertices[3] = { { 10, 10 }, { 390, 50 }, { 200, 290 } };
+	SkColor colors[3] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE };
+	canvas->drawVertices(SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, 3, vertices, nullptr, colors),
+		SkBlendMode::kSrcOver, paint);
+
+	SkPoint points[50];
+	for (int i = 0; i < 50; i++)
+		points[i] = { SkIntToScalar(i * 8), 150 + 100 * sinf((float)i) };
+	paint.setStrokeWidth(3);
+	canvas->drawPoints(SkCanvas::kPolygon_PointMode, 50, points, paint);
+}
+
+static void DrawClearLayer(SkCanvas *canvas, const Assets &, SkPaint &paint)
+{
+	SkPaint layer;
+	canvas->saveLayer(nullptr, &layer);
+	paint.setBlendMode(SkBlendMode::kClear);
+	canvas->drawCircle(200, 150, 60, paint);
+	canvas->restore();
+	// A backdrop filter reads what the tiles have drawn so far
+	canvas->saveLayer(SkCanvas::SaveLayerRec(nullptr, nullptr, SkBlurImageFilter::Make(3, 3, nullptr).get(), 0));
+	canvas->restore();
+}
+
+static void DrawFilteredImage(SkCanvas *canvas, const Assets &assets, SkPaint &)
+{
+	SkPaint filtered;
+	filtered.setImageFilter(SkBlurImageFilter::Make(4, 4, nullptr));
+	canvas->drawImage(assets.image, 40, 60, &filtered);
+}
+
+static const struct
+{
+	const char *name;
+	Scene draw;
+} kScenes[] = {
+	{ "rect", DrawRect },
+	{ "path", DrawPath },
+	{ "strokes", DrawStrokes },
+	{ "hairlines", DrawHairlines },
+	{ "blur mask", DrawBlurMask },
+	{ "text", DrawText },
+	{ "layer alpha", DrawLayerAlpha },
+	{ "filtered layer", DrawFilteredLayer },
+	{ "images", DrawImages },
+	{ "image shader", DrawImageShader },
+	{ "vertices", DrawVertices },
+	{ "clear layer", DrawClearLayer },
+	{ "filtered image", DrawFilteredImage },
+};
+
+static SkBitmap Allocate()
+{
+	SkBitmap bitmap;
+	bitmap.allocPixels(SkImageInfo::MakeN32Premul(kWidth, kHeight));
+	return bitmap;
+}
+
+// Prints the first mismatch and returns how many pixels differ
+static int Compare(const SkBitmap &expected, const SkBitmap &actual, const char *what)
+{
+	int differ = 0;
+	for (int y = 0; y < kHeight; y++)
+	{
+		for (int x = 0; x < kWidth; x++)
+		{
+			uint32_t a = *expected.getAddr32(x, y);
+			uint32_t b = *actual.getAddr32(x, y);
+			if (a == b) continue;
+			if (!differ)
+				printf("%s: first difference at %d,%d: %08x, threaded %08x\n", what, x, y, a, b);
+			differ++;
+		}
+	}
+	if (differ)
+		printf("%s: %d pixels differ\n", what, differ);
+	return differ;
+}
+
+static int CheckScenes(SkSurface *plain, SkSurface *threaded, const Assets &assets, const char *config)
+{
+	int failed = 0;
+	for (size_t i = 0; i < SK_ARRAY_COUNT(kScenes); i++)
+	{
+		for (SkSurface *surface : { plain, threaded })
+		{
+			// Half-transparent, so blending reads real destination values
+			surface->getCanvas()->clear(0x80c0d0e0);
+			SkPaint paint;
+			paint.setAntiAlias(true);
+			surface->getCanvas()->save();
+			kScenes[i].draw(surface->getCanvas(), assets, paint);
+			surface->getCanvas()->restore();
+		}
+
+		SkBitmap expected = Allocate();
+		SkBitmap actual = Allocate();
+		plain->readPixels(expected.pixmap(), 0, 0);
+		switch (i % 3)
+		{
+		case 0:
+			threaded->readPixels(actual.pixmap(), 0, 0);
+			break;
+		case 1:
+			threaded->makeImageSnapshot()->readPixels(actual.pixmap(), 0, 0);
+			break;
+		default:
+		{
+			SkPixmap pixmap;
+			if (threaded->peekPixels(&pixmap))
+				actual.writePixels(pixmap);
+			break;
+		}
+		}
+
+		char what[128];
+		snprintf(what, sizeof(what), "%s, %s", config, kScenes[i].name);
+		if (Compare(expected, actual, what))
+			failed++;
+	}
+	return failed;
+}
+
+// writePixels() lands after the draws queued before it, and a snapshot
+// keeps its pixels while drawing goes on (copy on write)
+static int CheckWritesAndSnapshots(SkSurface *plain, SkSurface *threaded, const char *config)
+{
+	SkBitmap patch;
+	patch.allocN32Pixels(50, 50);
+	patch.eraseColor(SK_ColorRED);
+	SkPaint paint;
+	paint.setColor(SK_ColorGREEN);
+
+	sk_sp<SkImage> before[2], after[2];
+	SkSurface *surfaces[2] = { plain, threaded };
+	for (int i = 0; i < 2; i++)
+	{
+		surfaces[i]->getCanvas()->drawRect({ 0, 0, kWidth, kHeight }, paint);
+		surfaces[i]->writePixels(patch, 30, 30);
+		before[i] = surfaces[i]->makeImageSnapshot();
+		surfaces[i]->getCanvas()->drawCircle(100, 100, 50, paint);
+		after[i] = surfaces[i]->makeImageSnapshot();
+	}
+
+	int failed = 0;
+	const char *names[2] = { "snapshot before draw", "snapshot after draw" };
+	sk_sp<SkImage> *pairs[2] = { before, after };
+	for (int i = 0; i < 2; i++)
+	{
+		SkBitmap expected = Allocate();
+		SkBitmap actual = Allocate();
+		pairs[i][0]->readPixels(expected.pixmap(), 0, 0);
+		pairs[i][1]->readPixels(actual.pixmap(), 0, 0);
+		char what[128];
+		snprintf(what, sizeof(what), "%s, %s", config, names[i]);
+		if (Compare(expected, actual, what))
+			failed++;
+	}
+	return failed;
+}
+
+int main()
+{
+	SkGraphics::Init();
+
+	Assets assets;
+	assets.typeface = SkFontMgr::RefDefault()->legacyMakeTypeface(nullptr, SkFontStyle());
+	if (!assets.typeface)
+		printf("no system font, text draws with the default typeface\n");
+	sk_sp<SkSurface> source = SkSurface::MakeRasterN32Premul(120, 90);
+	source->getCanvas()->clear(0xff336699);
+	SkPaint yellow;
+	yellow.setColor(SK_ColorYELLOW);
+	source->getCanvas()->drawCircle(60, 45, 40, yellow);
+	assets.image = source->makeImageSnapshot();
+
+	std::unique_ptr<SkExecutor> executor = SkExecutor::MakeWorkStealingThreadPool(3);
+	SkImageInfo info = SkImageInfo::MakeN32Premul(kWidth, kHeight);
+	int failed = 0, checks = 0;
+	for (int tiles : { 1, 3, 7 })
+	{
+		for (SkExecutor *exec : { (SkExecutor *)nullptr, executor.get() })
+		{
+			char config[64];
+			snprintf(config, sizeof(config), "%d tiles, %s", tiles, exec ? "executor" : "no executor");
+			sk_sp<SkSurface> plain = SkSurface::MakeRaster(info);
+			sk_sp<SkSurface> threaded = SkSurface::MakeRasterThreaded(info, tiles, exec);
+			if (!threaded)
+			{
+				printf("%s: MakeRasterThreaded failed\n", config);
+				failed++;
+				continue;
+			}
+			failed += CheckScenes(plain.get(), threaded.get(), assets, config);
+			failed += CheckWritesAndSnapshots(plain.get(), threaded.get(), config);
+			checks += SK_ARRAY_COUNT(kScenes) + 2;
+		}
+	}
+
+	printf("%d of %d checks failed\n", failed, checks);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TranslationPipeline.h"
+
+// Runs TranslationPipeline on a stub Translator whose calls can be held
+// open, and checks cache hits, that a newer Submit() drops a waiting text
+// and cancels a running one, and that nothing older than the latest
+// submitted text is delivered after it.
+
+static int gFailures = 0;
+
+static void Check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		gFailures++;
+	}
+}
+
+// Translates "x" to "[x]". Texts put on hold block until released; when
+// |honourCancel| is off they finish anyway, like an engine that can't be
+// interrupted.
+class StubTranslator : public Translator
+{
+public:
+	StubTranslator() : fHonourCancel(true) {}
+
+	bool Translate(const std::wstring &source, std::wstring *translation,
+		const std::atomic<bool> &cancelled) override
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		fCalls.push_back(source);
+		fChanged.notify_all();
+		while (fHeld.count(source))
+		{
+			if (fHonourCancel && cancelled.load())
+			{
+				fCancelled.push_back(source);
+				fChanged.notify_all();
+				return false;
+			}
+			fChanged.wait_for(lock, std::chrono::milliseconds(1));
+		}
+		*translation = L"[" + source + L"]";
+		return true;
+	}
+
+	void Hold(const std::wstring &source, bool honourCancel)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fHeld.insert(source);
+		fHonourCancel = honourCancel;
+	}
+
+	void Release(const std::wstring &source)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fHeld.erase(source);
+		fChanged.notify_all();
+	}
+
+	int Calls(const std::wstring &source)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		return (int)std::count(fCalls.begin(), fCalls.end(), source);
+	}
+
+	bool WasCancelled(const std::wstring &source)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		return std::count(fCancelled.begin(), fCancelled.end(), source) > 0;
+	}
+
+	bool WaitForCall(const std::wstring &source)
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		return fChanged.wait_for(lock, std::chrono::seconds(2), [&] {
+			return std::count(fCalls.begin(), fCalls.end(), source) > 0;
+		});
+	}
+
+	bool WaitForCancel(const std::wstring &source)
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		return fChanged.wait_for(lock, std::chrono::seconds(2), [&] {
+			return std::count(fCancelled.begin(), fCancelled.end(), source) > 0;
+		});
+	}
+
+private:
+	std::mutex fMutex;
+	std::condition_variable fChanged;
+	std::set<std::wstring> fHeld;
+	bool fHonourCancel;
+	std::vector<std::wstring> fCalls;
+	std::vector<std::wstring> fCancelled;
+};
+
+// What the overlay was told, in order: sources shown and results delivered
+class Screen
+{
+public:
+	void Source(const std::wstring &source)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		fShown.push_back(source);
+		fChanged.notify_all();
+	}
+
+	void Result(const std::wstring &source, const std::wstring &translation)
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		if (translation != L"[" + source + L"]")
+			printf("\"%ls\" delivered as \"%ls\"\n", source.c_str(), translation.c_str());
+		fShown.push_back(translation);
+		fChanged.notify_all();
+	}
+
+	bool WaitFor(const std::wstring &shown)
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		return fChanged.wait_for(lock, std::chrono::seconds(2), [&] {
+			return std::count(fShown.begin(), fShown.end(), shown) > 0;
+		});
+	}
+
+	std::vector<std::wstring> Shown()
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		return fShown;
+	}
+
+	std::wstring Last()
+	{
+		std::lock_guard<std::mutex> lock(fMutex);
+		return fShown.empty() ? std::wstring() : fShown.back();
+	}
+
+private:
+	std::mutex fMutex;
+	std::condition_variable fChanged;
+	std::vector<std::wstring> fShown;
+};
+
+int main()
+{
+	StubTranslator *stub = new StubTranslator;
+	TranslationPipeline pipeline(std::unique_ptr<Translator>(stub), 2, 16);
+	Screen screen;
+	pipeline.SetSourceCallback([&](const std::wstring &source) { screen.Source(source); });
+	pipeline.SetResultCallback([&](const std::wstring &source, const std::wstring &translation) {
+		screen.Result(source, translation);
+	});
+	pipeline.Start();
+
+	// A miss shows the source, then its translation; the repeat is a cache
+	// hit answered inside Submit() without calling the translator again
+	Check(!pipeline.Submit(L"a"), "first submit is a miss");
+	Check(screen.WaitFor(L"[a]"), "a is translated");
+	Check(pipeline.Submit(L"a"), "second submit is a hit");
+	Check(screen.Last() == L"[a]" && stub->Calls(L"a") == 1, "a hit is delivered at once from the cache");
+
+	// A newer text cancels the running one, which is never delivered
+	stub->Hold(L"slow", true);
+	pipeline.Submit(L"slow");
+	Check(stub->WaitForCall(L"slow"), "slow reaches the translator");
+	pipeline.Submit(L"b");
+	Check(stub->WaitForCancel(L"slow"), "slow is cancelled by b");
+	Check(screen.WaitFor(L"[b]"), "b is translated");
+
+	// With both workers busy, a waiting text is dropped for the newer one
+	stub->Hold(L"busy1", false);
+	stub->Hold(L"busy2", false);
+	pipeline.Submit(L"busy1");
+	stub->WaitForCall(L"busy1");
+	pipeline.Submit(L"busy2");
+	stub->WaitForCall(L"busy2");
+	pipeline.Submit(L"dropped");
+	pipeline.Submit(L"c");
+	// A cached text submitted while engines still run is shown at once...
+	Check(pipeline.Submit(L"a"), "a is still cached");
+	Check(screen.Last() == L"[a]", "a is shown while workers are busy");
+	// ...and the uninterruptible engines finishing later don't cover it
+	stub->Release(L"busy1");
+	stub->Release(L"busy2");
+	pipeline.Submit(L"d");
+	Check(screen.WaitFor(L"[d]"), "d is translated");
+	pipeline.Stop();
+
+	Check(stub->Calls(L"dropped") == 0 && stub->Calls(L"c") == 0, "texts superseded while waiting are never translated");
+	std::vector<std::wstring> shown = screen.Shown();
+	for (const wchar_t *stale : { L"[slow]", L"[busy1]", L"[busy2]", L"[dropped]", L"[c]" })
+		Check(std::find(shown.begin(), shown.end(), stale) == shown.end(), "superseded texts are never delivered");
+	Check(shown.back() == L"[d]", "the latest text is shown last");
+
+	// Results of superseded texts still fill the cache
+	pipeline.Start();
+	Check(pipeline.Submit(L"busy1"), "a superseded result is cached");
+	pipeline.Stop();
+
+	printf("%zu updates shown:", shown.size());
+	for (const std::wstring &text : shown)
+		printf(" %ls", text.c_str());
+	printf("\n%d failures\n", gFailures);
+	return gFailures ? 1 : 0;
+}